@@ -0,0 +1,29 @@
+# Calling from Julia an open interface for initial-value problems.
+#
+# Usage: julia --project=oif/lang_julia/OpenInterfaces examples/call_ivp_from_julia.jl [impl]
+# where `impl` is one of `scipy_ode_dopri5`, `sundials_cvode`, `jl_diffeq`.
+# The directory with `liboif_dispatch.so` must be in `LD_LIBRARY_PATH`.
+using OpenInterfaces
+
+function rhs(t, y, ydot, user_data)
+    ydot .= -y
+end
+
+function main()
+    impl = isempty(ARGS) ? "scipy_ode_dopri5" : ARGS[1]
+    println("Calling from Julia an open interface for initial-value problems")
+    println("Implementation: $impl")
+    s = IVP(impl)
+    t0 = 0.0
+    y0 = [1.0]
+    set_initial_value(s, y0, t0)
+    set_rhs_fn(s, rhs)
+
+    times = range(t0, t0 + 1, length=11)
+    for t in times[2:end]
+        integrate(s, t)
+        println(round(t, digits=3), " ", round(s.y[1], digits=6))
+    end
+end
+
+main()
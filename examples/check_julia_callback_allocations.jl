@@ -0,0 +1,45 @@
+# Check that calling a C right-hand side through `CallbackWrapper`
+# does not allocate in Julia.
+#
+# Run from the repository root:
+#     julia --project=oif/lang_julia/OpenInterfaces examples/check_julia_callback_allocations.jl
+# OrdinaryDiffEq must be available in the active environment.
+include(joinpath(@__DIR__, "..", "oif_impl", "lang_julia", "callback.jl"))
+
+using OpenInterfaces: OIFArrayF64, OIF_FLOAT64, OIF_ARRAY_F64, OIF_USER_DATA
+using OrdinaryDiffEq: ODEProblem, Tsit5, init, step!
+
+import .CallbackWrapper
+
+function rhs_c(t::Float64, y::Ptr{OIFArrayF64}, ydot::Ptr{OIFArrayF64}, user_data::Ptr{Cvoid})::Cint
+    oif_y = unsafe_load(y)
+    oif_ydot = unsafe_load(ydot)
+    n = unsafe_load(oif_y.dimensions)
+    for i in 1:n
+        unsafe_store!(oif_ydot.data, -unsafe_load(oif_y.data, i), i)
+    end
+    return 0
+end
+
+function main()
+    fn_c = @cfunction(rhs_c, Cint, (Float64, Ptr{OIFArrayF64}, Ptr{OIFArrayF64}, Ptr{Cvoid}))
+    wrapper = CallbackWrapper.make_wrapper_over_c_callback(
+        fn_c, Int32[OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA]
+    )
+
+    y = ones(100)
+    ydot = similar(y)
+    wrapper(0.0, y, ydot, C_NULL)
+    nbytes = @allocated wrapper(0.0, y, ydot, C_NULL)
+    println("Allocated by one call of the wrapper: $nbytes bytes")
+    nbytes == 0 || error("Wrapper over C callback allocates memory")
+
+    rhs(du, u, p, t) = wrapper(t, u, du, p)
+    integrator = init(ODEProblem(rhs, y, (0.0, Inf)), Tsit5(); save_everystep=false)
+    step!(integrator)
+    nbytes = @allocated step!(integrator)
+    println("Allocated by one step of the integrator: $nbytes bytes")
+    nbytes == 0 || error("Integrator step with wrapper over C callback allocates memory")
+end
+
+main()
@@ -0,0 +1,100 @@
+"""Measure fixed overhead of `IVP.integrate` calls for different implementations.
+
+The problem is the scalar ODE y' = -y, so that the time of each call
+is dominated by the cost of crossing language boundaries
+(argument conversion, method lookup, etc.) and not by the solver itself.
+Growth of the resident memory is reported as well against the number
+of calls made so far, which must stay flat for long runs;
+hence the default of a million calls.
+"""
+
+import argparse
+import time
+
+import numpy as np
+import psutil
+from oif.interfaces.ivp import IVP
+
+IMPL_LIST = ["scipy_ode_dopri5", "sundials_cvode", "jl_diffeq"]
+
+
+def _parse_args():
+    p = argparse.ArgumentParser()
+    p.add_argument(
+        "impl",
+        choices=IMPL_LIST,
+        nargs="*",
+        help="Implementations to measure (default: all)",
+    )
+    p.add_argument(
+        "--n_calls", default=1_000_000, type=int, help="Number of `integrate` calls"
+    )
+    p.add_argument("--n_runs", default=3, type=int, help="Number of runs")
+    p.add_argument(
+        "--n_checkpoints",
+        default=10,
+        type=int,
+        help="Number of times the RSS is recorded during a run",
+    )
+    return p.parse_args()
+
+
+def rhs(__, y, ydot, ___):
+    ydot[:] = -y
+
+
+def _run_once(impl, n_calls, n_checkpoints) -> tuple[float, list[tuple[int, int]]]:
+    s = IVP(impl)
+    s.set_initial_value(np.array([1.0]), 0.0)
+    s.set_rhs_fn(rhs)
+
+    dt = 1e-4
+    # Warm up: the first call includes compilation for JIT-based implementations.
+    s.integrate(dt)
+    process = psutil.Process()
+    begin_rss = process.memory_info().rss
+    rss_growth = []
+    chunk = max(n_calls // n_checkpoints, 1)
+    elapsed_time = 0.0
+    n_done = 0
+    while n_done < n_calls:
+        n_chunk = min(chunk, n_calls - n_done)
+        begin_time = time.perf_counter()
+        for i in range(n_done + 2, n_done + n_chunk + 2):
+            s.integrate(i * dt)
+        elapsed_time += time.perf_counter() - begin_time
+        n_done += n_chunk
+        # Reading the RSS is kept out of the timed loop.
+        rss_growth.append((n_done, process.memory_info().rss - begin_rss))
+
+    return elapsed_time / n_calls, rss_growth
+
+
+def main():
+    args = _parse_args()
+    impl_list = args.impl if args.impl else IMPL_LIST
+
+    print(f"Time per `integrate` call, n_calls = {args.n_calls}")
+    for impl in impl_list:
+        results = [
+            _run_once(impl, args.n_calls, args.n_checkpoints)
+            for __ in range(args.n_runs)
+        ]
+        times = [r[0] for r in results]
+        print(
+            "{:24s} {:10.3f} us (std {:.3f} us)".format(
+                impl, 1e6 * np.mean(times), 1e6 * np.std(times)
+            )
+        )
+        # The largest growth over the runs at each checkpoint.
+        for k, (n_done, __) in enumerate(results[0][1]):
+            rss_growth = max(r[1][k][1] for r in results)
+            print(
+                "    RSS growth after {:10d} calls {:10.1f} KiB".format(
+                    n_done, rss_growth / 1024
+                )
+            )
+
+
+if __name__ == "__main__":
+    main()
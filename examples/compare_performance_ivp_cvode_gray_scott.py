@@ -11,7 +11,7 @@ from oif.interfaces.ivp import IVP
 from oif.util import Laplacian2DApproximator
 from scikits.odes.ode import ode
 
-IMPL_LIST = ["sundials_cvode", "native_sundials_cvode"]
+IMPL_LIST = ["sundials_cvode", "sundials_cvode_numba_rhs", "native_sundials_cvode"]
 RESOLUTIONS = [64, 128, 256, 512]
 
 RESULT_SOLUTION_FILENAME_TPL = os.path.join("assets", "ivp_cvode_gs_soln_{}.pdf")
@@ -138,6 +138,82 @@ class GrayScottProblem:
         Udot[:] = Du * deltaU - U * V**2 + F * (1 - U)
         Vdot[:] = Dv * deltaV + U * V**2 - (F + k) * V
 
+    def make_compiled_rhs(self):
+        """Return the right-hand side compiled with Numba as a C function.
+
+        The returned `cfunc` has the signature of `oif_ivp_rhs_fn_t`,
+        so that C implementations call it directly, without entering
+        the Python interpreter.
+        """
+        import numba
+        from numba import types
+        from numba.core.extending import intrinsic
+
+        N = self.N
+        s = N**2
+        F, k, Du, Dv = self.F, self.k, self.Du, self.Dv
+        dx2, dy2 = self.dx**2, self.dy**2
+
+        # `OIFArrayF64` is `{int nd; intptr_t *dimensions; double *data}`.
+        # Numba records cannot hold pointers, so the pointers are declared
+        # as integers of the same size, and the record gets the C layout
+        # of the structure on the platform.
+        oif_array_t = types.Record.make_c_struct(
+            [("nd", types.intc), ("dimensions", types.uintp), ("data", types.uintp)]
+        )
+        oif_array_p = types.CPointer(oif_array_t)
+
+        @intrinsic
+        def as_float64_pointer(typingctx, address):
+            sig = types.CPointer(types.float64)(address)
+
+            def codegen(context, builder, signature, args):
+                ptr_type = context.get_value_type(signature.return_type)
+                return builder.inttoptr(args[0], ptr_type)
+
+            return sig, codegen
+
+        @numba.cfunc(
+            types.int32(types.float64, oif_array_p, oif_array_p, types.voidptr)
+        )
+        def rhs(t, y_p, ydot_p, user_data):
+            y_data = numba.carray(y_p, 1)[0].data
+            ydot_data = numba.carray(ydot_p, 1)[0].data
+            y = numba.carray(as_float64_pointer(y_data), (2 * s,))
+            ydot = numba.carray(as_float64_pointer(ydot_data), (2 * s,))
+            # Periodic 5-point Laplacian consistent with
+            # `Laplacian2DApproximator.laplacian_periodic`: the last row
+            # and column of the grid duplicate the first ones, so the
+            # stencil there is evaluated at the first row and column.
+            for i in range(N):
+                ii = i if i < N - 1 else 0
+                im = ii - 1 if ii > 0 else N - 2
+                ip = ii + 1
+                for j in range(N):
+                    jj = j if j < N - 1 else 0
+                    jm = jj - 1 if jj > 0 else N - 2
+                    jp = jj + 1
+                    # Same stencil in the corners as in `laplacian_periodic`.
+                    iym = N - 1 if ii == 0 and jj == 0 else im
+                    c = i * N + j
+                    cc = ii * N + jj
+                    u = y[c]
+                    v = y[s + c]
+                    uc = y[cc]
+                    vc = y[s + cc]
+                    lap_u = (y[ii * N + jm] - 2 * uc + y[ii * N + jp]) / dx2 + (
+                        y[iym * N + jj] - 2 * uc + y[ip * N + jj]
+                    ) / dy2
+                    lap_v = (y[s + ii * N + jm] - 2 * vc + y[s + ii * N + jp]) / dx2 + (
+                        y[s + iym * N + jj] - 2 * vc + y[s + ip * N + jj]
+                    ) / dy2
+                    uvv = u * v * v
+                    ydot[c] = Du * lap_u - uvv + F * (1 - u)
+                    ydot[s + c] = Dv * lap_v + uvv - (F + k) * v
+            return 0
+
+        return rhs
+
     def plot_2D_solution(
         self,
         y: np.ndarray,
@@ -391,6 +467,17 @@ def _run_once(args, N=512, tfinal=100, plot_solution=True) -> float:
         s.set_rhs_fn(problem.compute_rhs)
 
         soln = [problem.y0]
+        for t in times[1:]:
+            s.integrate(t)
+        y = s.y
+    elif impl == "sundials_cvode_numba_rhs":
+        # The right-hand side is compiled, so CVODE calls it directly
+        # as a C function and the interpreter is out of the loop.
+        rhs = problem.make_compiled_rhs()
+        s = IVP("sundials_cvode")
+        s.set_initial_value(problem.y0, problem.t0)
+        s.set_rhs_fn(rhs)
+
         for t in times[1:]:
             s.integrate(t)
         y = s.y
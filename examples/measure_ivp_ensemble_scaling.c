@@ -0,0 +1,143 @@
+/**
+ * Measure strong scaling of the `ivp_ensemble` interface with the number of threads.
+ *
+ * The ensemble consists of Van der Pol oscillators with different parameters,
+ * so that the cost of integration varies between the members
+ * and the threads must balance the load between them.
+ * The numbers of threads are powers of two and the number of processors.
+ */
+// Required for `sysconf`.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <oif/api.h>
+#include <oif/c_bindings.h>
+#include <oif/interfaces/ivp_ensemble.h>
+
+static double
+now_(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+// Van der Pol oscillator: y0' = y1, y1' = mu (1 - y0^2) y1 - y0.
+static int
+rhs(double t, OIFArrayF64 *y, OIFArrayF64 *ydot, void *user_data)
+{
+    (void)t; /* Unused */
+    double mu = *(double *)user_data;
+    ydot->data[0] = y->data[1];
+    ydot->data[1] = mu * (1.0 - y->data[0] * y->data[0]) * y->data[1] - y->data[0];
+    return 0;
+}
+
+static int
+run_(int M, int num_threads, double *elapsed)
+{
+    const int N = 2;
+    const double t_final = 10.0;
+    // Short integration before timing, as the thread pool is started on the first one.
+    const double t_warmup = 1e-3;
+
+    double *mu = malloc(sizeof(*mu) * M);
+    void **user_data = malloc(sizeof(*user_data) * M);
+    OIFArrayF64 *Y0 = oif_create_array_f64(2, (intptr_t[2]){M, N});
+    OIFArrayF64 *Y = oif_create_array_f64(2, (intptr_t[2]){M, N});
+    OIFArrayF64 *status = oif_create_array_f64(1, (intptr_t[1]){M});
+    for (int m = 0; m < M; ++m) {
+        mu[m] = 1.0 + 100.0 * m / M;
+        user_data[m] = &mu[m];
+        Y0->data[m * N] = 2.0;
+        Y0->data[m * N + 1] = 0.0;
+    }
+
+    int result = 1;
+    ImplHandle implh = oif_init_impl("ivp_ensemble", "sundials_cvode", 1, 0);
+    if (implh == OIF_IMPL_INIT_ERROR) {
+        fprintf(stderr, "Could not initialize implementation 'sundials_cvode'\n");
+        goto cleanup;
+    }
+    if (oif_ivp_ensemble_set_integrator(implh, "bdf") ||
+        oif_ivp_ensemble_set_initial_values(implh, Y0, 0.0) ||
+        oif_ivp_ensemble_set_rhs_fn(implh, rhs) ||
+        oif_ivp_ensemble_set_user_data(implh, user_data) ||
+        oif_ivp_ensemble_set_tolerances(implh, 1e-8, 1e-10) ||
+        oif_ivp_ensemble_set_num_threads(implh, num_threads)) {
+        fprintf(stderr, "Could not set up the ensemble\n");
+        goto unload;
+    }
+
+    if (oif_ivp_ensemble_integrate(implh, t_warmup, Y, status) ||
+        oif_ivp_ensemble_set_initial_values(implh, Y0, 0.0) ||
+        oif_ivp_ensemble_set_user_data(implh, user_data)) {
+        fprintf(stderr, "Warm-up integration failed\n");
+        goto unload;
+    }
+
+    double t0 = now_();
+    if (oif_ivp_ensemble_integrate(implh, t_final, Y, status)) {
+        fprintf(stderr, "Integration failed\n");
+        goto unload;
+    }
+    *elapsed = now_() - t0;
+    result = 0;
+
+unload:
+    oif_unload_impl(implh);
+cleanup:
+    oif_free_array_f64(status);
+    oif_free_array_f64(Y);
+    oif_free_array_f64(Y0);
+    free(user_data);
+    free(mu);
+    return result;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int M = 1024;
+    if (argc > 1) {
+        M = atoi(argv[1]);
+        if (M <= 0) {
+            fprintf(stderr, "USAGE: %s [number_of_members]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+
+    printf("Ensemble of %d Van der Pol oscillators, sundials_cvode\n", M);
+    printf("%8s %12s %8s %12s\n", "threads", "time, s", "speedup", "efficiency");
+    double elapsed_serial = 0.0;
+    for (int num_threads = 1;; num_threads *= 2) {
+        // The last point is always all processors, also when it is not a power of two.
+        if (num_threads > max_threads) {
+            num_threads = max_threads;
+        }
+        double elapsed;
+        if (run_(M, num_threads, &elapsed)) {
+            return EXIT_FAILURE;
+        }
+        if (num_threads == 1) {
+            elapsed_serial = elapsed;
+        }
+        double speedup = elapsed_serial / elapsed;
+        printf("%8d %12.4f %8.2f %12.2f\n", num_threads, elapsed, speedup,
+               speedup / num_threads);
+        if (num_threads == max_threads) {
+            break;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
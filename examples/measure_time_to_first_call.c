@@ -0,0 +1,135 @@
+/**
+ * Measure time to first call for implementations in Python.
+ *
+ * This includes bringing up the Python backend, importing the implementation
+ * module, and invoking one method of the interface.
+ * Subsequent loads of another implementation are measured separately
+ * as they should not pay for initialization of the backend again.
+ * For the IVP interface, the first call is the complete sequence
+ * of setting the initial value and the right-hand side and integrating
+ * once, so that the first invocation of the callback is included.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <oif/api.h>
+#include <oif/c_bindings.h>
+#include <oif/interfaces/ivp.h>
+#include <oif/interfaces/linsolve.h>
+#include <oif/interfaces/qeq.h>
+
+static double
+now_(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static int
+first_call_qeq(const char *impl, double *elapsed)
+{
+    double t0 = now_();
+    ImplHandle implh = oif_init_impl("qeq", impl, 1, 0);
+    if (implh == OIF_IMPL_INIT_ERROR) {
+        fprintf(stderr, "Could not initialize implementation '%s'\n", impl);
+        return 1;
+    }
+    OIFArrayF64 *roots = oif_create_array_f64(1, (intptr_t[1]){2});
+    int status = oif_solve_qeq(implh, 1.0, 5.0, 4.0, roots);
+    *elapsed = now_() - t0;
+
+    oif_free_array_f64(roots);
+    oif_unload_impl(implh);
+    return status;
+}
+
+static int
+first_call_linsolve(const char *impl, double *elapsed)
+{
+    double t0 = now_();
+    ImplHandle implh = oif_init_impl("linsolve", impl, 1, 0);
+    if (implh == OIF_IMPL_INIT_ERROR) {
+        fprintf(stderr, "Could not initialize implementation '%s'\n", impl);
+        return 1;
+    }
+    OIFArrayF64 *A =
+        oif_init_array_f64_from_data(2, (intptr_t[2]){2, 2}, (double[4]){1.0, 1.0, -3.0, 1.0});
+    OIFArrayF64 *b = oif_init_array_f64_from_data(1, (intptr_t[1]){2}, (double[2]){6.0, 2.0});
+    OIFArrayF64 *x = oif_create_array_f64(1, (intptr_t[1]){2});
+    int status = oif_solve_linear_system(implh, A, b, x);
+    *elapsed = now_() - t0;
+
+    oif_free_array_f64(x);
+    oif_free_array_f64(A);
+    oif_free_array_f64(b);
+    oif_unload_impl(implh);
+    return status;
+}
+
+static int
+rhs_(double t, OIFArrayF64 *y, OIFArrayF64 *rhs_out, void *user_data)
+{
+    (void)t;         /* Unused */
+    (void)user_data; /* Unused */
+    for (intptr_t i = 0; i < y->dimensions[0]; ++i) {
+        rhs_out->data[i] = -y->data[i];
+    }
+    return 0;
+}
+
+static int
+first_call_ivp(const char *impl, double *elapsed)
+{
+    double t0 = now_();
+    ImplHandle implh = oif_init_impl("ivp", impl, 1, 0);
+    if (implh == OIF_IMPL_INIT_ERROR) {
+        fprintf(stderr, "Could not initialize implementation '%s'\n", impl);
+        return 1;
+    }
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, (intptr_t[1]){2}, (double[2]){1.0, 2.0});
+    OIFArrayF64 *y = oif_create_array_f64(1, (intptr_t[1]){2});
+    int status = oif_ivp_set_initial_value(implh, y0, 0.0);
+    if (status == 0) {
+        status = oif_ivp_set_rhs_fn(implh, rhs_);
+    }
+    if (status == 0) {
+        status = oif_ivp_integrate(implh, 0.1, y);
+    }
+    *elapsed = now_() - t0;
+
+    oif_free_array_f64(y);
+    oif_free_array_f64(y0);
+    oif_unload_impl(implh);
+    return status;
+}
+
+int
+main(void)
+{
+    double elapsed;
+
+    if (first_call_qeq("py_qeq_solver", &elapsed)) {
+        return EXIT_FAILURE;
+    }
+    printf("qeq/py_qeq_solver, cold start:    %.3f ms\n", 1e3 * elapsed);
+
+    if (first_call_linsolve("numpy", &elapsed)) {
+        return EXIT_FAILURE;
+    }
+    printf("linsolve/numpy, warm backend:     %.3f ms\n", 1e3 * elapsed);
+
+    if (first_call_ivp("scipy_ode_dopri5", &elapsed)) {
+        return EXIT_FAILURE;
+    }
+    printf("ivp/scipy_ode_dopri5, cold start: %.3f ms\n", 1e3 * elapsed);
+
+    if (first_call_qeq("py_qeq_solver", &elapsed)) {
+        return EXIT_FAILURE;
+    }
+    printf("qeq/py_qeq_solver, reload:        %.3f ms\n", 1e3 * elapsed);
+
+    return EXIT_SUCCESS;
+}
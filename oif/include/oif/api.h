@@ -48,9 +48,13 @@ typedef struct {
 
 // This structure is used for callback functions.
 typedef struct {
-    int src;        // Language of the function (one of OIF_LANG_* constants)
-    void *fn_p_py;  // Function pointer in Python
-    void *fn_p_c;   // Function pointer in C
+    int src;                // Language of the function (one of OIF_LANG_* constants)
+    void *fn_p_py;          // Function pointer in Python
+    void *fn_p_c;           // Function pointer in C
+    unsigned int nargs;     // Number of function arguments
+    OIFArgType *arg_types;  // Types of the function arguments
+    OIFArgType restype;     // Type of the return value
+    void *fn_p_jl;          // Function object in Julia (`jl_value_t *`)
 } OIFCallback;
 
 /**
@@ -63,6 +67,7 @@ typedef struct {
     int src;   // Language of the data origin (one of `OIF_LANG_*` constants)
     void *c;   // Pointer to data in C
     void *py;  // Pointer to `PyObject` that holds the data in Python
+    void *jl;  // Pointer to `jl_value_t` that holds the data in Julia
 } OIFUserData;
 
 enum {
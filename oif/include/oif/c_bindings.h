@@ -21,6 +21,18 @@ oif_init_impl(const char *interface, const char *impl, int version_major, int ve
 int
 oif_unload_impl(ImplHandle implh);
 
+/**
+ * Start Julia from the given system image when the first Julia
+ * implementation is loaded.
+ *
+ * Equivalent to setting the environment variable `OIF_JULIA_SYSIMAGE`.
+ * Has no effect if a Julia implementation was already loaded.
+ * @param path Path to the system image, see `oif_impl/lang_julia/create_sysimage.jl`
+ * @return zero on success, non-zero otherwise
+ */
+int
+oif_set_julia_sysimage(const char *path);
+
 OIFArrayF64 *
 oif_create_array_f64(int nd, intptr_t *dimensions);
 
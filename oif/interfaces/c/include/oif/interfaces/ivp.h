@@ -8,6 +8,54 @@ extern "C" {
 
 typedef int (*oif_ivp_rhs_fn_t)(double, OIFArrayF64 *y, OIFArrayF64 *ydot, void *user_data);
 
+/**
+ * Signature of the function that writes the Jacobian df/dy(t, y)
+ * to the array `J` with shape (N, N) in row-major order.
+ */
+typedef int (*oif_ivp_jac_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *J, void *user_data);
+
+/**
+ * Signature of the function that writes the nonzero values of the Jacobian
+ * to the array `data` in the order of the CSR (compressed sparse row) pattern.
+ */
+typedef int (*oif_ivp_jac_csr_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *data,
+                                    void *user_data);
+
+/**
+ * Signature of the function that writes the Jacobian-vector product
+ * df/dy(t, y) v to the array `Jv`.
+ */
+typedef int (*oif_ivp_jac_times_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *v,
+                                      OIFArrayF64 *Jv, void *user_data);
+
+/**
+ * Signature of the function that prepares the preconditioner P ~ I - gamma df/dy(t, y).
+ *
+ * If `jok` is nonzero, the data computed from the Jacobian in the previous call
+ * may be reused, with only `gamma` updated.
+ */
+typedef int (*oif_ivp_prec_setup_fn_t)(double t, OIFArrayF64 *y, int jok, double gamma,
+                                       void *user_data);
+
+/**
+ * Signature of the function that solves P z = r approximately
+ * with the preconditioner P ~ I - gamma df/dy(t, y) and writes the solution to `z`.
+ *
+ * Iterative methods may use `delta` as the tolerance for the residual.
+ */
+typedef int (*oif_ivp_prec_solve_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *r,
+                                       OIFArrayF64 *z, double gamma, double delta,
+                                       void *user_data);
+
+/**
+ * Signature of the function that writes the values of the event functions
+ * g_i(t, y), i = 0, ..., n_events - 1, to `g`.
+ *
+ * An event occurs when one of them crosses zero.
+ */
+typedef int (*oif_ivp_event_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *g,
+                                  void *user_data);
+
 /**
  * Set right hand side of the system of ordinary differential equations.
  */
@@ -16,10 +64,109 @@ oif_ivp_set_rhs_fn(ImplHandle implh, oif_ivp_rhs_fn_t rhs);
 
 /**
  * Set initial value y(t0) = y0.
+ *
+ * If the number of equations changes, the Jacobian functions,
+ * the sparsity pattern, and the preconditioner set before are discarded,
+ * as they are specific to the size of the system.
  */
 int
 oif_ivp_set_initial_value(ImplHandle implh, OIFArrayF64 *y0, double t0);
 
+/**
+ * Set the function that computes the dense Jacobian of the right-hand side.
+ *
+ * Implicit integrators use it instead of finite-difference approximations.
+ * Must be called after `oif_ivp_set_initial_value`.
+ */
+int
+oif_ivp_set_jac_fn(ImplHandle implh, oif_ivp_jac_fn_t jac);
+
+/**
+ * Set the function that computes the sparse Jacobian of the right-hand side.
+ *
+ * The sparsity pattern is given in the CSR format for the matrix with `n` rows:
+ * column indices of the nonzeros in row `i` are
+ * `indices[indptr[i]]`, ..., `indices[indptr[i + 1] - 1]`.
+ * The pattern must have `indptr[0]` = 0, nondecreasing `indptr`,
+ * and column indices in [0, n); otherwise an error is returned.
+ * Must be called after `oif_ivp_set_initial_value`.
+ *
+ * Implementations without sparse linear solvers convert the Jacobian
+ * to a dense matrix: `sundials_cvode` factorizes it with KLU
+ * only if Sundials is built with KLU.
+ */
+int
+oif_ivp_set_jac_csr_fn(ImplHandle implh, oif_ivp_jac_csr_fn_t jac, intptr_t n,
+                       const intptr_t *indptr, const intptr_t *indices);
+
+/**
+ * Set the function that computes Jacobian-vector products,
+ * for use with matrix-free (iterative) linear solvers.
+ *
+ * Must be called after `oif_ivp_set_initial_value`.
+ */
+int
+oif_ivp_set_jac_times_fn(ImplHandle implh, oif_ivp_jac_times_fn_t jac_times);
+
+/**
+ * Set the preconditioner for matrix-free (iterative) linear solvers.
+ *
+ * The function `setup` is called when the integrator updates the preconditioner,
+ * which happens much less often than `solve` is called.
+ * The preconditioner is applied on the left.
+ * Must be called after `oif_ivp_set_initial_value`.
+ */
+int
+oif_ivp_set_preconditioner(ImplHandle implh, oif_ivp_prec_setup_fn_t setup,
+                           oif_ivp_prec_solve_fn_t solve);
+
+/**
+ * Set `n_events` event functions, whose zero crossings the solver locates
+ * during integration.
+ *
+ * Arrays `directions` and `terminal` have `n_events` elements.
+ * Event `i` occurs only when g_i increases through zero if `directions[i]` > 0,
+ * only when it decreases if `directions[i]` < 0, and in both cases if it is zero.
+ * If `terminal[i]` is nonzero, the integration stops at the event.
+ * Use `oif_ivp_get_last_event` to find out which event occurred and when.
+ * Zero `n_events` disables the events; then `event_fn`, `directions`,
+ * and `terminal` can be NULL.
+ * The event function receives the same user data as the right-hand side.
+ */
+int
+oif_ivp_set_events(ImplHandle implh, int n_events, oif_ivp_event_fn_t event_fn,
+                   OIFArrayF64 *directions, OIFArrayF64 *terminal);
+
+/**
+ * Get the event that occurred during the last call to an integration function.
+ *
+ * Writes the index of the event to `event_index` and the time at which it occurred
+ * to `t_event`; if a terminal event stopped the integration, it is this event.
+ * If no event occurred, `event_index` is -1 and `t_event` is NaN.
+ */
+int
+oif_ivp_get_last_event(ImplHandle implh, int *event_index, double *t_event);
+
+/**
+ * Indices of the statistics of the integrator in the array filled by
+ * `oif_ivp_get_stats`.
+ *
+ * Counters accumulate since the initial value was set; statistics
+ * that the implementation does not provide are NaN.
+ */
+enum {
+    OIF_IVP_STAT_NUM_STEPS = 0,            // Number of steps
+    OIF_IVP_STAT_NUM_RHS_EVALS,            // Number of right-hand side evaluations
+    OIF_IVP_STAT_NUM_NONLINEAR_ITERS,      // Number of nonlinear solver iterations
+    OIF_IVP_STAT_NUM_NONLINEAR_CONV_FAILS, // Number of nonlinear convergence failures
+    OIF_IVP_STAT_NUM_ERROR_TEST_FAILS,     // Number of steps rejected by the error test
+    OIF_IVP_STAT_NUM_JAC_EVALS,            // Number of Jacobian evaluations
+    OIF_IVP_STAT_LAST_STEP,                // Size of the last step
+    OIF_IVP_STAT_WORKSPACE_BYTES,          // Size of the workspace of the integrator
+    OIF_IVP_STAT_RHS_TIME,                 // Time spent in the right-hand side, seconds
+    OIF_IVP_NUM_STATS,
+};
+
 /**
  * Set user data that can be used to pass additional information
  * to the right-hand side function.
@@ -27,12 +174,115 @@ oif_ivp_set_initial_value(ImplHandle implh, OIFArrayF64 *y0, double t0);
 int
 oif_ivp_set_user_data(ImplHandle implh, void *user_data);
 
+/**
+ * Set relative and absolute tolerances.
+ */
+int
+oif_ivp_set_tolerances(ImplHandle implh, double rtol, double atol);
+
+/**
+ * Select the integrator (time-stepping method) by its name.
+ *
+ * Names are specific to the implementation,
+ * for example, "dopri5" or "dop853" for `scipy_ode_dopri5`,
+ * "adams" or "bdf" for `sundials_cvode`,
+ * and "Tsit5", "Rodas5" or "FBDF" for `jl_diffeq`.
+ */
+int
+oif_ivp_set_integrator(ImplHandle implh, const char *integrator_name);
+
+/**
+ * Set the implementation-specific option `name` to `value`.
+ *
+ * Options select and configure the solvers used by the integrator,
+ * for example, for `sundials_cvode`, `nonlinear_solver` ("fixed_point" or "newton"),
+ * `anderson_depth`, `linear_solver` ("dense", "band", "spgmr", "spbcgs" or "klu"),
+ * `upper_bandwidth` and `lower_bandwidth`, and `num_threads` for the vector
+ * operations of large systems.
+ * Numeric values are given as strings, for example, "3".
+ * Use `oif_ivp_print_options` to list the options supported by the implementation.
+ */
+int
+oif_ivp_set_option(ImplHandle implh, const char *name, const char *value);
+
+/**
+ * Print the supported options with their current and supported values.
+ */
+int
+oif_ivp_print_options(ImplHandle implh);
+
 /**
  * Integrate to time `t` and write the solution to `y`.
+ *
+ * If a terminal event occurs before `t`, the integration stops at the event,
+ * and `y` is the solution at the time of the event.
  */
 int
 oif_ivp_integrate(ImplHandle implh, double t, OIFArrayF64 *y);
 
+/**
+ * Integrate successively to each of the increasing `times`
+ * and write the solutions to the rows of `Y_out`.
+ *
+ * The array `Y_out` must have shape `(len(times), N)`,
+ * where `N` is the size of the system.
+ * Unlike calling `oif_ivp_integrate` in a loop, the implementation
+ * is invoked only once.
+ * If a terminal event stops the integration, the row for the first time
+ * after the event holds the solution at the event time,
+ * which `oif_ivp_get_last_event` returns, and the rows for the later times
+ * are filled with NaN.
+ */
+int
+oif_ivp_integrate_many(ImplHandle implh, const OIFArrayF64 *times, OIFArrayF64 *Y_out);
+
+/**
+ * Let the solver take one step of its own size towards `t_end`,
+ * but not beyond it.
+ *
+ * The reached time is written to `t` and the solution to `y`.
+ * Use `oif_ivp_interpolate` to obtain the solution within the step.
+ */
+int
+oif_ivp_integrate_one_step(ImplHandle implh, double t_end, double *t, OIFArrayF64 *y);
+
+/**
+ * Evaluate the solution at time `t` within the last step and write it to `y`.
+ *
+ * The solver evaluates its interpolant (dense output),
+ * so no additional evaluations of the right-hand side are required.
+ */
+int
+oif_ivp_interpolate(ImplHandle implh, double t, OIFArrayF64 *y);
+
+/**
+ * Write the statistics of the integrator to `stats` with `OIF_IVP_NUM_STATS`
+ * elements, indexed by the `OIF_IVP_STAT_*` constants.
+ */
+int
+oif_ivp_get_stats(ImplHandle implh, OIFArrayF64 *stats);
+
+/**
+ * Save the state of the integrator to the file `filename`.
+ *
+ * The state contains the current time, the solution, and the step size
+ * of the integrator, so that the integration can be resumed later,
+ * possibly in another process, with `oif_ivp_load_state`.
+ */
+int
+oif_ivp_save_state(ImplHandle implh, const char *filename);
+
+/**
+ * Resume the integration from the state saved to the file `filename`
+ * with `oif_ivp_save_state`.
+ *
+ * The right-hand side, the tolerances, and the other settings are not part
+ * of the state, so they must be set beforehand, along with an initial value
+ * of the same size, using the same implementation.
+ */
+int
+oif_ivp_load_state(ImplHandle implh, const char *filename);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,106 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <oif/api.h>
+#include <oif/interfaces/ivp.h>
+
+/**
+ * Interface for integrating an ensemble of M independent copies
+ * of the same system of ordinary differential equations y' = f(t, y)
+ * with different initial values and user data.
+ *
+ * The right-hand side has the same signature `oif_ivp_rhs_fn_t`
+ * as for the `ivp` interface and is called for one member at a time,
+ * possibly from several threads concurrently.
+ */
+
+/**
+ * Right-hand side of all members evaluated at once: writes f(t[m], Y[m, :])
+ * to `Ydot[m, :]` for m = 0, ..., M - 1.
+ *
+ * Arrays `Y` and `Ydot` have shape (M, N), and `t` has M elements,
+ * so that the function can process the whole batch with vectorized operations.
+ * Returns zero on success.
+ */
+typedef int (*oif_ivp_ensemble_rhs_batch_fn_t)(OIFArrayF64 *t, OIFArrayF64 *Y,
+                                               OIFArrayF64 *Ydot, void *user_data);
+
+/**
+ * Set initial values y_m(t0) = Y0[m, :] of all members.
+ *
+ * The array `Y0` has shape (M, N), where M is the number of members
+ * and N is the size of the system.
+ */
+int
+oif_ivp_ensemble_set_initial_values(ImplHandle implh, OIFArrayF64 *Y0, double t0);
+
+/**
+ * Set right hand side of the system of ordinary differential equations.
+ */
+int
+oif_ivp_ensemble_set_rhs_fn(ImplHandle implh, oif_ivp_rhs_fn_t rhs);
+
+/**
+ * Set the right-hand side that is evaluated for all members at once
+ * instead of the right-hand side set with `oif_ivp_ensemble_set_rhs_fn`.
+ *
+ * The function receives `user_data`, which is common for all members.
+ * Implementations may integrate the members in lockstep to evaluate
+ * the right-hand side once per stage of the method.
+ *
+ * Switching between this function and `oif_ivp_ensemble_set_rhs_fn`
+ * after `oif_ivp_ensemble_integrate` is an error, unless the initial values
+ * are set again with `oif_ivp_ensemble_set_initial_values`.
+ */
+int
+oif_ivp_ensemble_set_rhs_batch_fn(ImplHandle implh, oif_ivp_ensemble_rhs_batch_fn_t rhs,
+                                  void *user_data);
+
+/**
+ * Set user data of each member: the right-hand side of member `m`
+ * receives `user_data[m]`.
+ *
+ * The array `user_data` must have M elements; it is copied,
+ * but the objects it points to must stay alive.
+ * Must be called after `oif_ivp_ensemble_set_initial_values`.
+ */
+int
+oif_ivp_ensemble_set_user_data(ImplHandle implh, void **user_data);
+
+/**
+ * Set relative and absolute tolerances, the same for all members.
+ */
+int
+oif_ivp_ensemble_set_tolerances(ImplHandle implh, double rtol, double atol);
+
+/**
+ * Select the integrator (time-stepping method) by its name.
+ */
+int
+oif_ivp_ensemble_set_integrator(ImplHandle implh, const char *integrator_name);
+
+/**
+ * Set the number of threads that integrate the members in parallel.
+ *
+ * Zero selects the number of available processors.
+ */
+int
+oif_ivp_ensemble_set_num_threads(ImplHandle implh, int num_threads);
+
+/**
+ * Integrate all members to time `t` and write the solutions to the rows of `Y`
+ * with shape (M, N).
+ *
+ * The status of each member is written to `status` with M elements:
+ * zero on success and an implementation-specific error code otherwise,
+ * so that failing members do not prevent integration of the others.
+ */
+int
+oif_ivp_ensemble_integrate(ImplHandle implh, double t, OIFArrayF64 *Y, OIFArrayF64 *status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,5 @@
 #include "oif/dispatch_api.h"
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -9,7 +10,17 @@
 int
 oif_ivp_set_rhs_fn(ImplHandle implh, oif_ivp_rhs_fn_t rhs)
 {
-    OIFCallback rhs_wrapper = {.src = OIF_LANG_C, .fn_p_py = NULL, .fn_p_c = rhs};
+    static OIFArgType rhs_arg_types[] = {OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64,
+                                         OIF_USER_DATA};
+    OIFCallback rhs_wrapper = {
+        .src = OIF_LANG_C,
+        .fn_p_py = NULL,
+        .fn_p_c = rhs,
+        .nargs = sizeof(rhs_arg_types) / sizeof(rhs_arg_types[0]),
+        .arg_types = rhs_arg_types,
+        .restype = OIF_INT,
+        .fn_p_jl = NULL,
+    };
     OIFArgType in_arg_types[] = {OIF_CALLBACK};
     void *in_arg_values[] = {&rhs_wrapper};
     OIFArgs in_args = {
@@ -31,6 +42,235 @@ oif_ivp_set_rhs_fn(ImplHandle implh, oif_ivp_rhs_fn_t rhs)
     return status;
 }
 
+static int
+set_callback_(ImplHandle implh, const char *method, void *fn, unsigned int nargs,
+              OIFArgType *arg_types, OIFArrayF64 **extra_arrays, size_t num_extra_arrays)
+{
+    OIFCallback wrapper = {
+        .src = OIF_LANG_C,
+        .fn_p_py = NULL,
+        .fn_p_c = fn,
+        .nargs = nargs,
+        .arg_types = arg_types,
+        .restype = OIF_INT,
+        .fn_p_jl = NULL,
+    };
+    OIFArgType in_arg_types[3] = {OIF_CALLBACK, OIF_ARRAY_F64, OIF_ARRAY_F64};
+    void *in_arg_values[3] = {&wrapper};
+    assert(num_extra_arrays <= 2);
+    for (size_t i = 0; i < num_extra_arrays; ++i) {
+        in_arg_values[i + 1] = &extra_arrays[i];
+    }
+    OIFArgs in_args = {
+        .num_args = 1 + num_extra_arrays,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    return call_interface_impl(implh, method, &in_args, &out_args);
+}
+
+int
+oif_ivp_set_jac_fn(ImplHandle implh, oif_ivp_jac_fn_t jac)
+{
+    static OIFArgType jac_arg_types[] = {OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64,
+                                         OIF_USER_DATA};
+    return set_callback_(implh, "set_jac_fn", jac, 4, jac_arg_types, NULL, 0);
+}
+
+int
+oif_ivp_set_jac_csr_fn(ImplHandle implh, oif_ivp_jac_csr_fn_t jac, intptr_t n,
+                       const intptr_t *indptr, const intptr_t *indices)
+{
+    static OIFArgType jac_arg_types[] = {OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64,
+                                         OIF_USER_DATA};
+    int status = 1;
+    intptr_t nnz = indptr[n];
+    if (n < 0 || nnz < 0) {
+        fprintf(stderr, "[oif_ivp_set_jac_csr_fn] Invalid sparsity pattern\n");
+        return 1;
+    }
+    // The sparsity pattern is passed as arrays of floating-point numbers,
+    // which represent indices exactly.
+    double *indptr_f64 = malloc(sizeof(double) * (n + 1));
+    double *indices_f64 = malloc(sizeof(double) * (nnz + 1));
+    if (indptr_f64 == NULL || indices_f64 == NULL) {
+        fprintf(stderr, "[oif_ivp_set_jac_csr_fn] Could not allocate memory\n");
+        goto cleanup;
+    }
+    for (intptr_t i = 0; i <= n; ++i) {
+        indptr_f64[i] = (double)indptr[i];
+    }
+    for (intptr_t k = 0; k < nnz; ++k) {
+        indices_f64[k] = (double)indices[k];
+    }
+
+    intptr_t indptr_dims[] = {n + 1};
+    intptr_t indices_dims[] = {nnz};
+    OIFArrayF64 indptr_array = {.nd = 1, .dimensions = indptr_dims, .data = indptr_f64};
+    OIFArrayF64 indices_array = {.nd = 1, .dimensions = indices_dims, .data = indices_f64};
+    OIFArrayF64 *pattern[] = {&indptr_array, &indices_array};
+
+    status = set_callback_(implh, "set_jac_csr_fn", jac, 4, jac_arg_types, pattern, 2);
+
+cleanup:
+    free(indptr_f64);
+    free(indices_f64);
+    return status;
+}
+
+int
+oif_ivp_set_jac_times_fn(ImplHandle implh, oif_ivp_jac_times_fn_t jac_times)
+{
+    static OIFArgType jac_times_arg_types[] = {OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64,
+                                               OIF_ARRAY_F64, OIF_USER_DATA};
+    return set_callback_(implh, "set_jac_times_fn", jac_times, 5, jac_times_arg_types, NULL,
+                         0);
+}
+
+int
+oif_ivp_set_preconditioner(ImplHandle implh, oif_ivp_prec_setup_fn_t setup,
+                           oif_ivp_prec_solve_fn_t solve)
+{
+    static OIFArgType setup_arg_types[] = {OIF_FLOAT64, OIF_ARRAY_F64, OIF_INT, OIF_FLOAT64,
+                                           OIF_USER_DATA};
+    static OIFArgType solve_arg_types[] = {OIF_FLOAT64,   OIF_ARRAY_F64, OIF_ARRAY_F64,
+                                           OIF_ARRAY_F64, OIF_FLOAT64,   OIF_FLOAT64,
+                                           OIF_USER_DATA};
+    OIFCallback setup_wrapper = {
+        .src = OIF_LANG_C,
+        .fn_p_py = NULL,
+        .fn_p_c = setup,
+        .nargs = sizeof(setup_arg_types) / sizeof(setup_arg_types[0]),
+        .arg_types = setup_arg_types,
+        .restype = OIF_INT,
+        .fn_p_jl = NULL,
+    };
+    OIFCallback solve_wrapper = {
+        .src = OIF_LANG_C,
+        .fn_p_py = NULL,
+        .fn_p_c = solve,
+        .nargs = sizeof(solve_arg_types) / sizeof(solve_arg_types[0]),
+        .arg_types = solve_arg_types,
+        .restype = OIF_INT,
+        .fn_p_jl = NULL,
+    };
+    OIFArgType in_arg_types[] = {OIF_CALLBACK, OIF_CALLBACK};
+    void *in_arg_values[] = {&setup_wrapper, &solve_wrapper};
+    OIFArgs in_args = {
+        .num_args = 2,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    return call_interface_impl(implh, "set_preconditioner", &in_args, &out_args);
+}
+
+static int
+no_events_fn_(double t, OIFArrayF64 *y, OIFArrayF64 *g, void *user_data)
+{
+    (void)t;
+    (void)y;
+    (void)g;
+    (void)user_data;
+    return 0;
+}
+
+int
+oif_ivp_set_events(ImplHandle implh, int n_events, oif_ivp_event_fn_t event_fn,
+                   OIFArrayF64 *directions, OIFArrayF64 *terminal)
+{
+    static OIFArgType event_arg_types[] = {OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64,
+                                           OIF_USER_DATA};
+    OIFCallback event_wrapper = {
+        .src = OIF_LANG_C,
+        .fn_p_py = NULL,
+        .fn_p_c = (n_events == 0 && event_fn == NULL) ? no_events_fn_ : event_fn,
+        .nargs = sizeof(event_arg_types) / sizeof(event_arg_types[0]),
+        .arg_types = event_arg_types,
+        .restype = OIF_INT,
+        .fn_p_jl = NULL,
+    };
+    // Implementations in other languages expect a function and arrays,
+    // so dummy ones replace the missing ones when the events are disabled.
+    double empty_data[1];
+    OIFArrayF64 empty = {.nd = 1, .dimensions = (intptr_t[]){0}, .data = empty_data};
+    if (n_events == 0 && directions == NULL) {
+        directions = &empty;
+    }
+    if (n_events == 0 && terminal == NULL) {
+        terminal = &empty;
+    }
+
+    OIFArgType in_arg_types[] = {OIF_INT, OIF_CALLBACK, OIF_ARRAY_F64, OIF_ARRAY_F64};
+    void *in_arg_values[] = {&n_events, &event_wrapper, &directions, &terminal};
+    OIFArgs in_args = {
+        .num_args = 4,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    return call_interface_impl(implh, "set_events", &in_args, &out_args);
+}
+
+int
+oif_ivp_get_last_event(ImplHandle implh, int *event_index, double *t_event)
+{
+    OIFArgType in_arg_types[] = {};
+    void *in_arg_values[] = {};
+    OIFArgs in_args = {
+        .num_args = 0,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    // The index and the time are passed as an array with two elements,
+    // as implementations in other languages cannot write to scalar arguments.
+    double event[2];
+    intptr_t event_dims[] = {2};
+    OIFArrayF64 event_array = {.nd = 1, .dimensions = event_dims, .data = event};
+    OIFArrayF64 *event_array_p = &event_array;
+    OIFArgType out_arg_types[] = {OIF_ARRAY_F64};
+    void *out_arg_values[] = {&event_array_p};
+    OIFArgs out_args = {
+        .num_args = 1,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "get_last_event", &in_args, &out_args);
+    if (status == 0) {
+        *event_index = (int)event[0];
+        *t_event = event[1];
+    }
+
+    return status;
+}
+
 int
 oif_ivp_set_initial_value(ImplHandle implh, OIFArrayF64 *y0, double t0)
 {
@@ -62,6 +302,8 @@ oif_ivp_set_user_data(ImplHandle implh, void *user_data)
     OIFUserData oif_user_data = {
         .src = OIF_LANG_C,
         .c = user_data,
+        .py = NULL,
+        .jl = NULL,
     };
     void *in_arg_values[] = {&oif_user_data};
     size_t n = sizeof(in_arg_values) / sizeof(in_arg_values[0]);
@@ -84,6 +326,102 @@ oif_ivp_set_user_data(ImplHandle implh, void *user_data)
     return status;
 }
 
+int
+oif_ivp_set_tolerances(ImplHandle implh, double rtol, double atol)
+{
+    OIFArgType in_arg_types[] = {OIF_FLOAT64, OIF_FLOAT64};
+    void *in_arg_values[] = {&rtol, &atol};
+    OIFArgs in_args = {
+        .num_args = 2,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "set_tolerances", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_set_integrator(ImplHandle implh, const char *integrator_name)
+{
+    OIFArgType in_arg_types[] = {OIF_STR};
+    void *in_arg_values[] = {&integrator_name};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "set_integrator", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_set_option(ImplHandle implh, const char *name, const char *value)
+{
+    OIFArgType in_arg_types[] = {OIF_STR, OIF_STR};
+    void *in_arg_values[] = {&name, &value};
+    OIFArgs in_args = {
+        .num_args = 2,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "set_option", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_print_options(ImplHandle implh)
+{
+    OIFArgType in_arg_types[] = {};
+    void *in_arg_values[] = {};
+    OIFArgs in_args = {
+        .num_args = 0,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "print_options", &in_args, &out_args);
+
+    return status;
+}
+
 int
 oif_ivp_integrate(ImplHandle implh, double t, OIFArrayF64 *y)
 {
@@ -107,3 +445,152 @@ oif_ivp_integrate(ImplHandle implh, double t, OIFArrayF64 *y)
 
     return status;
 }
+
+int
+oif_ivp_integrate_many(ImplHandle implh, const OIFArrayF64 *times, OIFArrayF64 *Y_out)
+{
+    OIFArgType in_arg_types[] = {OIF_ARRAY_F64};
+    void *in_arg_values[] = {&times};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {OIF_ARRAY_F64};
+    void *out_arg_values[] = {&Y_out};
+    OIFArgs out_args = {
+        .num_args = 1,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "integrate_many", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_integrate_one_step(ImplHandle implh, double t_end, double *t, OIFArrayF64 *y)
+{
+    OIFArgType in_arg_types[] = {OIF_FLOAT64};
+    void *in_arg_values[] = {&t_end};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    // Implementations in other languages cannot write to scalar arguments,
+    // so the reached time is passed as an array with one element.
+    intptr_t t_dims[] = {1};
+    OIFArrayF64 t_array = {.nd = 1, .dimensions = t_dims, .data = t};
+    OIFArrayF64 *t_array_p = &t_array;
+    OIFArgType out_arg_types[] = {OIF_ARRAY_F64, OIF_ARRAY_F64};
+    void *out_arg_values[] = {&t_array_p, &y};
+    OIFArgs out_args = {
+        .num_args = 2,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "integrate_one_step", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_interpolate(ImplHandle implh, double t, OIFArrayF64 *y)
+{
+    OIFArgType in_arg_types[] = {OIF_FLOAT64};
+    void *in_arg_values[] = {&t};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {OIF_ARRAY_F64};
+    void *out_arg_values[] = {&y};
+    OIFArgs out_args = {
+        .num_args = 1,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "interpolate", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_save_state(ImplHandle implh, const char *filename)
+{
+    OIFArgType in_arg_types[] = {OIF_STR};
+    void *in_arg_values[] = {&filename};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "save_state", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_load_state(ImplHandle implh, const char *filename)
+{
+    OIFArgType in_arg_types[] = {OIF_STR};
+    void *in_arg_values[] = {&filename};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "load_state", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_get_stats(ImplHandle implh, OIFArrayF64 *stats)
+{
+    OIFArgType in_arg_types[] = {};
+    void *in_arg_values[] = {};
+    OIFArgs in_args = {
+        .num_args = 0,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {OIF_ARRAY_F64};
+    void *out_arg_values[] = {&stats};
+    OIFArgs out_args = {
+        .num_args = 1,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "get_stats", &in_args, &out_args);
+
+    return status;
+}
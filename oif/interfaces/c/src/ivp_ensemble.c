@@ -0,0 +1,221 @@
+#include "oif/dispatch_api.h"
+
+#include <oif/api.h>
+#include <oif/dispatch.h>
+#include <oif/interfaces/ivp_ensemble.h>
+
+int
+oif_ivp_ensemble_set_initial_values(ImplHandle implh, OIFArrayF64 *Y0, double t0)
+{
+    OIFArgType in_arg_types[] = {OIF_ARRAY_F64, OIF_FLOAT64};
+    void *in_arg_values[] = {&Y0, &t0};
+    OIFArgs in_args = {
+        .num_args = 2,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "set_initial_values", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_ensemble_set_rhs_fn(ImplHandle implh, oif_ivp_rhs_fn_t rhs)
+{
+    static OIFArgType rhs_arg_types[] = {OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64,
+                                         OIF_USER_DATA};
+    OIFCallback rhs_wrapper = {
+        .src = OIF_LANG_C,
+        .fn_p_py = NULL,
+        .fn_p_c = rhs,
+        .nargs = sizeof(rhs_arg_types) / sizeof(rhs_arg_types[0]),
+        .arg_types = rhs_arg_types,
+        .restype = OIF_INT,
+        .fn_p_jl = NULL,
+    };
+    OIFArgType in_arg_types[] = {OIF_CALLBACK};
+    void *in_arg_values[] = {&rhs_wrapper};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "set_rhs_fn", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_ensemble_set_rhs_batch_fn(ImplHandle implh, oif_ivp_ensemble_rhs_batch_fn_t rhs,
+                                  void *user_data)
+{
+    static OIFArgType rhs_arg_types[] = {OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_ARRAY_F64,
+                                         OIF_USER_DATA};
+    OIFCallback rhs_wrapper = {
+        .src = OIF_LANG_C,
+        .fn_p_py = NULL,
+        .fn_p_c = rhs,
+        .nargs = sizeof(rhs_arg_types) / sizeof(rhs_arg_types[0]),
+        .arg_types = rhs_arg_types,
+        .restype = OIF_INT,
+        .fn_p_jl = NULL,
+    };
+    OIFUserData oif_user_data = {.src = OIF_LANG_C, .c = user_data, .py = NULL, .jl = NULL};
+    OIFArgType in_arg_types[] = {OIF_CALLBACK, OIF_USER_DATA};
+    void *in_arg_values[] = {&rhs_wrapper, &oif_user_data};
+    OIFArgs in_args = {
+        .num_args = 2,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "set_rhs_batch_fn", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_ensemble_set_user_data(ImplHandle implh, void **user_data)
+{
+    // The implementation receives the array of pointers to the user data of the members.
+    OIFUserData oif_user_data = {.src = OIF_LANG_C, .c = user_data, .py = NULL, .jl = NULL};
+    OIFArgType in_arg_types[] = {OIF_USER_DATA};
+    void *in_arg_values[] = {&oif_user_data};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "set_user_data", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_ensemble_set_tolerances(ImplHandle implh, double rtol, double atol)
+{
+    OIFArgType in_arg_types[] = {OIF_FLOAT64, OIF_FLOAT64};
+    void *in_arg_values[] = {&rtol, &atol};
+    OIFArgs in_args = {
+        .num_args = 2,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "set_tolerances", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_ensemble_set_integrator(ImplHandle implh, const char *integrator_name)
+{
+    OIFArgType in_arg_types[] = {OIF_STR};
+    void *in_arg_values[] = {&integrator_name};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "set_integrator", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_ensemble_set_num_threads(ImplHandle implh, int num_threads)
+{
+    OIFArgType in_arg_types[] = {OIF_INT};
+    void *in_arg_values[] = {&num_threads};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {};
+    void *out_arg_values[] = {};
+    OIFArgs out_args = {
+        .num_args = 0,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    int status = call_interface_impl(implh, "set_num_threads", &in_args, &out_args);
+
+    return status;
+}
+
+int
+oif_ivp_ensemble_integrate(ImplHandle implh, double t, OIFArrayF64 *Y, OIFArrayF64 *status)
+{
+    OIFArgType in_arg_types[] = {OIF_FLOAT64};
+    void *in_arg_values[] = {&t};
+    OIFArgs in_args = {
+        .num_args = 1,
+        .arg_types = in_arg_types,
+        .arg_values = in_arg_values,
+    };
+
+    OIFArgType out_arg_types[] = {OIF_ARRAY_F64, OIF_ARRAY_F64};
+    void *out_arg_values[] = {&Y, &status};
+    OIFArgs out_args = {
+        .num_args = 2,
+        .arg_types = out_arg_types,
+        .arg_values = out_arg_values,
+    };
+
+    return call_interface_impl(implh, "integrate", &in_args, &out_args);
+}
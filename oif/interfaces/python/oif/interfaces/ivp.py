@@ -11,6 +11,21 @@ from oif.core import (
     unload_impl,
 )
 
+# Names of the statistics of the integrator returned by `IVP.get_stats`.
+# Counters are returned as integers.
+STATS = (
+    "num_steps",
+    "num_rhs_evals",
+    "num_nonlinear_iters",
+    "num_nonlinear_conv_fails",
+    "num_error_test_fails",
+    "num_jac_evals",
+    "last_step",
+    "workspace_bytes",
+    "rhs_time",
+)
+_FLOAT_STATS = ("last_step", "rhs_time")
+
 
 class IVP:
     def __init__(self, impl: str):
@@ -37,6 +52,137 @@ class IVP:
         )
         self._binding.call("set_rhs_fn", (self.wrapper,), ())
 
+    def set_jac_fn(self, jac_fn):
+        """Set function `jac_fn(t, y, J, user_data)` that writes df/dy to `J`.
+
+        Implicit integrators use it instead of finite-difference approximations.
+        """
+        if self.N <= 0:
+            raise RuntimeError("'set_initial_value' must be called before 'set_jac_fn'")
+
+        self.jac_wrapper = make_oif_callback(
+            jac_fn, (OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA), OIF_INT
+        )
+        self._binding.call("set_jac_fn", (self.jac_wrapper,), ())
+
+    def set_jac_csr_fn(self, jac_fn, indptr, indices):
+        """Set function `jac_fn(t, y, data, user_data)` for the sparse Jacobian.
+
+        The function writes the nonzero values of df/dy to `data`
+        in the order of the CSR (compressed sparse row) pattern
+        given by `indptr` and `indices`, as in `scipy.sparse.csr_matrix`.
+        Implementations without sparse linear solvers convert the Jacobian
+        to a dense matrix: `sundials_cvode` factorizes it with KLU
+        only if Sundials is built with KLU.
+        """
+        if self.N <= 0:
+            raise RuntimeError(
+                "'set_initial_value' must be called before 'set_jac_csr_fn'"
+            )
+
+        # Indices are passed as floating-point numbers that represent them exactly.
+        indptr = np.asarray(indptr, dtype=np.float64)
+        indices = np.asarray(indices, dtype=np.float64)
+        self.jac_wrapper = make_oif_callback(
+            jac_fn, (OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA), OIF_INT
+        )
+        self._binding.call("set_jac_csr_fn", (self.jac_wrapper, indptr, indices), ())
+
+    def set_jac_times_fn(self, jac_times_fn):
+        """Set function `jac_times_fn(t, y, v, Jv, user_data)` that writes df/dy v.
+
+        It is used by matrix-free (iterative) linear solvers.
+        """
+        if self.N <= 0:
+            raise RuntimeError(
+                "'set_initial_value' must be called before 'set_jac_times_fn'"
+            )
+
+        self.jac_wrapper = make_oif_callback(
+            jac_times_fn,
+            (OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA),
+            OIF_INT,
+        )
+        self._binding.call("set_jac_times_fn", (self.jac_wrapper,), ())
+
+    def set_preconditioner(self, setup_fn, solve_fn):
+        """Set the preconditioner P ~ I - gamma df/dy for matrix-free linear solvers.
+
+        Function `setup_fn(t, y, jok, gamma, user_data)` prepares the preconditioner;
+        if `jok` is nonzero, it may reuse the data computed from the Jacobian
+        in the previous call.
+        Function `solve_fn(t, y, r, z, gamma, delta, user_data)` solves P z = r
+        approximately and writes the solution to `z`.
+        """
+        if self.N <= 0:
+            raise RuntimeError(
+                "'set_initial_value' must be called before 'set_preconditioner'"
+            )
+
+        self.prec_setup_wrapper = make_oif_callback(
+            setup_fn,
+            (OIF_FLOAT64, OIF_ARRAY_F64, OIF_INT, OIF_FLOAT64, OIF_USER_DATA),
+            OIF_INT,
+        )
+        self.prec_solve_wrapper = make_oif_callback(
+            solve_fn,
+            (
+                OIF_FLOAT64,
+                OIF_ARRAY_F64,
+                OIF_ARRAY_F64,
+                OIF_ARRAY_F64,
+                OIF_FLOAT64,
+                OIF_FLOAT64,
+                OIF_USER_DATA,
+            ),
+            OIF_INT,
+        )
+        self._binding.call(
+            "set_preconditioner", (self.prec_setup_wrapper, self.prec_solve_wrapper), ()
+        )
+
+    def set_events(self, event_fn, directions, terminal):
+        """Set event functions, whose zero crossings are located during integration.
+
+        Function `event_fn(t, y, g, user_data)` writes the values of
+        the event functions g_i(t, y) to `g`, which has `len(directions)` elements.
+        Event `i` occurs only when g_i increases through zero if `directions[i]` > 0,
+        only when it decreases if `directions[i]` < 0, and in both cases if zero.
+        If `terminal[i]` is true, `integrate` stops at the event.
+        Use `get_last_event` to find out which event occurred and when.
+        """
+        if self.N <= 0:
+            raise RuntimeError("'set_initial_value' must be called before 'set_events'")
+
+        directions = np.asarray(directions, dtype=np.float64)
+        terminal = np.asarray(terminal, dtype=np.float64)
+        if directions.shape != terminal.shape or directions.ndim != 1:
+            raise ValueError(
+                "Arguments `directions` and `terminal` must have the same length"
+            )
+        self.event_wrapper = make_oif_callback(
+            event_fn,
+            (OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA),
+            OIF_INT,
+        )
+        self._binding.call(
+            "set_events",
+            (len(directions), self.event_wrapper, directions, terminal),
+            (),
+        )
+
+    def get_last_event(self):
+        """Return `(index, t)` of the event that occurred during the last integration.
+
+        If a terminal event stopped the integration, it is this event.
+        Returns None if no event occurred.
+        """
+        event = np.empty(2)
+        self._binding.call("get_last_event", (), (event,))
+        if event[0] < 0:
+            return None
+        return int(event[0]), event[1]
+
     def set_user_data(self, user_data: object):
         self.user_data = make_oif_user_data(user_data)
         self._binding.call("set_user_data", (self.user_data,), ())
@@ -44,9 +190,101 @@ class IVP:
     def set_tolerances(self, rtol: float, atol: float):
         self._binding.call("set_tolerances", (rtol, atol), ())
 
+    def set_integrator(self, integrator_name: str):
+        """Select the integrator (time-stepping method) by its name.
+
+        Names are specific to the implementation, for example,
+        "dopri5" or "dop853" for `scipy_ode_dopri5`,
+        "adams" or "bdf" for `sundials_cvode`,
+        and "Tsit5", "Rodas5" or "FBDF" for `jl_diffeq`.
+        """
+        self._binding.call("set_integrator", (integrator_name,), ())
+
+    def set_option(self, name: str, value):
+        """Set the implementation-specific option `name` to `value`.
+
+        Options select and configure the solvers used by the integrator,
+        for example, for `sundials_cvode`:
+        `nonlinear_solver` ("fixed_point" or "newton"), `anderson_depth`,
+        `linear_solver` ("dense", "band", "spgmr", "spbcgs" or "klu"),
+        `upper_bandwidth` and `lower_bandwidth`,
+        and `num_threads` for the vector operations of large systems.
+        Use `print_options` to list the options supported by the implementation.
+        """
+        self._binding.call("set_option", (name, str(value)), ())
+
+    def print_options(self):
+        """Print the supported options with their current and supported values."""
+        self._binding.call("print_options", (), ())
+
     def integrate(self, t):
         self._binding.call("integrate", (t,), (self.y,))
 
+    def integrate_many(self, times) -> np.ndarray:
+        """Integrate successively to each of `times` in one call to the implementation.
+
+        Returns the array with shape `(len(times), N)`,
+        whose rows are the solutions at the corresponding times.
+        After a terminal event, the row for the first time after the event
+        holds the solution at the event time, and the later rows are NaN.
+        """
+        times = np.asarray(times, dtype=np.float64)
+        Y = np.empty((len(times), self.N))
+        self._binding.call("integrate_many", (times,), (Y,))
+        return Y
+
+    def integrate_one_step(self, t_end) -> float:
+        """Let the solver take one step of its own size towards `t_end`.
+
+        The step does not go beyond `t_end`.
+        Returns the reached time; the solution is written to `self.y`.
+        """
+        t = np.empty(1)
+        self._binding.call("integrate_one_step", (float(t_end),), (t, self.y))
+        return t[0]
+
+    def interpolate(self, t) -> np.ndarray:
+        """Evaluate the solution at time `t` within the last step.
+
+        The solver evaluates its interpolant (dense output),
+        so no additional evaluations of the right-hand side are required.
+        """
+        y = np.empty(self.N)
+        self._binding.call("interpolate", (float(t),), (y,))
+        return y
+
+    def get_stats(self) -> dict:
+        """Return the statistics of the integrator as a dictionary.
+
+        Counters, such as "num_steps" and "num_rhs_evals", accumulate
+        since the initial value was set; see `STATS` for all names.
+        Only the statistics that the implementation provides are included.
+        """
+        stats = np.empty(len(STATS))
+        self._binding.call("get_stats", (), (stats,))
+        return {
+            name: value if name in _FLOAT_STATS else int(value)
+            for name, value in zip(STATS, stats)
+            if not np.isnan(value)
+        }
+
+    def save_state(self, filename: str):
+        """Save the state of the integrator to the file `filename`.
+
+        The state contains the current time, the solution, and the step size,
+        so that the integration can be resumed later with `load_state`.
+        """
+        self._binding.call("save_state", (str(filename),), ())
+
+    def load_state(self, filename: str):
+        """Resume the integration from the state saved with `save_state`.
+
+        The right-hand side, the tolerances, and the other settings
+        are not part of the state, so they must be set beforehand,
+        along with an initial value of the same size.
+        """
+        self._binding.call("load_state", (str(filename),), ())
+
     def print_stats(self):
         self._binding.call("print_stats", (), ())
 
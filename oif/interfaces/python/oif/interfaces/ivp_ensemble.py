@@ -0,0 +1,136 @@
+import ctypes
+
+import numpy as np
+from oif.core import (
+    OIF_ARRAY_F64,
+    OIF_FLOAT64,
+    OIF_INT,
+    OIF_LANG_C,
+    OIF_USER_DATA,
+    OIFPyBinding,
+    OIFUserData,
+    c_function_address,
+    init_impl,
+    make_oif_callback,
+    make_oif_user_data,
+    unload_impl,
+)
+
+
+class IVPEnsemble:
+    """Integrate an ensemble of M copies of the same ODE system in parallel.
+
+    Members differ in their initial values and user data.
+    The right-hand side `rhs_fn(t, y, ydot, user_data)` is the same as for `IVP`
+    and is called for one member at a time.
+    """
+
+    def __init__(self, impl: str):
+        self._binding: OIFPyBinding = init_impl("ivp_ensemble", impl, 1, 0)
+        self.M: int = 0
+        self.N: int = 0
+        self.Y: np.ndarray
+        self.status: np.ndarray
+        self._rhs_is_python = False
+
+    def set_initial_values(self, Y0, t0):
+        """Set initial values of the members from the rows of `Y0` (shape (M, N))."""
+        Y0 = np.ascontiguousarray(Y0, dtype=np.float64)
+        if Y0.ndim != 2:
+            raise ValueError("Initial values must be an array with shape (M, N)")
+        self.M, self.N = Y0.shape
+        self.Y = np.empty_like(Y0)
+        self.status = np.zeros(self.M)
+        self._binding.call("set_initial_values", (Y0, float(t0)), ())
+
+    def set_rhs_fn(self, rhs_fn):
+        """Set the right-hand side `rhs_fn(t, y, ydot, user_data)` of all members.
+
+        Python functions can be executed only by one thread at a time,
+        so the members are integrated sequentially, unless `rhs_fn`
+        is a compiled function (see `oif.core.CFunctionPointer`).
+        This includes `ctypes` function pointers created from Python callables.
+        """
+        if self.M <= 0:
+            raise RuntimeError(
+                "'set_initial_values' must be called before 'set_rhs_fn'"
+            )
+
+        self.wrapper = make_oif_callback(
+            rhs_fn, (OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA), OIF_INT
+        )
+        self._rhs_is_python = c_function_address(rhs_fn) is None
+        if self._rhs_is_python:
+            self._binding.call("set_num_threads", (1,), ())
+        self._binding.call("set_rhs_fn", (self.wrapper,), ())
+
+    def set_rhs_batch_fn(self, rhs_fn, user_data: object = None):
+        """Set the right-hand side `rhs_fn(t, Y, Ydot, user_data)` of all members.
+
+        The function writes f(t[m], Y[m, :]) to `Ydot[m, :]` for all members at once,
+        where `Y` and `Ydot` have shape (M, N), and `t` has M elements,
+        so that it can be vectorized, for example, with NumPy.
+        It receives `user_data`, which is common for all members,
+        and is used instead of the function set with `set_rhs_fn`.
+        Switching between the two after `integrate` requires calling
+        `set_initial_values` first.
+        """
+        if self.M <= 0:
+            raise RuntimeError(
+                "'set_initial_values' must be called before 'set_rhs_batch_fn'"
+            )
+
+        self.wrapper = make_oif_callback(
+            rhs_fn,
+            (OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA),
+            OIF_INT,
+        )
+        # The function is called once per stage from the calling thread only.
+        self._rhs_is_python = False
+        self._batch_user_data_object = user_data
+        self.batch_user_data = make_oif_user_data(user_data)
+        self._binding.call("set_rhs_batch_fn", (self.wrapper, self.batch_user_data), ())
+
+    def set_user_data(self, user_data: list):
+        """Set user data of each member: member `m` receives `user_data[m]`."""
+        if len(user_data) != self.M:
+            raise ValueError(f"User data must be given for each of {self.M} members")
+        # The implementation receives an array of pointers to the Python objects,
+        # which must be kept alive as long as they are in use.
+        self._user_data_objects = list(user_data)
+        self._user_data_array = (ctypes.c_void_p * self.M)(
+            *[id(obj) for obj in self._user_data_objects]
+        )
+        self.user_data = OIFUserData(
+            OIF_LANG_C, ctypes.addressof(self._user_data_array), None, None
+        )
+        self._binding.call("set_user_data", (self.user_data,), ())
+
+    def set_tolerances(self, rtol: float, atol: float):
+        self._binding.call("set_tolerances", (rtol, atol), ())
+
+    def set_integrator(self, integrator_name: str):
+        """Select the integrator by its name, for example, "adams" or "bdf"."""
+        self._binding.call("set_integrator", (integrator_name,), ())
+
+    def set_num_threads(self, num_threads: int):
+        """Set the number of threads; zero selects the number of processors."""
+        if self._rhs_is_python and num_threads != 1:
+            raise ValueError(
+                "Right-hand side implemented in Python requires one thread"
+            )
+        self._binding.call("set_num_threads", (int(num_threads),), ())
+
+    def integrate(self, t):
+        """Integrate all members to time `t`.
+
+        The solutions are written to the rows of `self.Y`.
+        Returns the number of members that failed;
+        the status of each member is in `self.status` (zero on success).
+        """
+        self._binding.call("integrate", (float(t),), (self.Y, self.status))
+        return int(np.count_nonzero(self.status))
+
+    def __del__(self):
+        if hasattr(self, "_binding"):
+            unload_impl(self._binding)
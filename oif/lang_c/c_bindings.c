@@ -1,6 +1,10 @@
+// Required for `setenv`.
+#define _POSIX_C_SOURCE 200112L
+
 #include "oif/dispatch_api.h"
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <oif/api.h>
@@ -18,6 +22,16 @@ oif_unload_impl(ImplHandle implh)
     return unload_interface_impl(implh);
 }
 
+int
+oif_set_julia_sysimage(const char *path)
+{
+    if (path == NULL) {
+        fprintf(stderr, "[oif_set_julia_sysimage] Path must not be NULL\n");
+        return 1;
+    }
+    return setenv("OIF_JULIA_SYSIMAGE", path, 1);
+}
+
 OIFArrayF64 *
 oif_create_array_f64(int nd, intptr_t *dimensions)
 {
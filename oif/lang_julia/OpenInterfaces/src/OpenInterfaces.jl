@@ -1,6 +1,32 @@
 module OpenInterfaces
 
-export OIFArrayF64
+export OIFArrayF64, ImplHandle, init_impl, unload_impl, call_impl
+export IVP, LinearSolver, QeqSolver
+export set_initial_value, set_rhs_fn, set_user_data, set_tolerances, set_integrator
+export set_option, set_preconditioner, set_events, get_last_event, print_options
+export integrate, integrate_many, integrate_one_step, interpolate, save_state, load_state
+export get_stats, print_stats, solve
+
+# Handle to an instantiated implementation.
+const ImplHandle = Cint
+
+const OIFArgType = Cint
+const OIF_INT = OIFArgType(1)
+const OIF_FLOAT64 = OIFArgType(3)
+const OIF_ARRAY_F64 = OIFArgType(5)
+const OIF_STR = OIFArgType(6)
+const OIF_CALLBACK = OIFArgType(7)
+const OIF_USER_DATA = OIFArgType(8)
+
+const OIF_LANG_C = Cint(1)
+const OIF_LANG_CXX = Cint(2)
+const OIF_LANG_PYTHON = Cint(3)
+const OIF_LANG_JULIA = Cint(4)
+const OIF_LANG_R = Cint(5)
+
+# Library that dispatches calls to implementations in different languages.
+# It must be on the search path of the dynamic loader.
+const LIBOIF_DISPATCH = "liboif_dispatch"
 
 struct OIFArrayF64
     nd::Int32
@@ -8,4 +34,119 @@ struct OIFArrayF64
     data::Ptr{Float64}
 end
 
+struct OIFArgs
+    num_args::Csize_t
+    arg_types::Ptr{OIFArgType}
+    arg_values::Ptr{Ptr{Cvoid}}
+end
+
+struct OIFCallback
+    src::Cint
+    fn_p_py::Ptr{Cvoid}
+    fn_p_c::Ptr{Cvoid}
+    nargs::Cuint
+    arg_types::Ptr{OIFArgType}
+    restype::OIFArgType
+    fn_p_jl::Ptr{Cvoid}
+end
+
+struct OIFUserData
+    src::Cint
+    c::Ptr{Cvoid}
+    py::Ptr{Cvoid}
+    jl::Ptr{Cvoid}
+end
+
+"""
+    init_impl(interface::String, impl::String, major::Integer, minor::Integer)::ImplHandle
+
+Load implementation `impl` of the interface `interface`.
+"""
+function init_impl(interface::String, impl::String, major::Integer, minor::Integer)::ImplHandle
+    implh = @ccall LIBOIF_DISPATCH.load_interface_impl(
+        interface::Cstring, impl::Cstring, major::Csize_t, minor::Csize_t
+    )::ImplHandle
+    if implh < 0
+        error(
+            "Error occurred during initialization of the implementation " *
+            "'$impl' for the interface '$interface'"
+        )
+    end
+    return implh
+end
+
+function unload_impl(implh::ImplHandle)::Nothing
+    status = @ccall LIBOIF_DISPATCH.unload_interface_impl(implh::ImplHandle)::Cint
+    if status != 0
+        error("Could not unload implementation with handle $implh correctly")
+    end
+    return nothing
+end
+
+"""
+    call_impl(implh::ImplHandle, method::String, in_args::Tuple, out_args::Tuple)
+
+Invoke `method` of the implementation `implh`.
+
+Arrays are passed without copying.  As Julia arrays are stored in column-major
+order, while implementations expect row-major order, the dimensions of arrays
+are passed in reverse order, that is, implementations see transposed arrays.
+"""
+function call_impl(implh::ImplHandle, method::String, in_args::Tuple, out_args::Tuple)::Nothing
+    # Objects referenced by the pointers in `in_values` and `out_values`.
+    keep = Any[]
+    in_types, in_values = _pack_args(in_args, keep)
+    out_types, out_values = _pack_args(out_args, keep)
+
+    status = GC.@preserve keep in_types in_values out_types out_values begin
+        in_packed = Ref(OIFArgs(length(in_args), pointer(in_types), pointer(in_values)))
+        out_packed = Ref(OIFArgs(length(out_args), pointer(out_types), pointer(out_values)))
+        @ccall LIBOIF_DISPATCH.call_interface_impl(
+            implh::ImplHandle,
+            method::Cstring,
+            in_packed::Ptr{OIFArgs},
+            out_packed::Ptr{OIFArgs},
+        )::Cint
+    end
+
+    if status != 0
+        error("Error occurred while executing method '$method'")
+    end
+    return nothing
+end
+
+function _pack_args(args::Tuple, keep::Vector{Any})
+    types = Vector{OIFArgType}(undef, length(args))
+    values = Vector{Ptr{Cvoid}}(undef, length(args))
+    for (i, arg) in enumerate(args)
+        types[i], ref = _to_oif_arg(arg, keep)
+        push!(keep, ref)
+        values[i] = Base.unsafe_convert(Ptr{Cvoid}, ref)
+    end
+    return types, values
+end
+
+_to_oif_arg(x::Integer, keep) = OIF_INT, Ref{Cint}(x)
+_to_oif_arg(x::AbstractFloat, keep) = OIF_FLOAT64, Ref{Float64}(x)
+_to_oif_arg(x::OIFCallback, keep) = OIF_CALLBACK, Ref(x)
+_to_oif_arg(x::OIFUserData, keep) = OIF_USER_DATA, Ref(x)
+
+function _to_oif_arg(x::String, keep)
+    push!(keep, x)
+    return OIF_STR, Ref{Ptr{UInt8}}(pointer(x))
+end
+
+function _to_oif_arg(x::Array{Float64}, keep)
+    dims = Int64[reverse(size(x))...]
+    arr = Ref(OIFArrayF64(ndims(x), pointer(dims), pointer(x)))
+    push!(keep, x, dims, arr)
+    return OIF_ARRAY_F64, Ref(Base.unsafe_convert(Ptr{OIFArrayF64}, arr))
+end
+
+_to_oif_arg(x, keep) = throw(ArgumentError("Cannot convert argument $x of type $(typeof(x))"))
+
+include("interfaces/ivp.jl")
+include("interfaces/linear_solver.jl")
+include("interfaces/qeq_solver.jl")
+
 end # module OpenInterfaces
@@ -0,0 +1,389 @@
+const RHS_ARG_TYPES = [OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA]
+const PREC_SETUP_ARG_TYPES = [OIF_FLOAT64, OIF_ARRAY_F64, OIF_INT, OIF_FLOAT64, OIF_USER_DATA]
+const PREC_SOLVE_ARG_TYPES = [
+    OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_FLOAT64, OIF_FLOAT64,
+    OIF_USER_DATA,
+]
+# Names of the statistics of the integrator returned by `get_stats`.
+const IVP_STATS = (
+    "num_steps", "num_rhs_evals", "num_nonlinear_iters", "num_nonlinear_conv_fails",
+    "num_error_test_fails", "num_jac_evals", "last_step", "workspace_bytes", "rhs_time",
+)
+
+"""
+    IVP(impl::String)
+
+Solver for initial-value problems for ordinary differential equations
+``dy/dt = f(t, y)``, provided by the implementation `impl`.
+"""
+mutable struct IVP
+    implh::ImplHandle
+    N::Int
+    y0::Vector{Float64}
+    y::Vector{Float64}
+    user_data
+    # Keep the callback, its compiled wrapper and user data alive,
+    # while the implementation holds pointers to them.
+    rhs_fn::Base.RefValue{Any}
+    rhs_fn_c::Union{Nothing,Base.CFunction}
+    callback::Union{Nothing,OIFCallback}
+    user_data_ref::Base.RefValue{Any}
+    # The same for the preconditioner and event functions.
+    preconditioner::Vector{Any}
+    events::Vector{Any}
+    function IVP(impl::String)
+        self = new(
+            init_impl("ivp", impl, 1, 0), 0, [], [], nothing,
+            Ref{Any}(nothing), nothing, nothing, Ref{Any}(nothing), [], [],
+        )
+        finalizer(self) do s
+            unload_impl(s.implh)
+        end
+        return self
+    end
+end
+
+function set_initial_value(self::IVP, y0::AbstractVector{<:Real}, t0::Real)
+    self.y0 = Vector{Float64}(y0)
+    self.y = similar(self.y0)
+    self.N = length(self.y0)
+    call_impl(self.implh, "set_initial_value", (self.y0, Float64(t0)), ())
+end
+
+"""
+    set_rhs_fn(self::IVP, rhs_fn)
+
+Set the right-hand side `rhs_fn(t, y, ydot, user_data)` of the system,
+that writes ``f(t, y)`` to `ydot`.
+
+The function is compiled to a C function with `@cfunction`,
+so that implementations invoke it without converting the arguments.
+Julia implementations receive the function itself instead.
+"""
+function set_rhs_fn(self::IVP, rhs_fn)
+    if self.N <= 0
+        error("'set_initial_value' must be called before 'set_rhs_fn'")
+    end
+
+    function wrapper(t::Float64, y::Ptr{OIFArrayF64}, ydot::Ptr{OIFArrayF64}, ::Ptr{Cvoid})::Cint
+        try
+            rhs_fn(t, _wrap_oif_array(y), _wrap_oif_array(ydot), self.user_data)
+        catch e
+            @error "Error occurred in the right-hand side function" exception = (e, catch_backtrace())
+            return 1
+        end
+        return 0
+    end
+
+    self.rhs_fn_c = @cfunction(
+        $wrapper, Cint, (Float64, Ptr{OIFArrayF64}, Ptr{OIFArrayF64}, Ptr{Cvoid})
+    )
+    self.rhs_fn = Ref{Any}(rhs_fn)
+    self.callback = OIFCallback(
+        OIF_LANG_JULIA,
+        C_NULL,
+        Base.unsafe_convert(Ptr{Cvoid}, self.rhs_fn_c),
+        length(RHS_ARG_TYPES),
+        pointer(RHS_ARG_TYPES),
+        OIF_INT,
+        _object_pointer(self.rhs_fn),
+    )
+    call_impl(self.implh, "set_rhs_fn", (self.callback,), ())
+end
+
+"""
+    set_preconditioner(self::IVP, setup_fn, solve_fn)
+
+Set the preconditioner ``P ≈ I - γ ∂f/∂y`` for matrix-free linear solvers.
+
+The function `setup_fn(t, y, jok, gamma, user_data)` prepares the preconditioner
+and may reuse the data computed from the Jacobian if `jok` is nonzero.
+The function `solve_fn(t, y, r, z, gamma, delta, user_data)` solves ``P z = r``
+approximately and writes the solution to `z`.
+"""
+function set_preconditioner(self::IVP, setup_fn, solve_fn)
+    if self.N <= 0
+        error("'set_initial_value' must be called before 'set_preconditioner'")
+    end
+
+    function setup_wrapper(
+        t::Float64, y::Ptr{OIFArrayF64}, jok::Cint, gamma::Float64, ::Ptr{Cvoid}
+    )::Cint
+        try
+            setup_fn(t, _wrap_oif_array(y), jok, gamma, self.user_data)
+        catch e
+            @error "Error occurred in the preconditioner setup" exception = (e, catch_backtrace())
+            return 1
+        end
+        return 0
+    end
+
+    function solve_wrapper(
+        t::Float64, y::Ptr{OIFArrayF64}, r::Ptr{OIFArrayF64}, z::Ptr{OIFArrayF64},
+        gamma::Float64, delta::Float64, ::Ptr{Cvoid},
+    )::Cint
+        try
+            solve_fn(
+                t, _wrap_oif_array(y), _wrap_oif_array(r), _wrap_oif_array(z),
+                gamma, delta, self.user_data,
+            )
+        catch e
+            @error "Error occurred in the preconditioner solve" exception = (e, catch_backtrace())
+            return 1
+        end
+        return 0
+    end
+
+    setup_fn_c = @cfunction(
+        $setup_wrapper, Cint, (Float64, Ptr{OIFArrayF64}, Cint, Float64, Ptr{Cvoid})
+    )
+    solve_fn_c = @cfunction(
+        $solve_wrapper,
+        Cint,
+        (
+            Float64, Ptr{OIFArrayF64}, Ptr{OIFArrayF64}, Ptr{OIFArrayF64},
+            Float64, Float64, Ptr{Cvoid},
+        ),
+    )
+    setup_fn_ref = Ref{Any}(setup_fn)
+    solve_fn_ref = Ref{Any}(solve_fn)
+    setup_callback = OIFCallback(
+        OIF_LANG_JULIA,
+        C_NULL,
+        Base.unsafe_convert(Ptr{Cvoid}, setup_fn_c),
+        length(PREC_SETUP_ARG_TYPES),
+        pointer(PREC_SETUP_ARG_TYPES),
+        OIF_INT,
+        _object_pointer(setup_fn_ref),
+    )
+    solve_callback = OIFCallback(
+        OIF_LANG_JULIA,
+        C_NULL,
+        Base.unsafe_convert(Ptr{Cvoid}, solve_fn_c),
+        length(PREC_SOLVE_ARG_TYPES),
+        pointer(PREC_SOLVE_ARG_TYPES),
+        OIF_INT,
+        _object_pointer(solve_fn_ref),
+    )
+    self.preconditioner = Any[setup_fn_c, solve_fn_c, setup_fn_ref, solve_fn_ref]
+    call_impl(self.implh, "set_preconditioner", (setup_callback, solve_callback), ())
+end
+
+"""
+    set_events(self::IVP, event_fn, directions, terminal)
+
+Set the event functions, whose zero crossings are located during integration.
+
+The function `event_fn(t, y, g, user_data)` writes the values of the event functions
+``g_i(t, y)`` to `g`, which has `length(directions)` elements.
+Event `i` occurs only when ``g_i`` increases through zero if `directions[i] > 0`,
+only when it decreases if `directions[i] < 0`, and in both cases if it is zero.
+If `terminal[i]` is true, `integrate` stops at the event.
+Use `get_last_event` to find out which event occurred and when.
+"""
+function set_events(
+    self::IVP, event_fn, directions::AbstractVector{<:Real}, terminal::AbstractVector{Bool}
+)
+    if self.N <= 0
+        error("'set_initial_value' must be called before 'set_events'")
+    end
+    if length(directions) != length(terminal)
+        throw(ArgumentError("Arguments `directions` and `terminal` must have the same length"))
+    end
+
+    function wrapper(t::Float64, y::Ptr{OIFArrayF64}, g::Ptr{OIFArrayF64}, ::Ptr{Cvoid})::Cint
+        try
+            event_fn(t, _wrap_oif_array(y), _wrap_oif_array(g), self.user_data)
+        catch e
+            @error "Error occurred in the event function" exception = (e, catch_backtrace())
+            return 1
+        end
+        return 0
+    end
+
+    event_fn_c = @cfunction(
+        $wrapper, Cint, (Float64, Ptr{OIFArrayF64}, Ptr{OIFArrayF64}, Ptr{Cvoid})
+    )
+    event_fn_ref = Ref{Any}(event_fn)
+    callback = OIFCallback(
+        OIF_LANG_JULIA,
+        C_NULL,
+        Base.unsafe_convert(Ptr{Cvoid}, event_fn_c),
+        length(RHS_ARG_TYPES),
+        pointer(RHS_ARG_TYPES),
+        OIF_INT,
+        _object_pointer(event_fn_ref),
+    )
+    self.events = Any[event_fn_c, event_fn_ref]
+    call_impl(
+        self.implh,
+        "set_events",
+        (length(directions), callback, Vector{Float64}(directions), Vector{Float64}(terminal)),
+        (),
+    )
+end
+
+"""
+    get_last_event(self::IVP)::Union{Nothing,Tuple{Int,Float64}}
+
+Return the index (starting from one) and time of the event
+that occurred during the last integration, or `nothing` if no event occurred.
+
+If a terminal event stopped the integration, it is this event.
+"""
+function get_last_event(self::IVP)::Union{Nothing,Tuple{Int,Float64}}
+    event = Vector{Float64}(undef, 2)
+    call_impl(self.implh, "get_last_event", (), (event,))
+    if event[1] < 0
+        return nothing
+    end
+    return Int(event[1]) + 1, event[2]
+end
+
+"""
+    set_user_data(self::IVP, user_data)
+
+Set the object that is passed as the last argument to the right-hand side.
+
+Implementations in other languages see the object as an opaque pointer.
+"""
+function set_user_data(self::IVP, user_data)
+    self.user_data = user_data
+    self.user_data_ref = Ref{Any}(user_data)
+    oif_user_data = OIFUserData(OIF_LANG_JULIA, C_NULL, C_NULL, _object_pointer(self.user_data_ref))
+    call_impl(self.implh, "set_user_data", (oif_user_data,), ())
+end
+
+function set_tolerances(self::IVP, rtol::Real, atol::Real)
+    call_impl(self.implh, "set_tolerances", (Float64(rtol), Float64(atol)), ())
+end
+
+"""
+    set_integrator(self::IVP, integrator_name::String)
+
+Select the integrator (time-stepping method) by its name.
+
+Names are specific to the implementation, for example,
+"dopri5" or "dop853" for `scipy_ode_dopri5`,
+"adams" or "bdf" for `sundials_cvode`,
+and "Tsit5", "Rodas5" or "FBDF" for `jl_diffeq`.
+"""
+function set_integrator(self::IVP, integrator_name::String)
+    call_impl(self.implh, "set_integrator", (integrator_name,), ())
+end
+
+"""
+    set_option(self::IVP, name::String, value)
+
+Set the implementation-specific option `name` to `value`,
+for example, `set_option(s, "linear_solver", "band")` for `sundials_cvode`.
+
+Use `print_options` to list the options supported by the implementation.
+"""
+function set_option(self::IVP, name::String, value)
+    call_impl(self.implh, "set_option", (name, string(value)), ())
+end
+
+function print_options(self::IVP)
+    call_impl(self.implh, "print_options", (), ())
+end
+
+"""
+    integrate(self::IVP, t::Real)
+
+Integrate the system up to time `t`; the solution is written to `self.y`.
+"""
+function integrate(self::IVP, t::Real)
+    call_impl(self.implh, "integrate", (Float64(t),), (self.y,))
+end
+
+"""
+    integrate_many(self::IVP, times::AbstractVector{<:Real})::Matrix{Float64}
+
+Integrate successively to each of `times` in one call to the implementation.
+
+Returns the matrix with shape `(N, length(times))`,
+whose columns are the solutions at the corresponding times.
+"""
+function integrate_many(self::IVP, times::AbstractVector{<:Real})::Matrix{Float64}
+    Y = Matrix{Float64}(undef, self.N, length(times))
+    call_impl(self.implh, "integrate_many", (Vector{Float64}(times),), (Y,))
+    return Y
+end
+
+"""
+    integrate_one_step(self::IVP, t_end::Real)::Float64
+
+Let the solver take one step of its own size towards `t_end`, but not beyond it.
+
+Returns the reached time; the solution is written to `self.y`.
+"""
+function integrate_one_step(self::IVP, t_end::Real)::Float64
+    t = Vector{Float64}(undef, 1)
+    call_impl(self.implh, "integrate_one_step", (Float64(t_end),), (t, self.y))
+    return t[1]
+end
+
+"""
+    interpolate(self::IVP, t::Real)::Vector{Float64}
+
+Evaluate the solution at time `t` within the last step.
+"""
+function interpolate(self::IVP, t::Real)::Vector{Float64}
+    y = Vector{Float64}(undef, self.N)
+    call_impl(self.implh, "interpolate", (Float64(t),), (y,))
+    return y
+end
+
+"""
+    get_stats(self::IVP)::Dict{String,Real}
+
+Return the statistics of the integrator, which are named as in `IVP_STATS`.
+
+Counters, such as "num_steps", are integers that accumulate since the initial value was set.
+Only the statistics that the implementation provides are included.
+"""
+function get_stats(self::IVP)::Dict{String,Real}
+    stats = Vector{Float64}(undef, length(IVP_STATS))
+    call_impl(self.implh, "get_stats", (), (stats,))
+    return Dict{String,Real}(
+        name => (name in ("last_step", "rhs_time") ? value : Int(value))
+        for (name, value) in zip(IVP_STATS, stats) if !isnan(value)
+    )
+end
+
+"""
+    save_state(self::IVP, filename::AbstractString)
+
+Save the state of the integrator to the file `filename`,
+so that the integration can be resumed later with `load_state`.
+"""
+function save_state(self::IVP, filename::AbstractString)
+    call_impl(self.implh, "save_state", (String(filename),), ())
+end
+
+"""
+    load_state(self::IVP, filename::AbstractString)
+
+Resume the integration from the state saved with `save_state`.
+
+The right-hand side, the tolerances, and the other settings are not part of the state,
+so they must be set beforehand, along with an initial value of the same size.
+"""
+function load_state(self::IVP, filename::AbstractString)
+    call_impl(self.implh, "load_state", (String(filename),), ())
+end
+
+function print_stats(self::IVP)
+    call_impl(self.implh, "print_stats", (), ())
+end
+
+function _wrap_oif_array(p::Ptr{OIFArrayF64})::Vector{Float64}
+    arr = unsafe_load(p)
+    return unsafe_wrap(Array, arr.data, unsafe_load(arr.dimensions))
+end
+
+# Address of the object held by `ref`, valid while `ref` is alive.
+function _object_pointer(ref::Base.RefValue{Any})::Ptr{Cvoid}
+    return unsafe_load(Ptr{Ptr{Cvoid}}(Base.unsafe_convert(Ptr{Any}, ref)))
+end
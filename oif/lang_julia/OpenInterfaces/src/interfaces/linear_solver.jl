@@ -0,0 +1,24 @@
+"""
+    LinearSolver(impl::String)
+
+Solver for linear systems ``A x = b``, provided by the implementation `impl`.
+"""
+mutable struct LinearSolver
+    implh::ImplHandle
+    function LinearSolver(impl::String)
+        self = new(init_impl("linsolve", impl, 1, 0))
+        finalizer(self) do s
+            unload_impl(s.implh)
+        end
+        return self
+    end
+end
+
+function solve(self::LinearSolver, A::AbstractMatrix{<:Real}, b::AbstractVector{<:Real})
+    # Implementations expect matrices in row-major order,
+    # which is the memory layout of the transposed Julia matrix.
+    At = permutedims(Matrix{Float64}(A))
+    result = Vector{Float64}(undef, size(A, 2))
+    call_impl(self.implh, "solve_lin", (At, Vector{Float64}(b)), (result,))
+    return result
+end
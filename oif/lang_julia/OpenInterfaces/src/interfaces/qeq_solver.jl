@@ -0,0 +1,22 @@
+"""
+    QeqSolver(impl::String)
+
+Solver for quadratic equations ``a x^2 + b x + c = 0``,
+provided by the implementation `impl`.
+"""
+mutable struct QeqSolver
+    implh::ImplHandle
+    function QeqSolver(impl::String)
+        self = new(init_impl("qeq", impl, 1, 0))
+        finalizer(self) do s
+            unload_impl(s.implh)
+        end
+        return self
+    end
+end
+
+function solve(self::QeqSolver, a::Real, b::Real, c::Real)
+    result = Vector{Float64}(undef, 2)
+    call_impl(self.implh, "solve_qeq", (Float64(a), Float64(b), Float64(c)), (result,))
+    return result
+end
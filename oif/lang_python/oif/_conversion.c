@@ -2,12 +2,18 @@
 #define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
 #include <Python.h>
 #include <ffi.h>
+#include <math.h>
 #include <numpy/arrayobject.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "oif/api.h"
 
+enum {
+    // Maximum number of arguments of a callback function that can be wrapped.
+    CALLBACK_MAX_NARGS_ = 16,
+};
+
 static PyObject *
 numpy_array_from_oif_array_f64(PyObject *Py_UNUSED(self), PyObject *args)
 {
@@ -45,6 +51,329 @@ numpy_array_from_oif_array_f64(PyObject *Py_UNUSED(self), PyObject *args)
     return retval;
 }
 
+/**
+ * C function pointer over a Python callable.
+ *
+ * The object owns a libffi closure, so that `fn_p_c` is a genuine C function
+ * pointer that C implementations can invoke directly.
+ * The argument types are fixed at creation, therefore, the FFI call interface
+ * is prepared once, and on each invocation the C arguments are converted
+ * to Python objects without any intermediate Python code.
+ * NumPy views over `OIFArrayF64` arguments are reused between invocations
+ * when the underlying buffer and shape do not change.
+ */
+typedef struct {
+    PyObject_HEAD PyObject *fn;  // Python callable that is invoked
+    unsigned int nargs;          // Number of function arguments
+    OIFArgType *oif_arg_types;   // Arg types used in OpenInterFaces
+    OIFArgType oif_restype;      // Return type used in OpenInterFaces
+    ffi_cif cif;                 // libffi context object
+    ffi_type **arg_types;        // Arg types in terms of libffi
+    ffi_closure *closure;        // Writable closure object
+    void *fn_p_c;                // Executable address of the closure
+    PyObject **views;            // Cached NumPy views for array arguments
+} CWrapperForPythonCallableObject;
+
+static PyObject *
+view_from_oif_array_f64_(CWrapperForPythonCallableObject *self, size_t i, OIFArrayF64 *arr)
+{
+    PyObject *view = self->views[i];
+    // The cached view can be reused only if nobody else holds a reference
+    // to it and it still describes the same memory.
+    if (view != NULL && Py_REFCNT(view) == 1) {
+        PyArrayObject *np_view = (PyArrayObject *)view;
+        int same = PyArray_DATA(np_view) == (void *)arr->data &&
+                   PyArray_NDIM(np_view) == arr->nd && PyArray_ISWRITEABLE(np_view);
+        for (int k = 0; same && k < arr->nd; ++k) {
+            same = PyArray_DIM(np_view, k) == arr->dimensions[k];
+        }
+        if (same) {
+            Py_INCREF(view);
+            return view;
+        }
+    }
+
+    PyObject *new_view =
+        PyArray_SimpleNewFromData(arr->nd, arr->dimensions, NPY_FLOAT64, arr->data);
+    if (new_view == NULL) {
+        return NULL;
+    }
+    Py_XSETREF(self->views[i], new_view);
+    Py_INCREF(new_view);
+    return new_view;
+}
+
+static void
+CWrapperForPythonCallable_invoke_(ffi_cif *Py_UNUSED(cif), void *ret, void **args,
+                                  void *user_data)
+{
+    CWrapperForPythonCallableObject *self = user_data;
+    // One extra slot in front is required by `PY_VECTORCALL_ARGUMENTS_OFFSET`.
+    PyObject *stack[CALLBACK_MAX_NARGS_ + 1] = {NULL};
+    PyObject **py_args = &stack[1];
+    PyObject *result = NULL;
+    long c_result = -1;
+    double c_result_f64 = NAN;
+    unsigned int nconverted = 0;
+
+    PyGILState_STATE gstate = PyGILState_Ensure();
+
+    if (self->fn == NULL) {
+        // The callable was cleared by the garbage collector.
+        PyErr_SetString(PyExc_RuntimeError, "Python callable of the callback is cleared");
+        goto cleanup;
+    }
+
+    for (unsigned int i = 0; i < self->nargs; ++i) {
+        PyObject *value;
+        switch (self->oif_arg_types[i]) {
+            case OIF_INT:
+                value = PyLong_FromLong(*(int *)args[i]);
+                break;
+            case OIF_FLOAT64:
+                value = PyFloat_FromDouble(*(double *)args[i]);
+                break;
+            case OIF_ARRAY_F64:
+                value = view_from_oif_array_f64_(self, i, *(OIFArrayF64 **)args[i]);
+                break;
+            case OIF_USER_DATA: {
+                // User data from Python is passed as a raw `PyObject *`.
+                PyObject *obj = *(PyObject **)args[i];
+                value = (obj == NULL) ? Py_None : obj;
+                Py_INCREF(value);
+                break;
+            }
+            default:
+                PyErr_Format(PyExc_TypeError, "Unsupported argument type %d",
+                             self->oif_arg_types[i]);
+                value = NULL;
+        }
+        if (value == NULL) {
+            goto cleanup;
+        }
+        py_args[i] = value;
+        nconverted++;
+    }
+
+    result = PyObject_Vectorcall(self->fn, py_args,
+                                 self->nargs | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    if (result == NULL) {
+        goto cleanup;
+    }
+
+    if (self->oif_restype == OIF_INT) {
+        if (result == Py_None) {
+            c_result = 0;
+        }
+        else {
+            c_result = PyLong_AsLong(result);
+        }
+    }
+    else {
+        c_result_f64 = PyFloat_AsDouble(result);
+    }
+
+cleanup:
+    if (PyErr_Occurred()) {
+        fprintf(stderr, "[_conversion] Exception in the Python callback\n");
+        PyErr_Print();
+        c_result = -1;
+    }
+    Py_XDECREF(result);
+    for (unsigned int i = 0; i < nconverted; ++i) {
+        Py_DECREF(py_args[i]);
+    }
+
+    PyGILState_Release(gstate);
+
+    // libffi requires return values of integral types to be widened
+    // to the size of `ffi_arg`.
+    if (self->oif_restype == OIF_INT) {
+        *(ffi_arg *)ret = (ffi_arg)(int)c_result;
+    }
+    else {
+        *(double *)ret = c_result_f64;
+    }
+}
+
+/*
+ * The wrapper participates in garbage collection, as the callable often
+ * refers back to it, for example, through a closure over the `OIFCallback`.
+ */
+static int
+CWrapperForPythonCallable_traverse(CWrapperForPythonCallableObject *self, visitproc visit,
+                                   void *arg)
+{
+    Py_VISIT(self->fn);
+    if (self->views != NULL) {
+        for (unsigned int i = 0; i < self->nargs; ++i) {
+            Py_VISIT(self->views[i]);
+        }
+    }
+    return 0;
+}
+
+static int
+CWrapperForPythonCallable_clear(CWrapperForPythonCallableObject *self)
+{
+    Py_CLEAR(self->fn);
+    if (self->views != NULL) {
+        for (unsigned int i = 0; i < self->nargs; ++i) {
+            Py_CLEAR(self->views[i]);
+        }
+    }
+    return 0;
+}
+
+static void
+CWrapperForPythonCallable_dealloc(CWrapperForPythonCallableObject *self)
+{
+    PyObject_GC_UnTrack(self);
+    CWrapperForPythonCallable_clear(self);
+    if (self->closure != NULL) {
+        ffi_closure_free(self->closure);
+    }
+    free(self->views);
+    free(self->arg_types);
+    free(self->oif_arg_types);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static int
+CWrapperForPythonCallable_init(CWrapperForPythonCallableObject *self, PyObject *args,
+                               PyObject *Py_UNUSED(kwds))
+{
+    PyObject *fn;
+    PyObject *py_arg_types;
+    int restype;
+
+    if (!PyArg_ParseTuple(args, "OOi", &fn, &py_arg_types, &restype)) {
+        return -1;
+    }
+    if (!PyCallable_Check(fn)) {
+        PyErr_SetString(PyExc_TypeError, "First argument must be callable");
+        return -1;
+    }
+    if (self->closure != NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "Object is already initialized");
+        return -1;
+    }
+
+    PyObject *seq = PySequence_Fast(py_arg_types, "Argument types must be a sequence");
+    if (seq == NULL) {
+        return -1;
+    }
+    Py_ssize_t nargs = PySequence_Fast_GET_SIZE(seq);
+    if (nargs > CALLBACK_MAX_NARGS_) {
+        PyErr_Format(PyExc_ValueError,
+                     "Callbacks with more than %d arguments are not supported",
+                     CALLBACK_MAX_NARGS_);
+        goto fail;
+    }
+
+    self->nargs = (unsigned int)nargs;
+    self->oif_arg_types = malloc(sizeof(OIFArgType) * (nargs + 1));
+    self->arg_types = malloc(sizeof(ffi_type *) * (nargs + 1));
+    self->views = calloc(nargs + 1, sizeof(PyObject *));
+    if (self->oif_arg_types == NULL || self->arg_types == NULL || self->views == NULL) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+
+    for (Py_ssize_t i = 0; i < nargs; ++i) {
+        long t = PyLong_AsLong(PySequence_Fast_GET_ITEM(seq, i));
+        if (t == -1 && PyErr_Occurred()) {
+            goto fail;
+        }
+        self->oif_arg_types[i] = (OIFArgType)t;
+        if (t == OIF_INT) {
+            self->arg_types[i] = &ffi_type_sint;
+        }
+        else if (t == OIF_FLOAT64) {
+            self->arg_types[i] = &ffi_type_double;
+        }
+        else if (t == OIF_ARRAY_F64 || t == OIF_USER_DATA) {
+            self->arg_types[i] = &ffi_type_pointer;
+        }
+        else {
+            PyErr_Format(PyExc_ValueError, "Cannot convert argument type %ld", t);
+            goto fail;
+        }
+    }
+
+    ffi_type *ffi_restype;
+    if (restype == OIF_INT) {
+        ffi_restype = &ffi_type_sint;
+    }
+    else if (restype == OIF_FLOAT64) {
+        ffi_restype = &ffi_type_double;
+    }
+    else {
+        PyErr_Format(PyExc_ValueError, "Cannot convert type '%d'", restype);
+        goto fail;
+    }
+    self->oif_restype = (OIFArgType)restype;
+
+    ffi_status status = ffi_prep_cif(&self->cif, FFI_DEFAULT_ABI, self->nargs, ffi_restype,
+                                     self->arg_types);
+    if (status != FFI_OK) {
+        PyErr_SetString(PyExc_RuntimeError, "ffi_prep_cif was not OK");
+        goto fail;
+    }
+
+    self->closure = ffi_closure_alloc(sizeof(ffi_closure), &self->fn_p_c);
+    if (self->closure == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate FFI closure");
+        goto fail;
+    }
+    status = ffi_prep_closure_loc(self->closure, &self->cif, CWrapperForPythonCallable_invoke_,
+                                  self, self->fn_p_c);
+    if (status != FFI_OK) {
+        PyErr_SetString(PyExc_RuntimeError, "ffi_prep_closure_loc was not OK");
+        ffi_closure_free(self->closure);
+        self->closure = NULL;
+        goto fail;
+    }
+
+    Py_INCREF(fn);
+    self->fn = fn;
+    Py_DECREF(seq);
+    return 0;
+
+fail:
+    Py_DECREF(seq);
+    return -1;
+}
+
+static PyObject *
+CWrapperForPythonCallable_get_fn_p_c(CWrapperForPythonCallableObject *self,
+                                     void *Py_UNUSED(closure))
+{
+    return PyLong_FromVoidPtr(self->fn_p_c);
+}
+
+static PyGetSetDef CWrapperForPythonCallable_getset[] = {
+    {"fn_p_c", (getter)CWrapperForPythonCallable_get_fn_p_c, NULL,
+     "Address of the C function that invokes the wrapped callable", NULL},
+    {NULL} /* Sentinel */
+};
+
+static PyTypeObject CWrapperForPythonCallableType = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0).tp_name =
+        "_conversion.CWrapperForPythonCallable",
+    .tp_doc = PyDoc_STR("C function pointer that invokes a Python callable"),
+    .tp_basicsize = sizeof(CWrapperForPythonCallableObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc)CWrapperForPythonCallable_init,
+    .tp_dealloc = (destructor)CWrapperForPythonCallable_dealloc,
+    .tp_traverse = (traverseproc)CWrapperForPythonCallable_traverse,
+    .tp_clear = (inquiry)CWrapperForPythonCallable_clear,
+    .tp_free = PyObject_GC_Del,
+    .tp_getset = CWrapperForPythonCallable_getset,
+};
+
 static PyMethodDef callback_methods[] = {
     {"numpy_array_from_oif_array_f64", numpy_array_from_oif_array_f64, METH_VARARGS,
      "Invoke a given C function from Python."},
@@ -66,10 +395,25 @@ PyInit__conversion(void)
 {
     PyObject *m;
 
+    import_array();
+
+    if (PyType_Ready(&CWrapperForPythonCallableType) < 0) {
+        fprintf(stderr, "[_conversion] Type is not ready\n");
+        return NULL;
+    }
+
     m = PyModule_Create(&callbackmodule);
     if (m == NULL) {
         return NULL;
     }
 
+    Py_INCREF(&CWrapperForPythonCallableType);
+    if (PyModule_AddObject(m, "CWrapperForPythonCallable",
+                           (PyObject *)&CWrapperForPythonCallableType) < 0) {
+        Py_DECREF(&CWrapperForPythonCallableType);
+        Py_DECREF(m);
+        return NULL;
+    }
+
     return m;
 }
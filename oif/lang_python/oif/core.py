@@ -1,5 +1,6 @@
 import ctypes
-from typing import Callable, NewType, Union
+import os
+from typing import Callable, NewType, Optional
 
 import _conversion
 import numpy as np
@@ -53,6 +54,10 @@ class OIFCallback(ctypes.Structure):
         ("src", ctypes.c_int),
         ("fn_p_py", ctypes.c_void_p),
         ("fn_p_c", ctypes.c_void_p),
+        ("nargs", ctypes.c_uint),
+        ("arg_types", ctypes.POINTER(OIFArgType)),
+        ("restype", OIFArgType),
+        ("fn_p_jl", ctypes.c_void_p),
     ]
 
 
@@ -61,91 +66,129 @@ class OIFUserData(ctypes.Structure):
         ("src", ctypes.c_int),
         ("c", ctypes.c_void_p),
         ("py", ctypes.c_void_p),
+        ("jl", ctypes.c_void_p),
     ]
 
 
+class CFunctionPointer:
+    """Declaration that a callback is a compiled function with C calling convention.
+
+    Use it to pass raw addresses of compiled functions as callbacks,
+    when the address cannot be determined automatically.
+    The function must have exactly the signature expected by the interface,
+    for example, `int rhs(double, OIFArrayF64 *, OIFArrayF64 *, void *)`.
+
+    Parameters
+    ----------
+    address : int
+        Address of the function in memory.
+    owner : object, optional
+        Object that owns the compiled code and must be kept alive
+        while the function pointer is in use.
+    """
+
+    def __init__(self, address: int, owner: object = None):
+        if not isinstance(address, int) or address == 0:
+            raise ValueError("Argument `address` must be a non-null integer address")
+        self.address = address
+        self.owner = owner
+
+
+def _is_ctypes_thunk(fn: ctypes._CFuncPtr) -> bool:
+    """Return True if `fn` is created from a Python callable, e.g., `CFUNCTYPE(...)(f)`.
+
+    Such function pointers keep the `ctypes` thunk that calls the callable
+    among the objects they own, unlike the ones created from library symbols
+    or addresses.
+    """
+    stack = [fn._objects]
+    seen = set()
+    while stack:
+        obj = stack.pop()
+        if id(obj) in seen:
+            continue
+        seen.add(id(obj))
+        if type(obj).__name__ == "CThunkObject":
+            return True
+        if isinstance(obj, dict):
+            stack.extend(obj.values())
+        elif isinstance(obj, ctypes._CFuncPtr):
+            stack.append(obj._objects)
+    return False
+
+
+def c_function_address(fn: object) -> Optional[int]:
+    """Return the address of compiled function `fn` or None if it is not one.
+
+    Recognized are `CFunctionPointer` declarations, `ctypes` function pointers,
+    `cffi` function pointers, and Numba `cfunc` objects.
+    `ctypes` function pointers over Python callables are not compiled functions,
+    as they enter the interpreter on each call.
+    """
+    if isinstance(fn, CFunctionPointer):
+        return fn.address
+    if isinstance(fn, ctypes._CFuncPtr):
+        if _is_ctypes_thunk(fn):
+            return None
+        return ctypes.cast(fn, ctypes.c_void_p).value
+    if type(fn).__module__ == "_cffi_backend":
+        import cffi
+
+        ffi = cffi.FFI()
+        if ffi.typeof(fn).kind == "function":
+            return int(ffi.cast("uintptr_t", fn))
+        return None
+    # Numba `cfunc` objects.
+    if hasattr(fn, "address") and hasattr(fn, "native_name"):
+        return fn.address
+    return None
+
+
 def make_oif_callback(
     fn: Callable, argtypes: list[OIFArgType], restype: OIFArgType
 ) -> OIFCallback:
+    # If the callback is already compiled, we pass it to implementations
+    # as a C function, so that they invoke it directly without entering
+    # the Python interpreter.
+    arg_types = (OIFArgType * len(argtypes))(*argtypes)
+
+    fn_p_c = c_function_address(fn)
+    if fn_p_c is None and isinstance(fn, ctypes._CFuncPtr):
+        # Thunks over Python callables convert the arguments and acquire the GIL
+        # themselves, so they are passed as C functions as well.
+        fn_p_c = ctypes.cast(fn, ctypes.c_void_p).value
+    if fn_p_c is not None:
+        oifcallback = OIFCallback(
+            OIF_LANG_C, None, fn_p_c, len(argtypes), arg_types, restype
+        )
+        oifcallback._c_fn = fn
+        return oifcallback
+
     # id returns function pointer. Yes, I am also shocked.
     # Docstring for `id` says: "CPython uses the object's memory address".
     fn_p_py = id(fn)
 
-    ctypes_argtypes: list = []
-    for argt in argtypes:
-        if argt == OIF_FLOAT64:
-            ctypes_argtypes.append(ctypes.c_double)
-        elif argt == OIF_ARRAY_F64:
-            ctypes_argtypes.append(ctypes.POINTER(OIFArrayF64))
-        elif argt == OIF_USER_DATA:
-            ctypes_argtypes.append(ctypes.c_void_p)
-        else:
-            raise ValueError(f"Cannot convert argument type {argt}")
-
-    ctypes_restype: Union[type[ctypes.c_int], type[ctypes.c_double]]
-    if restype == OIF_INT:
-        ctypes_restype = ctypes.c_int
-    elif restype == OIF_FLOAT64:
-        ctypes_restype = ctypes.c_double
-        # TODO: Add c_void_p type
-        # Here there is a discussion why one can use only simple
-        # predefined pointer types as restype:
-        # https://stackoverflow.com/q/33005127
-    else:
-        raise ValueError(f"Cannot convert type '{restype}'")
-
-    fn_t = ctypes.CFUNCTYPE(ctypes_restype, *ctypes_argtypes)
-    c_wrapper_fn = fn_t(_make_c_func_wrapper_from_py_callable(fn, argtypes, restype))
-
-    fn_p_c = ctypes.cast(c_wrapper_fn, ctypes.c_void_p)
-    assert fn_p_c.value is not None
-    oifcallback = OIFCallback(OIF_LANG_PYTHON, fn_p_py, fn_p_c)
+    # C function pointer that converts OIF data types to native Python
+    # data types and invokes `fn`.
+    # The conversion is done completely in the C extension, as doing it
+    # in Python with `ctypes` takes a significant part of the run time
+    # of the callback (see technote 2024-01-31).
+    c_wrapper_fn = _conversion.CWrapperForPythonCallable(fn, argtypes, restype)
+
+    oifcallback = OIFCallback(
+        OIF_LANG_PYTHON,
+        fn_p_py,
+        c_wrapper_fn.fn_p_c,
+        len(argtypes),
+        arg_types,
+        restype,
+    )
+    # The wrapper owns the memory with the executable code of the C function,
+    # so it must live as long as the callback itself.
+    oifcallback._c_wrapper_fn = c_wrapper_fn
     return oifcallback
 
 
-def _make_c_func_wrapper_from_py_callable(fn: Callable, arg_types: list, restype):
-    """Call `fn` converting OIF data types to native Python data types."""
-
-    def _pyobject_from_pointer(v):
-        if v is None:
-            return v
-        else:
-            return ctypes.cast(v, ctypes.py_object).value
-
-    type_conversion = {
-        OIF_INT: lambda v: v,
-        OIF_FLOAT64: lambda v: v,
-        # v is a ctypes pointer to OIFArrayF64 struct.
-        # v_p is a raw C pointer
-        # Initially this block of code used numpy.ctypeslib.as_array
-        # to obtain a NumPy array for existing C buffer, but somehow
-        # it works very slowly, so we get NumPy arrays now using
-        # C extension.
-        OIF_ARRAY_F64: lambda v: _conversion.numpy_array_from_oif_array_f64(
-            ctypes.addressof(v.contents)
-        ),
-        # ctypes receives a pointer to PyObject as Python int,
-        # and this is how we convert it back to PyObject.
-        OIF_USER_DATA: _pyobject_from_pointer,
-    }
-    py_arg_values = [None] * len(arg_types)
-
-    def wrapper(*arg_values):
-        for i, (t, v) in enumerate(zip(arg_types, arg_values)):
-            try:
-                py_arg_values[i] = type_conversion[t](v)
-            except KeyError:
-                raise ValueError(f"Unsupported data type {t}")
-
-        result = fn(*py_arg_values)
-        if result is None:
-            assert restype == OIF_INT
-            result = 0
-        return result
-
-    return wrapper
-
-
 def make_oif_user_data(data: object) -> OIFUserData:
     return OIFUserData(OIF_LANG_PYTHON, None, ctypes.c_void_p(id(data)))
 
@@ -155,106 +198,79 @@ class OIFPyBinding:
         self.implh = implh
         self.interface = interface
         self.impl = impl
+        # Wrapped once, as wrapping a C function anew on each call is costly.
+        self._call_interface_impl = _wrap_c_function(
+            _lib_dispatch,
+            "call_interface_impl",
+            ctypes.c_int,
+            [
+                ctypes.c_int,
+                ctypes.c_char_p,
+                ctypes.POINTER(OIFArgs),
+                ctypes.POINTER(OIFArgs),
+            ],
+        )
 
     def call(self, method, user_args, out_user_args):
+        # Objects whose addresses are passed must live until the call returns.
+        keep_alive = []
         num_args = len(user_args)
         arg_types = []
         arg_values = []
         for arg in user_args:
             if isinstance(arg, int):
-                argp = ctypes.pointer(ctypes.c_int(arg))
-                arg_void_p = ctypes.cast(argp, ctypes.c_void_p)
-                arg_values.append(arg_void_p)
+                arg_values.append(_address_of(ctypes.c_int(arg), keep_alive))
                 arg_types.append(OIF_INT)
             elif isinstance(arg, float):
-                arg_p = ctypes.pointer(ctypes.c_double(arg))
-                arg_void_p = ctypes.cast(arg_p, ctypes.c_void_p)
-                arg_values.append(arg_void_p)
+                arg_values.append(_address_of(ctypes.c_double(arg), keep_alive))
                 arg_types.append(OIF_FLOAT64)
+            elif isinstance(arg, str):
+                arg_values.append(
+                    _address_of(ctypes.c_char_p(arg.encode()), keep_alive)
+                )
+                arg_types.append(OIF_STR)
             elif isinstance(arg, np.ndarray) and arg.dtype == np.float64:
                 assert arg.dtype == np.float64
-                nd = arg.ndim
-                dimensions = (ctypes.c_long * len(arg.shape))(*arg.shape)
-                data = arg.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-
-                oif_array = OIFArrayF64(nd, dimensions, data)
-                oif_array_p = ctypes.cast(ctypes.pointer(oif_array), ctypes.c_void_p)
-                oif_array_p_p = ctypes.cast(
-                    ctypes.pointer(oif_array_p), ctypes.c_void_p
-                )
-                arg_values.append(oif_array_p_p)
+                arg_values.append(_array_address_of(arg, keep_alive))
                 arg_types.append(OIF_ARRAY_F64)
             elif isinstance(arg, OIFCallback):
-                argp = ctypes.pointer(arg)
-                arg_values.append(ctypes.cast(argp, ctypes.c_void_p))
+                arg_values.append(_address_of(arg, keep_alive))
                 arg_types.append(OIF_CALLBACK)
             elif isinstance(arg, OIFUserData):
-                argp = ctypes.pointer(arg)
-                arg_values.append(ctypes.cast(argp, ctypes.c_void_p))
+                arg_values.append(_address_of(arg, keep_alive))
                 arg_types.append(OIF_USER_DATA)
             else:
                 raise ValueError(f"Cannot convert argument {arg} of type{type(arg)}")
 
-        in_arg_types_ctypes = ctypes.cast(
-            (ctypes.c_int * len(arg_types))(*arg_types), ctypes.POINTER(OIFArgType)
-        )
-        in_arg_values_ctypes = ctypes.cast(
-            (ctypes.c_void_p * len(arg_values))(*arg_values),
-            ctypes.POINTER(ctypes.c_void_p),
+        in_args_packed = OIFArgs(
+            num_args,
+            (OIFArgType * num_args)(*arg_types),
+            (ctypes.c_void_p * num_args)(*arg_values),
         )
-        in_args_packed = OIFArgs(num_args, in_arg_types_ctypes, in_arg_values_ctypes)
 
         num_out_args = len(out_user_args)
         out_arg_types = []
         out_arg_values = []
         for arg in out_user_args:
             if isinstance(arg, int):
-                argp = ctypes.pointer(ctypes.c_int(arg))
-                arg_void_p = ctypes.cast(argp, ctypes.c_void_p)
-                out_arg_values.append(arg_void_p)
+                out_arg_values.append(_address_of(ctypes.c_int(arg), keep_alive))
                 out_arg_types.append(OIF_INT)
             elif isinstance(arg, float):
-                arg_p = ctypes.pointer(ctypes.c_double(arg))
-                arg_void_p = ctypes.cast(arg_p, ctypes.c_void_p)
-                out_arg_values.append(arg_void_p)
+                out_arg_values.append(_address_of(ctypes.c_double(arg), keep_alive))
                 out_arg_types.append(OIF_FLOAT64)
             elif isinstance(arg, np.ndarray) and arg.dtype == np.float64:
-                nd = arg.ndim
-                dimensions = (ctypes.c_long * len(arg.shape))(*arg.shape)
-                data = arg.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-
-                oif_array = OIFArrayF64(nd, dimensions, data)
-                oif_array_p = ctypes.cast(ctypes.pointer(oif_array), ctypes.c_void_p)
-                oif_array_p_p = ctypes.cast(
-                    ctypes.pointer(oif_array_p), ctypes.c_void_p
-                )
-                out_arg_values.append(oif_array_p_p)
+                out_arg_values.append(_array_address_of(arg, keep_alive))
                 out_arg_types.append(OIF_ARRAY_F64)
             else:
                 raise ValueError(f"Cannot convert argument {arg} of type{type(arg)}")
 
-        out_arg_types_ctypes = ctypes.cast(
-            (ctypes.c_int * len(out_arg_types))(*out_arg_types),
-            ctypes.POINTER(OIFArgType),
-        )
-        out_arg_values_ctypes = ctypes.cast(
-            (ctypes.c_void_p * len(out_arg_values))(*out_arg_values),
-            ctypes.POINTER(ctypes.c_void_p),
+        out_packed = OIFArgs(
+            num_out_args,
+            (OIFArgType * num_out_args)(*out_arg_types),
+            (ctypes.c_void_p * num_out_args)(*out_arg_values),
         )
-        out_packed = OIFArgs(num_out_args, out_arg_types_ctypes, out_arg_values_ctypes)
 
-        call_interface_impl = _wrap_c_function(
-            _lib_dispatch,
-            "call_interface_impl",
-            ctypes.c_int,
-            [
-                ctypes.c_int,
-                ctypes.c_char_p,
-                ctypes.POINTER(OIFArgs),
-                ctypes.POINTER(OIFArgs),
-            ],
-        )
-        status = call_interface_impl(
+        status = self._call_interface_impl(
             self.implh,
             method.encode(),
             ctypes.byref(in_args_packed),
@@ -267,6 +283,25 @@ class OIFPyBinding:
         return 0
 
 
+def _address_of(obj, keep_alive: list) -> ctypes.c_void_p:
+    """Return the address of the ctypes object `obj` and append it to `keep_alive`.
+
+    Unlike `ctypes.cast`, this creates no reference cycle,
+    so the temporary objects of a call are freed right after it
+    and do not pile up in memory until the garbage collector runs.
+    """
+    keep_alive.append(obj)
+    return ctypes.c_void_p(ctypes.addressof(obj))
+
+
+def _array_address_of(arr: np.ndarray, keep_alive: list) -> ctypes.c_void_p:
+    """Return the address of a pointer to `OIFArrayF64` describing `arr`."""
+    dimensions = (ctypes.c_long * arr.ndim)(*arr.shape)
+    data = ctypes.cast(arr.ctypes.data, ctypes.POINTER(ctypes.c_double))
+    oif_array = OIFArrayF64(arr.ndim, dimensions, data)
+    return _address_of(_address_of(oif_array, keep_alive), keep_alive)
+
+
 def init_impl(interface: str, impl: str, major: UInt, minor: UInt):
     load_interface_impl = _wrap_c_function(
         _lib_dispatch,
@@ -299,6 +334,15 @@ def unload_impl(binding: OIFPyBinding):
         )
 
 
+def set_julia_sysimage(path: str) -> None:
+    """Start Julia from the system image at `path`.
+
+    Must be called before the first Julia implementation is loaded.
+    Equivalent to setting the environment variable `OIF_JULIA_SYSIMAGE`.
+    """
+    os.environ["OIF_JULIA_SYSIMAGE"] = os.fspath(path)
+
+
 def _wrap_c_function(lib, funcname, restype, argtypes):
     if isinstance(argtypes, list):
         if len(argtypes) == 1:
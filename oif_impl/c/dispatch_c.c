@@ -133,12 +133,18 @@ call_impl(ImplInfo *impl_info, const char *method, OIFArgs *in_args, OIFArgs *ou
 
     // Merge input and output argument types together in `arg_types` array.
     for (size_t i = 0; i < num_in_args; ++i) {
-        if (in_args->arg_types[i] == OIF_FLOAT64) {
+        if (in_args->arg_types[i] == OIF_INT) {
+            arg_types[i] = &ffi_type_sint;
+        }
+        else if (in_args->arg_types[i] == OIF_FLOAT64) {
             arg_types[i] = &ffi_type_double;
         }
         else if (in_args->arg_types[i] == OIF_ARRAY_F64) {
             arg_types[i] = &ffi_type_pointer;
         }
+        else if (in_args->arg_types[i] == OIF_STR) {
+            arg_types[i] = &ffi_type_pointer;
+        }
         else if (in_args->arg_types[i] == OIF_CALLBACK) {
             arg_types[i] = &ffi_type_pointer;
             // We need to take a pointer to a pointer according to the FFI
@@ -154,6 +160,9 @@ call_impl(ImplInfo *impl_info, const char *method, OIFArgs *in_args, OIFArgs *ou
             else if (user_data->src == OIF_LANG_PYTHON) {
                 in_args->arg_values[i] = &user_data->py;
             }
+            else if (user_data->src == OIF_LANG_JULIA) {
+                in_args->arg_values[i] = &user_data->jl;
+            }
             else {
                 fprintf(stderr,
                         "[dispatch_c] Cannot handle OIFUserData because of the unsupported "
@@ -7,6 +7,60 @@
  */
 typedef int (*oif_ivp_rhs_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *ydot, void *user_data);
 
+/**
+ * Signature of the function that writes the Jacobian df/dy
+ * to `J` with shape (N, N) in row-major order.
+ */
+typedef int (*oif_ivp_jac_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *J, void *user_data);
+
+/**
+ * Signature of the function that writes the nonzero values of the Jacobian
+ * to `data` in the order of the CSR pattern.
+ */
+typedef int (*oif_ivp_jac_csr_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *data,
+                                    void *user_data);
+
+/**
+ * Signature of the function that writes the Jacobian-vector product to `Jv`.
+ */
+typedef int (*oif_ivp_jac_times_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *v,
+                                      OIFArrayF64 *Jv, void *user_data);
+
+/**
+ * Signature of the function that prepares the preconditioner P ~ I - gamma df/dy.
+ */
+typedef int (*oif_ivp_prec_setup_fn_t)(double t, OIFArrayF64 *y, int jok, double gamma,
+                                       void *user_data);
+
+/**
+ * Signature of the function that solves P z = r approximately and writes `z`.
+ */
+typedef int (*oif_ivp_prec_solve_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *r,
+                                       OIFArrayF64 *z, double gamma, double delta,
+                                       void *user_data);
+
+/**
+ * Signature of the function that writes the values of the event functions to `g`.
+ */
+typedef int (*oif_ivp_event_fn_t)(double t, OIFArrayF64 *y, OIFArrayF64 *g,
+                                  void *user_data);
+
+/**
+ * Indices of the statistics in the array filled by `oif_ivp_get_stats`.
+ */
+enum {
+    OIF_IVP_STAT_NUM_STEPS = 0,            // Number of steps
+    OIF_IVP_STAT_NUM_RHS_EVALS,            // Number of right-hand side evaluations
+    OIF_IVP_STAT_NUM_NONLINEAR_ITERS,      // Number of nonlinear solver iterations
+    OIF_IVP_STAT_NUM_NONLINEAR_CONV_FAILS, // Number of nonlinear convergence failures
+    OIF_IVP_STAT_NUM_ERROR_TEST_FAILS,     // Number of steps rejected by the error test
+    OIF_IVP_STAT_NUM_JAC_EVALS,            // Number of Jacobian evaluations
+    OIF_IVP_STAT_LAST_STEP,                // Size of the last step
+    OIF_IVP_STAT_WORKSPACE_BYTES,          // Size of the workspace of the integrator
+    OIF_IVP_STAT_RHS_TIME,                 // Time spent in the right-hand side, seconds
+    OIF_IVP_NUM_STATS,
+};
+
 /**
  * Set right hand side of the system of ordinary differential equations.
  */
@@ -15,10 +69,56 @@ oif_ivp_set_rhs_fn(oif_ivp_rhs_fn_t rhs);
 
 /**
  * Set initial value y(t0) = y0.
+ *
+ * If the number of equations changes, the Jacobian functions,
+ * the sparsity pattern, and the preconditioner set before are discarded,
+ * as they are specific to the size of the system.
  */
 int
 oif_ivp_set_initial_value(OIFArrayF64 *y0, double t0);
 
+/**
+ * Set the function that computes the dense Jacobian.
+ */
+int
+oif_ivp_set_jac_fn(oif_ivp_jac_fn_t jac);
+
+/**
+ * Set the function that computes the sparse Jacobian with the CSR pattern
+ * given by `indptr` and `indices` (indices stored as floating-point numbers).
+ * Return nonzero if the pattern is invalid: `indptr[0]` is not zero,
+ * `indptr` decreases, or `indices` are not within [0, N).
+ */
+int
+oif_ivp_set_jac_csr_fn(oif_ivp_jac_csr_fn_t jac, OIFArrayF64 *indptr, OIFArrayF64 *indices);
+
+/**
+ * Set the function that computes Jacobian-vector products.
+ */
+int
+oif_ivp_set_jac_times_fn(oif_ivp_jac_times_fn_t jac_times);
+
+/**
+ * Set the preconditioner for matrix-free linear solvers.
+ */
+int
+oif_ivp_set_preconditioner(oif_ivp_prec_setup_fn_t setup, oif_ivp_prec_solve_fn_t solve);
+
+/**
+ * Set the event functions with their directions and whether they are terminal
+ * (arrays with `n_events` elements, which can be NULL when `n_events` is zero).
+ */
+int
+oif_ivp_set_events(int n_events, oif_ivp_event_fn_t event_fn, OIFArrayF64 *directions,
+                   OIFArrayF64 *terminal);
+
+/**
+ * Write the index of the last event (-1 if none) and its time (NaN if none)
+ * to `event->data[0]` and `event->data[1]`.
+ */
+int
+oif_ivp_get_last_event(OIFArrayF64 *event);
+
 /**
  * Set user data that can be used to pass additional information
  * to the right-hand side function.
@@ -26,8 +126,74 @@ oif_ivp_set_initial_value(OIFArrayF64 *y0, double t0);
 int
 oif_ivp_set_user_data(void *user_data);
 
+/**
+ * Set relative and absolute tolerances.
+ */
+int
+oif_ivp_set_tolerances(double rtol, double atol);
+
+/**
+ * Select the integrator (time-stepping method) by its name.
+ */
+int
+oif_ivp_set_integrator(const char *integrator_name);
+
+/**
+ * Set the option `name` that selects or configures the solvers to `value`.
+ */
+int
+oif_ivp_set_option(const char *name, const char *value);
+
+/**
+ * Print the supported options with their current and supported values.
+ */
+int
+oif_ivp_print_options(void);
+
 /**
  * Integrate to time `t` and write the solution to `y`.
  */
 int
 oif_ivp_integrate(double t, OIFArrayF64 *y);
+
+/**
+ * Integrate successively to each of `times` and write the solutions
+ * to the rows of `Y` with shape `(len(times), N)`.
+ *
+ * After a terminal event, the row for the first time after the event
+ * holds the solution at the event time, and the later rows are NaN.
+ */
+int
+oif_ivp_integrate_many(OIFArrayF64 *times, OIFArrayF64 *Y);
+
+/**
+ * Take one internal step towards `t_end`, but not beyond it,
+ * and write the reached time to `t->data[0]` and the solution to `y`.
+ */
+int
+oif_ivp_integrate_one_step(double t_end, OIFArrayF64 *t, OIFArrayF64 *y);
+
+/**
+ * Write the solution at time `t` within the last step to `y`.
+ */
+int
+oif_ivp_interpolate(double t, OIFArrayF64 *y);
+
+/**
+ * Write the statistics of the integrator to `stats` with `OIF_IVP_NUM_STATS`
+ * elements; unavailable statistics are NaN.
+ */
+int
+oif_ivp_get_stats(OIFArrayF64 *stats);
+
+/**
+ * Save the state of the integrator to the file `filename`.
+ */
+int
+oif_ivp_save_state(const char *filename);
+
+/**
+ * Restore the state of the integrator from the file `filename`.
+ */
+int
+oif_ivp_load_state(const char *filename);
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <oif/api.h>
+#include <oif_impl/ivp.h>
+
+/**
+ * Right-hand side of all members evaluated at once: writes f(t[m], Y[m, :])
+ * to `Ydot[m, :]`, where `Y` and `Ydot` have shape (M, N).
+ */
+typedef int (*oif_ivp_ensemble_rhs_batch_fn_t)(OIFArrayF64 *t, OIFArrayF64 *Y,
+                                               OIFArrayF64 *Ydot, void *user_data);
+
+/**
+ * Set initial values y_m(t0) = Y0[m, :] for the members m = 0, ..., M - 1.
+ */
+int
+oif_ivp_ensemble_set_initial_values(OIFArrayF64 *Y0, double t0);
+
+/**
+ * Set right hand side of the system of ordinary differential equations.
+ */
+int
+oif_ivp_ensemble_set_rhs_fn(oif_ivp_rhs_fn_t rhs);
+
+/**
+ * Set the right-hand side that is evaluated for all members at once
+ * and its user data, which is common for all members.
+ * Return nonzero when switching between it and `set_rhs_fn` after `integrate`
+ * without calling `set_initial_values` again.
+ */
+int
+oif_ivp_ensemble_set_rhs_batch_fn(oif_ivp_ensemble_rhs_batch_fn_t rhs, void *user_data);
+
+/**
+ * Set user data of the members: `user_data` points to an array of M pointers,
+ * and the right-hand side of member `m` receives the pointer with index `m`.
+ */
+int
+oif_ivp_ensemble_set_user_data(void *user_data);
+
+/**
+ * Set relative and absolute tolerances.
+ */
+int
+oif_ivp_ensemble_set_tolerances(double rtol, double atol);
+
+/**
+ * Select the integrator (time-stepping method) by its name.
+ */
+int
+oif_ivp_ensemble_set_integrator(const char *integrator_name);
+
+/**
+ * Set the number of threads; zero selects the number of available processors.
+ */
+int
+oif_ivp_ensemble_set_num_threads(int num_threads);
+
+/**
+ * Integrate all members to time `t`, write the solutions to the rows of `Y`
+ * and the status codes of the members to `status`.
+ */
+int
+oif_ivp_ensemble_integrate(double t, OIFArrayF64 *Y, OIFArrayF64 *status);
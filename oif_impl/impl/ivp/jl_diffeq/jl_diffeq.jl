@@ -1,64 +1,439 @@
 module JlDiffEq
-export Self, set_initial_value, set_rhs_fn, set_tolerances, integrate, set_user_data
+export Self, set_initial_value, set_rhs_fn, set_jac_fn, set_jac_csr_fn, set_jac_times_fn, set_tolerances, set_integrator, set_option, print_options, set_events, get_last_event, integrate, integrate_many, integrate_one_step, interpolate, get_stats, save_state, load_state, set_user_data
 
-using OrdinaryDiffEq: ODEProblem, Tsit5, init, step!
+using OrdinaryDiffEq: ODEFunction, ODEProblem, Tsit5, Vern7, Rodas5, TRBDF2, FBDF, init, step!, add_tstop!,
+    VectorContinuousCallback, get_proposed_dt, set_proposed_dt!
+using Serialization: serialize, deserialize
+using SparseArrays: SparseMatrixCSC, nonzeros, sparse
+
+# Supported integrators by name.
+# Unless provided, Jacobians for implicit methods are computed with finite differences
+# as right-hand sides from other languages cannot accept dual numbers.
+const INTEGRATORS = Dict{String,Function}(
+    "Tsit5" => () -> Tsit5(),
+    "Vern7" => () -> Vern7(),
+    "Rodas5" => () -> Rodas5(autodiff=false),
+    "TRBDF2" => () -> TRBDF2(autodiff=false),
+    "FBDF" => () -> FBDF(autodiff=false),
+)
 
 mutable struct Self
     t0::Float64
     y0::Vector{Float64}
     rhs
-    problem
+    # Jacobian in one of the forms: dense, sparse with CSR pattern, or its products.
+    jac
+    jac_prototype::Union{Nothing,SparseMatrixCSC{Float64,Int}}
+    jvp
+    user_data
+    integrator_name::String
+    reltol::Float64
+    abstol::Float64
     integrator
-    user_data::Tuple
+    # Time added as a stop time by `integrate_one_step`.
+    t_end::Float64
+    # Event functions with their directions and flags whether they are terminal.
+    events
+    # Last event that occurred during the integration: index (-1 if none) and time.
+    last_event_index::Int
+    last_event_t::Float64
+    # Set when a terminal event occurs to stop the integration.
+    event_stop::Bool
+    # Time spent in the right-hand side since the integrator was created, seconds.
+    rhs_time::Float64
     function Self()
-        return new(0.0, [])
+        # Default tolerances are the same as in OrdinaryDiffEq.
+        return new(
+            0.0, [], nothing, nothing, nothing, nothing, nothing, "Tsit5", 1e-3, 1e-6, nothing, NaN,
+            nothing, -1, NaN, false, 0.0,
+        )
     end
 end
 
-function set_initial_value(self::Self, y0, t0)::Int
+function set_initial_value(self::Self, y0::Vector{Float64}, t0::Float64)::Int
+    if length(y0) != length(self.y0)
+        # Jacobians are specific to the size of the system.
+        self.jac = nothing
+        self.jac_prototype = nothing
+        self.jvp = nothing
+    end
     self.t0 = t0
-    self.y0 = y0
+    # Copy as `y0` may wrap memory that belongs to the caller.
+    self.y0 = copy(y0)
+    _init_integrator!(self)
     return 0
 end
 
 function set_rhs_fn(self::Self, rhs)::Int
+    if isempty(self.y0)
+        throw(MethodError("Method `set_initial_value` must be called before `set_rhs_fn`"))
+    end
     self.rhs = rhs
+    _init_integrator!(self)
+    return 0
+end
 
-    if !isempty(self.y0)
-        if !isdefined(self, :user_data)
-            self.problem = ODEProblem(
-                _rhs_wrapper(rhs), self.y0, (self.t0, Inf)
-            )
-        else
-            self.problem = ODEProblem(
-                _rhs_wrapper(rhs), self.y0, (self.t0, Inf), self.user_data
-            )
+"""
+Set the function `jac(t, y, J, user_data)` that writes the Jacobian
+to `J` in row-major order, as functions from other languages do.
+"""
+function set_jac_fn(self::Self, jac)::Int
+    N = length(self.y0)
+    J_row_major = Matrix{Float64}(undef, N, N)
+    function jac_wrapper(J, u, p, t)
+        jac(t, u, J_row_major, p)
+        permutedims!(J, J_row_major, (2, 1))
+        return nothing
+    end
+    self.jac = jac_wrapper
+    self.jac_prototype = nothing
+    self.jvp = nothing
+    _init_integrator!(self)
+    return 0
+end
+
+"""
+Set the function `jac(t, y, data, user_data)` that writes the nonzero values
+of the Jacobian in the order of the CSR pattern given by `indptr` and `indices`
+(zero-based, stored as floating-point numbers).
+"""
+function set_jac_csr_fn(self::Self, jac, indptr::Vector{Float64}, indices::Vector{Float64})::Int
+    N = length(self.y0)
+    nnz = length(indices)
+    rows = Vector{Int}(undef, nnz)
+    for i in 1:N
+        rows[Int(indptr[i])+1:Int(indptr[i+1])] .= i
+    end
+    cols = Int.(indices) .+ 1
+    # Julia stores sparse matrices in the CSC format, so the nonzeros are permuted:
+    # `perm[k]` is the position in the CSR order of the `k`-th nonzero in the CSC order.
+    perm_matrix = sparse(rows, cols, collect(1:nnz), N, N)
+    perm = nonzeros(perm_matrix)
+    data = Vector{Float64}(undef, nnz)
+    function jac_wrapper(J, u, p, t)
+        jac(t, u, data, p)
+        J_nonzeros = nonzeros(J)
+        @inbounds for k in eachindex(perm)
+            J_nonzeros[k] = data[perm[k]]
         end
-        self.integrator = init(self.problem, Tsit5())
-    else
-        throw(MethodError("Method `set_initial_value` must be called before `set_rhs_fn`"))
+        return nothing
     end
+    self.jac = jac_wrapper
+    self.jac_prototype = SparseMatrixCSC{Float64,Int}(
+        N, N, perm_matrix.colptr, perm_matrix.rowval, zeros(nnz)
+    )
+    self.jvp = nothing
+    _init_integrator!(self)
+    return 0
+end
+
+"""
+Set the function `jac_times(t, y, v, Jv, user_data)` that writes
+the Jacobian-vector product to `Jv`.
+
+It is used by integrators with matrix-free (Krylov) linear solvers.
+"""
+function set_jac_times_fn(self::Self, jac_times)::Int
+    self.jvp = (Jv, v, u, p, t) -> jac_times(t, u, v, Jv, p)
+    self.jac = nothing
+    self.jac_prototype = nothing
+    _init_integrator!(self)
     return 0
 end
 
 function set_tolerances(self::Self, rtol::Float64, atol::Float64)::Int
-    println("I am setting tolerances: NOT IMPLEMENTED")
+    self.reltol = rtol
+    self.abstol = atol
+    _init_integrator!(self)
+    return 0
+end
+
+function set_integrator(self::Self, integrator_name::String)::Int
+    if !haskey(INTEGRATORS, integrator_name)
+        supported = join(sort(collect(keys(INTEGRATORS))), ", ")
+        throw(ArgumentError(
+            "Unknown integrator '$integrator_name', supported integrators: $supported"
+        ))
+    end
+    self.integrator_name = integrator_name
+    _init_integrator!(self)
+    return 0
+end
+
+"""
+Integrators are configured by their names only, so there are no options.
+"""
+function set_option(self::Self, name::String, value::String)::Int
+    throw(ArgumentError("Unknown option '$name', the implementation has no options"))
+end
+
+function print_options(self::Self)::Int
+    supported = join(sort(collect(keys(INTEGRATORS))), ", ")
+    println("Options of jl_diffeq (current value: supported values)")
+    println("  integrator  $(self.integrator_name): $supported (set with `set_integrator`)")
+    return 0
+end
+
+"""
+Set the function `event_fn(t, y, g, user_data)` of `n_events` events
+that are located with `VectorContinuousCallback`.
+"""
+function set_events(
+    self::Self, n_events::Int, event_fn, directions::Vector{Float64}, terminal::Vector{Float64}
+)::Int
+    if length(directions) != n_events || length(terminal) != n_events
+        throw(ArgumentError("Arrays `directions` and `terminal` must have $n_events elements"))
+    end
+    if n_events == 0
+        self.events = nothing
+    else
+        self.events = (fn=event_fn, directions=sign.(directions), terminal=terminal .!= 0)
+    end
+    self.last_event_index = -1
+    self.last_event_t = NaN
+    _init_integrator!(self)
+    return 0
+end
+
+function get_last_event(self::Self, event::Vector{Float64})::Int
+    event[1] = self.last_event_index
+    event[2] = self.last_event_t
     return 0
 end
 
 function integrate(self::Self, t::Float64, y::Vector{Float64})::Int
-    step!(self.integrator, t - self.integrator.t, true)
-    y[:] = self.integrator.u
+    if isnothing(self.events)
+        step!(self.integrator, t - self.integrator.t, true)
+    else
+        _step_until_event!(self, t)
+    end
+    y .= self.integrator.u
+    return 0
+end
+
+"""
+Integrate successively to each of `times` and write the solutions to rows of `Y`.
+
+`Y` wraps a row-major array with shape `(length(times), N)`,
+so the solutions are written to the columns of its `(N, length(times))` reshape.
+"""
+function integrate_many(self::Self, times::Vector{Float64}, Y::Matrix{Float64})::Int
+    Yt = reshape(Y, length(self.y0), length(times))
+    if !isnothing(self.events)
+        self.last_event_index = -1
+        self.last_event_t = NaN
+        self.event_stop = false
+    end
+    for (i, t) in enumerate(times)
+        if isnothing(self.events)
+            step!(self.integrator, t - self.integrator.t, true)
+        elseif self.event_stop
+            # The solution after a terminal event is not computed.
+            Yt[:, i] .= NaN
+            continue
+        else
+            _step_until_event!(self, t; reset_last_event=false)
+        end
+        Yt[:, i] .= self.integrator.u
+    end
+    return 0
+end
+
+"""
+Take one step of the size chosen by the integrator towards `t_end`, but not beyond it.
+"""
+function integrate_one_step(self::Self, t_end::Float64, t::Vector{Float64}, y::Vector{Float64})::Int
+    if t_end != self.t_end
+        add_tstop!(self.integrator, t_end)
+        self.t_end = t_end
+    end
+    self.last_event_index = -1
+    self.last_event_t = NaN
+    self.event_stop = false
+    step!(self.integrator)
+    t[1] = self.integrator.t
+    y .= self.integrator.u
+    return 0
+end
+
+"""
+Evaluate the interpolant of the integrator within the last step.
+"""
+function interpolate(self::Self, t::Float64, y::Vector{Float64})::Int
+    if !(self.integrator.tprev <= t <= self.integrator.t)
+        throw(DomainError(t, "Time is outside of the last step " *
+                             "[$(self.integrator.tprev), $(self.integrator.t)]"))
+    end
+    self.integrator(y, t)
+    return 0
+end
+
+"""
+Write the statistics of the integrator in the order of `OIF_IVP_STAT_*` constants
+of the C interface, taking the counters from `integrator.stats`.
+"""
+function get_stats(self::Self, stats::Vector{Float64})::Int
+    stats .= NaN
+    if isnothing(self.integrator)
+        return 0
+    end
+    s = self.integrator.stats
+    stats[1] = s.naccept
+    stats[2] = s.nf
+    stats[3] = s.nnonliniter
+    stats[4] = s.nnonlinconvfail
+    stats[5] = s.nreject
+    stats[6] = s.njacs
+    stats[7] = self.integrator.t - self.integrator.tprev
+    stats[9] = self.rhs_time
+    return 0
+end
+
+# Version of the saved state, which is stored to detect incompatible files.
+const STATE_FORMAT = "jl_diffeq/1"
+
+"""
+Save the time, the solution, and the step size proposed for the next step to `filename`.
+
+The caches of the integrator are not saved, as they refer to the right-hand side,
+so multistep integrators, such as `FBDF`, resume from the first order.
+"""
+function save_state(self::Self, filename::String)::Int
+    if isnothing(self.integrator)
+        throw(ErrorException("Initial value and right-hand side must be set before saving the state"))
+    end
+    state = (
+        format=STATE_FORMAT,
+        integrator_name=self.integrator_name,
+        t=self.integrator.t,
+        u=copy(self.integrator.u),
+        dt=get_proposed_dt(self.integrator),
+    )
+    serialize(filename, state)
+    return 0
+end
+
+"""
+Restart the integration from the state saved with `save_state`.
+
+The saved state replaces the initial value and the integrator.
+"""
+function load_state(self::Self, filename::String)::Int
+    if isnothing(self.integrator)
+        throw(ErrorException("Initial value and right-hand side must be set before loading the state"))
+    end
+    state = deserialize(filename)
+    if !(state isa NamedTuple) || get(state, :format, nothing) != STATE_FORMAT
+        throw(ArgumentError("File '$filename' does not contain a saved state"))
+    end
+    if length(state.u) != length(self.y0)
+        throw(DimensionMismatch("Saved state has $(length(state.u)) equations, " *
+                                "but the initial value has $(length(self.y0))"))
+    end
+    self.t0 = state.t
+    self.y0 = state.u
+    self.integrator_name = state.integrator_name
+    self.last_event_index = -1
+    self.last_event_t = NaN
+    self.event_stop = false
+    _init_integrator!(self)
+    set_proposed_dt!(self.integrator, state.dt)
     return 0
 end
 
 function set_user_data(self::Self, user_data)::Int
     self.user_data = user_data
+    _init_integrator!(self)
+    return 0
+end
+
+"""
+Create the integrator from the current settings, starting at the initial value.
+
+Intermediate steps are not saved, so that memory usage does not grow
+with the number of steps, but the interpolant over the last step is kept.
+"""
+function _init_integrator!(self::Self)
+    if isnothing(self.rhs) || isempty(self.y0)
+        return
+    end
+
+    tspan = (self.t0, Inf)
+    callback = isnothing(self.events) ? nothing : _event_callback(self)
+    fn = ODEFunction{true}(
+        _rhs_wrapper(self); jac=self.jac, jac_prototype=self.jac_prototype, jvp=self.jvp
+    )
+    if isnothing(self.user_data)
+        problem = ODEProblem{true}(fn, copy(self.y0), tspan)
+    else
+        problem = ODEProblem{true}(fn, copy(self.y0), tspan, self.user_data)
+    end
+    self.rhs_time = 0.0
+    self.integrator = init(
+        problem,
+        INTEGRATORS[self.integrator_name]();
+        reltol=self.reltol,
+        abstol=self.abstol,
+        save_everystep=false,
+        save_on=false,
+        save_start=false,
+        save_end=false,
+        dense=false,
+        calck=true,
+        callback=callback,
+    )
+    self.t_end = NaN
+end
+
+"""
+Take steps until time `t` or until a terminal event occurs.
+
+The callback shortens the step that contains an event, so that it ends at the event.
+"""
+function _step_until_event!(self::Self, t::Float64; reset_last_event::Bool=true)
+    if reset_last_event
+        self.last_event_index = -1
+        self.last_event_t = NaN
+    end
+    self.event_stop = false
+    if t > self.integrator.t
+        add_tstop!(self.integrator, t)
+    end
+    while self.integrator.t < t && !self.event_stop
+        step!(self.integrator)
+    end
+end
+
+function _event_callback(self::Self)
+    events = self.events
+    function condition(out, u, t, integrator)
+        events.fn(t, u, out, integrator.p)
+    end
+    # `VectorContinuousCallback` calls `affect!` for the crossings
+    # from negative to positive values and `affect_neg!` for the opposite ones.
+    function record!(i, direction, t)
+        d = events.directions[i]
+        if (d != 0 && d != direction) || self.event_stop
+            return
+        end
+        self.last_event_index = i - 1
+        self.last_event_t = t
+        self.event_stop = events.terminal[i]
+    end
+    affect!(integrator, i) = record!(i, 1, integrator.t)
+    affect_neg!(integrator, i) = record!(i, -1, integrator.t)
+    return VectorContinuousCallback(
+        condition, affect!, affect_neg!, length(events.directions); save_positions=(false, false)
+    )
 end
 
-function _rhs_wrapper(rhs)
+function _rhs_wrapper(self::Self)
+    rhs = self.rhs
     function wrapper(du, u, p, t)
-        return rhs(t, u, du, p)
+        start = time_ns()
+        status = rhs(t, u, du, p)
+        self.rhs_time += (time_ns() - start) * 1e-9
+        return status
     end
     return wrapper
 end
@@ -1,9 +1,18 @@
+import time
+
 import numpy as np
-from oif.impl.ivp import IVPInterface
-from scipy import integrate
+from oif.impl.ivp import STATS, IVPInterface
+from scipy import integrate, optimize
 
 _prefix = "scipy_ode_dopri5"
 
+# Explicit Runge--Kutta integrators of `scipy.integrate.ode` with the same options.
+_INTEGRATORS = ("dopri5", "dop853")
+
+# The same methods with step-by-step interface and dense output,
+# which `scipy.integrate.ode` does not expose.
+_STEPPERS = {"dopri5": integrate.RK45, "dop853": integrate.DOP853}
+
 
 class Dopri5(IVPInterface):
     def __init__(self):
@@ -11,6 +20,19 @@ class Dopri5(IVPInterface):
         self.N = 0  # Problem dimension.
         self.s = None
         self.user_data = None
+        self.integrator_name = "dopri5"
+        self.rtol = 1e-15
+        self.atol = 1e-15
+        self.stepper = None  # Used by `integrate_one_step`.
+        self.dense_output = None  # Interpolant over the last step.
+        self.event_fn = None
+        self.event_directions = None
+        self.event_terminal = None
+        self.last_event = (-1, np.nan)
+        # Time at which the last terminal event stopped the integration.
+        self.t_terminal_event = np.nan
+        self.num_rhs_evals = 0
+        self.rhs_time = 0.0
 
     def set_initial_value(self, y0: np.ndarray, t0: float):
         _p = f"[{_prefix}::set_initial_value]"
@@ -22,6 +44,13 @@ class Dopri5(IVPInterface):
         self.t0 = t0
         self.N = len(y0)
         self.ydot = np.empty_like(y0)
+        if self.s is not None:
+            self.s.set_initial_value(self.y0, self.t0)
+        self.stepper = None
+        self.dense_output = None
+        self.t_terminal_event = np.nan
+        self.num_rhs_evals = 0
+        self.rhs_time = 0.0
 
     def set_rhs_fn(self, rhs):
         if self.N <= 0:
@@ -32,10 +61,8 @@ class Dopri5(IVPInterface):
         msg = "Wrong signature for the right-hand side function"
         assert len(self._rhs_fn_wrapper(42.0, x)) == len(x), msg
 
-        self.s = integrate.ode(self._rhs_fn_wrapper).set_integrator(
-            "dopri5", atol=1e-15, rtol=1e-15, nsteps=1000
-        )
-        self.s.set_initial_value(self.y0, self.t0)
+        self.s = integrate.ode(self._rhs_fn_wrapper)
+        self._set_integrator()
 
         # if hasattr(self, "user_data"):
         #     self.s.set_f_params(self.user_data)
@@ -43,12 +70,54 @@ class Dopri5(IVPInterface):
 
         return 0
 
+    # Explicit Runge--Kutta methods do not use the Jacobian or preconditioners,
+    # so they are accepted for compatibility with other implementations and ignored.
+    def set_jac_fn(self, jac):
+        return 0
+
+    def set_jac_csr_fn(self, jac, indptr, indices):
+        return 0
+
+    def set_jac_times_fn(self, jac_times):
+        return 0
+
+    def set_preconditioner(self, setup, solve):
+        return 0
+
+    def set_events(self, n_events, event_fn, directions, terminal):
+        if len(directions) != n_events or len(terminal) != n_events:
+            raise ValueError(
+                f"[{_prefix}::set_events] Arrays `directions` and `terminal` "
+                f"must have {n_events} elements"
+            )
+        self.event_fn = event_fn if n_events > 0 else None
+        self.event_directions = np.sign(directions)
+        self.event_terminal = np.asarray(terminal) != 0
+        self.last_event = (-1, np.nan)
+        self.t_terminal_event = np.nan
+        return 0
+
+    def get_last_event(self, event):
+        event[0], event[1] = self.last_event
+        return 0
+
     def set_tolerances(self, rtol, atol):
         if self.s is None:
             raise RuntimeError("`set_rhs_fn` must be called before `set_tolerances`")
-        self.s.set_integrator("dopri5", rtol=rtol, atol=atol, nsteps=1000)
-        if hasattr(self, "y0"):
-            self.s.set_initial_value(self.y0, self.t0)
+        self.rtol = rtol
+        self.atol = atol
+        self._set_integrator()
+        return 0
+
+    def set_integrator(self, integrator_name):
+        if integrator_name not in _INTEGRATORS:
+            raise ValueError(
+                f"[{_prefix}::set_integrator] Unknown integrator '{integrator_name}', "
+                f"supported integrators: {', '.join(_INTEGRATORS)}"
+            )
+        self.integrator_name = integrator_name
+        if self.s is not None:
+            self._set_integrator()
         return 0
 
     def set_user_data(self, user_data):
@@ -60,11 +129,186 @@ class Dopri5(IVPInterface):
         self.user_data = user_data
 
     def integrate(self, t, y):
+        self.stepper = None
+        self.last_event = (-1, np.nan)
+        if self.event_fn is not None:
+            y[:] = self._integrate_with_events(t)
+            return 0
         y[:] = self.s.integrate(t)
         assert self.s.successful()
         return 0
 
+    def integrate_many(self, times, Y):
+        self.stepper = None
+        self.last_event = (-1, np.nan)
+        if self.event_fn is not None:
+            stopped = False
+            for i, t in enumerate(times):
+                # The solution after a terminal event is not computed.
+                if stopped:
+                    Y[i] = np.nan
+                    continue
+                Y[i] = self._integrate_with_events(t)
+                stopped = self.s.t != t
+            return 0
+
+        s = self.s
+        for i, t in enumerate(times):
+            Y[i] = s.integrate(t)
+            if not s.successful():
+                raise RuntimeError(
+                    f"[{_prefix}::integrate_many] Integration to t = {t} failed"
+                )
+        return 0
+
+    def integrate_one_step(self, t_end, t, y):
+        stepper = self.stepper
+        if stepper is None or stepper.t_bound != t_end:
+            stepper = _STEPPERS[self.integrator_name](
+                lambda t, y: self._rhs_fn_wrapper(t, y).copy(),
+                self.s.t,
+                self.s.y,
+                t_end,
+                rtol=self.rtol,
+                atol=self.atol,
+            )
+            self.stepper = stepper
+
+        self.last_event = (-1, np.nan)
+        if self.event_fn is not None:
+            g_old = self._events(stepper.t, stepper.y)
+        message = stepper.step()
+        if stepper.status == "failed":
+            raise RuntimeError(f"[{_prefix}::integrate_one_step] {message}")
+        self.dense_output = stepper.dense_output()
+        t_new, y_new = stepper.t, stepper.y
+        if self.event_fn is not None:
+            g_new = self._events(stepper.t, stepper.y)
+            stop = self._locate_events(self.dense_output, g_old, g_new)
+            if stop is not None:
+                t_new, y_new = stop
+                self.stepper = None
+        # Continue from the reached state on subsequent calls to `integrate`.
+        self.s.set_initial_value(y_new, t_new)
+
+        t[0] = t_new
+        y[:] = y_new
+        return 0
+
+    def interpolate(self, t, y):
+        dense_output = self.dense_output
+        if dense_output is None:
+            raise RuntimeError(
+                f"[{_prefix}::interpolate] `integrate_one_step` must be called first"
+            )
+        if not dense_output.t_min <= t <= dense_output.t_max:
+            raise ValueError(
+                f"[{_prefix}::interpolate] Time {t} is outside of the last step "
+                f"[{dense_output.t_min}, {dense_output.t_max}]"
+            )
+        y[:] = dense_output(t)
+        return 0
+
+    def get_stats(self, stats):
+        """Write the number of right-hand side evaluations and the time spent in them.
+
+        `scipy.integrate.ode` does not report its step counts,
+        so only the size of the last step taken step by step is known.
+        """
+        stats[:] = np.nan
+        stats[STATS.index("num_rhs_evals")] = self.num_rhs_evals
+        stats[STATS.index("rhs_time")] = self.rhs_time
+        if self.dense_output is not None:
+            sol = self.dense_output
+            stats[STATS.index("last_step")] = sol.t_max - sol.t_min
+        return 0
+
+    def _integrate_with_events(self, t_end):
+        """Integrate with the step-by-step method, locating the events in each step.
+
+        Returns the solution at `t_end` or at the time of the terminal event.
+        """
+        stepper = _STEPPERS[self.integrator_name](
+            lambda t, y: self._rhs_fn_wrapper(t, y).copy(),
+            self.s.t,
+            self.s.y,
+            t_end,
+            rtol=self.rtol,
+            atol=self.atol,
+        )
+        g_old = self._events(stepper.t, stepper.y)
+        while stepper.status == "running":
+            message = stepper.step()
+            if stepper.status == "failed":
+                raise RuntimeError(f"[{_prefix}::integrate] {message}")
+            self.dense_output = stepper.dense_output()
+            g_new = self._events(stepper.t, stepper.y)
+            stop = self._locate_events(self.dense_output, g_old, g_new)
+            if stop is not None:
+                self.s.set_initial_value(stop[1], stop[0])
+                return stop[1]
+            g_old = g_new
+        self.s.set_initial_value(stepper.y, stepper.t)
+        return stepper.y
+
+    def _locate_events(self, sol, g_old, g_new):
+        """Find the events within the step covered by the dense output `sol`.
+
+        The events are detected by the sign changes of the event functions
+        and located with Brent's method, as in `scipy.integrate.solve_ivp`.
+        Records the last event before the first terminal one and returns
+        the time and the solution at the terminal event, or None.
+        """
+        d = self.event_directions
+        up = (g_old <= 0) & (g_new >= 0)
+        down = (g_old >= 0) & (g_new <= 0)
+        active = ((up & (d >= 0)) | (down & (d <= 0))) & ((g_old != 0) | (g_new != 0))
+        if not np.any(active):
+            return None
+
+        t_old, t_new = sol.t_min, sol.t_max
+        xtol = 4 * np.finfo(float).eps * max(1.0, abs(t_old), abs(t_new))
+        events = []
+        for i in np.nonzero(active)[0]:
+            if g_old[i] == 0:
+                t_event = t_old
+            else:
+                t_event = optimize.brentq(
+                    lambda t: self._events(t, sol(t))[i], t_old, t_new, xtol=xtol
+                )
+            # The event at which the previous integration stopped
+            # must not stop the integration again.
+            if abs(t_event - self.t_terminal_event) <= 2 * xtol:
+                continue
+            events.append((t_event, i))
+
+        for t_event, i in sorted(events):
+            self.last_event = (int(i), t_event)
+            if self.event_terminal[i]:
+                self.t_terminal_event = t_event
+                return t_event, sol(t_event)
+        return None
+
+    def _events(self, t, y):
+        g = np.empty(len(self.event_directions))
+        self.event_fn(t, y, g, self.user_data)
+        return g
+
+    def _set_integrator(self):
+        self.s.set_integrator(
+            self.integrator_name, rtol=self.rtol, atol=self.atol, nsteps=1000
+        )
+        if hasattr(self, "y0"):
+            self.s.set_initial_value(self.y0, self.t0)
+        self.stepper = None
+        self.dense_output = None
+        self.num_rhs_evals = 0
+        self.rhs_time = 0.0
+
     def _rhs_fn_wrapper(self, t, y):
         """Callback that satisfies scipy.ode.dopri5 expectations."""
+        start = time.perf_counter()
         self.rhs(t, y, self.ydot, self.user_data)
+        self.rhs_time += time.perf_counter() - start
+        self.num_rhs_evals += 1
         return self.ydot
@@ -4,20 +4,46 @@
  * using Adams multistep method and stiff problems using BDF method.
  * See https://sundials.readthedocs.io/en/latest/cvode/Usage/index.html
  *
+ * For large systems, the vector operations of CVODE can run on several threads
+ * with the OpenMP or Pthreads vectors, if Sundials is built with them,
+ * over the same memory as the serial vector (option `num_threads`).
+ *
  * This code uses the following types from Sundials:
  * - sunrealtype – the floating-point type
  * - sunindextype – the integer type used for vector and matrix indices
  */
 #include <assert.h>
+#include <errno.h>
 #include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include <cvode/cvode.h>
 #include <nvector/nvector_serial.h>
+#if defined(OIF_HAVE_NVECOPENMP)
+#include <nvector/nvector_openmp.h>
+#elif defined(OIF_HAVE_NVECPTHREADS)
+#include <nvector/nvector_pthreads.h>
+#endif
 #include <sundials/sundials_nvector.h>
 #include <sundials/sundials_types.h>
+#include <sunlinsol/sunlinsol_band.h>
 #include <sunlinsol/sunlinsol_dense.h>
+#include <sunlinsol/sunlinsol_spbcgs.h>
+#include <sunlinsol/sunlinsol_spgmr.h>
+#include <sunmatrix/sunmatrix_band.h>
 #include <sunmatrix/sunmatrix_dense.h>
+#if defined(OIF_HAVE_KLU)
+#include <sunlinsol/sunlinsol_klu.h>
+#include <sunmatrix/sunmatrix_sparse.h>
+#endif
 #include <sunnonlinsol/sunnonlinsol_fixedpoint.h>
+#include <sunnonlinsol/sunnonlinsol_newton.h>
 
 #include "oif/api.h"
 #include "oif_impl/ivp.h"
@@ -32,15 +58,123 @@ static oif_ivp_rhs_fn_t OIF_RHS_FN;
 static int
 cvode_rhs(sunrealtype t, N_Vector u, N_Vector u_dot, void *user_data);
 
+// Jacobian provided by the `IVP` interface: at most one of these is set.
+static oif_ivp_jac_fn_t OIF_JAC_FN;
+static oif_ivp_jac_csr_fn_t OIF_JAC_CSR_FN;
+static oif_ivp_jac_times_fn_t OIF_JAC_TIMES_FN;
+
+// Preconditioner for the matrix-free linear solvers.
+static oif_ivp_prec_setup_fn_t OIF_PREC_SETUP_FN;
+static oif_ivp_prec_solve_fn_t OIF_PREC_SOLVE_FN;
+
+// Event functions, whose zero crossings are located by the CVODE rootfinding.
+static oif_ivp_event_fn_t OIF_EVENT_FN;
+static int NUM_EVENTS;
+// Directions of the zero crossings (-1, 0, 1) in the format of `CVodeSetRootDirection`.
+static int *EVENT_DIRECTIONS;
+static bool *EVENT_TERMINAL;
+// Buffer for `CVodeGetRootInfo`.
+static int *EVENTS_FOUND;
+// Last event that occurred during the integration: index (-1 if none) and time.
+static int LAST_EVENT_INDEX = -1;
+static sunrealtype LAST_EVENT_T = NAN;
+
+static int
+cvode_events(sunrealtype t, N_Vector y, sunrealtype *gout, void *user_data);
+
+// CSR sparsity pattern of the Jacobian for `OIF_JAC_CSR_FN`.
+static sunindextype *JAC_CSR_INDPTR;
+static sunindextype *JAC_CSR_INDICES;
+
+// Row-major dense Jacobian or nonzero values of the sparse Jacobian
+// written by the user-provided function.
+static sunrealtype *JAC_BUFFER;
+
+// Attached solvers and the matrix for matrix-based linear solvers.
+static SUNMatrix JAC_MATRIX;
+static SUNLinearSolver LINEAR_SOLVER;
+static SUNNonlinearSolver NONLINEAR_SOLVER;
+
+static int
+cvode_jac(sunrealtype t, N_Vector y, N_Vector fy, SUNMatrix J, void *user_data, N_Vector tmp1,
+          N_Vector tmp2, N_Vector tmp3);
+
+static int
+cvode_jac_csr(sunrealtype t, N_Vector y, N_Vector fy, SUNMatrix J, void *user_data,
+              N_Vector tmp1, N_Vector tmp2, N_Vector tmp3);
+
+static int
+cvode_jac_times(N_Vector v, N_Vector Jv, sunrealtype t, N_Vector y, N_Vector fy,
+                void *user_data, N_Vector tmp);
+
+static int
+cvode_prec_setup(sunrealtype t, N_Vector y, N_Vector fy, sunbooleantype jok,
+                 sunbooleantype *jcurPtr, sunrealtype gamma, void *user_data);
+
+static int
+cvode_prec_solve(sunrealtype t, N_Vector y, N_Vector fy, N_Vector r, N_Vector z,
+                 sunrealtype gamma, sunrealtype delta, int lr, void *user_data);
+
+static int
+setup_solvers_(N_Vector y);
+
+static int
+setup_events_(void);
+
+// Linear multistep method: `CV_ADAMS` or `CV_BDF`.
+static int LMM = CV_ADAMS;
+
+// Options that select the nonlinear and linear solvers, see `set_option`.
+// With `NLS_AUTO_` the fixed-point iteration is used for the Adams method
+// without the Jacobian, and Newton iteration otherwise.
+// With `LS_AUTO_` the dense direct solver is used, unless Jacobian-vector products
+// or the preconditioner are provided, in which case the matrix-free GMRES solver is used,
+// or the sparse Jacobian is provided and Sundials is built with KLU.
+enum nonlinear_solver_type_ { NLS_AUTO_, NLS_FIXED_POINT_, NLS_NEWTON_ };
+enum linear_solver_type_ { LS_AUTO_, LS_DENSE_, LS_BAND_, LS_SPGMR_, LS_SPBCGS_, LS_KLU_ };
+
+static const char *NONLINEAR_SOLVER_NAMES[] = {"auto", "fixed_point", "newton"};
+static const char *LINEAR_SOLVER_NAMES[] = {"auto", "dense", "band", "spgmr", "spbcgs", "klu"};
+
+static enum nonlinear_solver_type_ NONLINEAR_SOLVER_TYPE = NLS_AUTO_;
+static enum linear_solver_type_ LINEAR_SOLVER_TYPE = LS_AUTO_;
+// Number of previous iterates used in the Anderson acceleration
+// of the fixed-point iteration; zero disables acceleration.
+static long ANDERSON_DEPTH = 0;
+// Bandwidths of the Jacobian for the banded linear solver.
+static long UPPER_BANDWIDTH = 0;
+static long LOWER_BANDWIDTH = 0;
+// Maximum dimension of the Krylov subspace; zero selects the Sundials default.
+static long MAX_KRYLOV_DIM = 0;
+// Number of threads for the vector operations; one selects the serial vector.
+static long NUM_THREADS = 1;
+
 // Global state of the module.
 // Sundials context
 static SUNContext sunctx;
 // CVode memory block.
 void *cvode_mem;
+// Linear multistep method of the memory block.
+static int CVODE_LMM;
+// Vector that wraps the arrays passed by the caller, so that no vector
+// is created during integration, and the number of threads it uses.
+static N_Vector Y_WRAPPER;
+static long Y_WRAPPER_NUM_THREADS;
 
 /** Number of equations */
 sunindextype N;
 
+// Initial value and settings that are applied when CVODE memory block is created.
+static sunrealtype *Y0;
+static sunrealtype T0;
+// Time of the solution returned last, at which the state is saved.
+static sunrealtype T_CURRENT;
+// Time spent in the right-hand side function since the initialization, seconds.
+static double RHS_TIME;
+static sunrealtype RTOL = 1e-15;
+static sunrealtype ATOL = 1e-15;
+static void *USER_DATA;
+
 /*
  * In Sundials 7.0, `SUNContext_Create` accepts `SUNComm` instead of `void *`
  * as the first argument.
@@ -50,6 +184,147 @@ sunindextype N;
 #define SUN_COMM_NULL NULL
 #endif
 
+static void
+free_solvers_(void)
+{
+    if (NONLINEAR_SOLVER != NULL) {
+        SUNNonlinSolFree(NONLINEAR_SOLVER);
+        NONLINEAR_SOLVER = NULL;
+    }
+    if (LINEAR_SOLVER != NULL) {
+        SUNLinSolFree(LINEAR_SOLVER);
+        LINEAR_SOLVER = NULL;
+    }
+    if (JAC_MATRIX != NULL) {
+        SUNMatDestroy(JAC_MATRIX);
+        JAC_MATRIX = NULL;
+    }
+}
+
+// Point the wrapper vector to `data` with N elements.
+static N_Vector
+wrap_(sunrealtype *data)
+{
+    N_VSetArrayPointer(data, Y_WRAPPER);
+    return Y_WRAPPER;
+}
+
+/**
+ * Create the vector of the type selected by the number of threads over `data`.
+ * CVODE creates all its internal vectors by cloning this one.
+ */
+static N_Vector
+make_vector_(sunrealtype *data)
+{
+#if defined(OIF_HAVE_NVECOPENMP)
+    if (NUM_THREADS > 1) {
+        return N_VMake_OpenMP(N, data, (int)NUM_THREADS, sunctx);
+    }
+#elif defined(OIF_HAVE_NVECPTHREADS)
+    if (NUM_THREADS > 1) {
+        return N_VMake_Pthreads(N, data, (int)NUM_THREADS, sunctx);
+    }
+#endif
+    return N_VMake_Serial(N, data, sunctx);
+}
+
+/**
+ * Create CVODE memory block with the current method, starting at the initial value.
+ *
+ * If the memory block already exists for the same method, number of equations,
+ * and number of threads, it is reinitialized instead, so that the attached solvers
+ * and the rootfinding problem, along with their memory, are reused.
+ */
+static int
+init_cvode_(void)
+{
+    int status;  // Check errors
+
+    if (cvode_mem != NULL && CVODE_LMM == LMM && N_VGetLength(Y_WRAPPER) == N &&
+        Y_WRAPPER_NUM_THREADS == NUM_THREADS) {
+        status = CVodeReInit(cvode_mem, T0, wrap_(Y0));
+        if (status != CV_SUCCESS) {
+            fprintf(stderr, "%s CVodeReInit call failed with code %d\n", prefix, status);
+            return 1;
+        }
+        // Let CVODE estimate the initial step, which could be set by `load_state`.
+        CVodeSetInitStep(cvode_mem, 0.0);
+        T_CURRENT = T0;
+        RHS_TIME = 0.0;
+        return 0;
+    }
+
+    if (cvode_mem != NULL) {
+        CVodeFree(&cvode_mem);
+        free_solvers_();
+    }
+
+    // 4. Set vector of initial values.
+    if (Y_WRAPPER != NULL &&
+        (N_VGetLength(Y_WRAPPER) != N || Y_WRAPPER_NUM_THREADS != NUM_THREADS)) {
+        N_VDestroy(Y_WRAPPER);
+        Y_WRAPPER = NULL;
+    }
+    if (Y_WRAPPER == NULL) {
+        Y_WRAPPER = make_vector_(Y0);
+        if (Y_WRAPPER == NULL) {
+            fprintf(stderr, "%s Could not create vector of initial values\n", prefix);
+            return 1;
+        }
+        Y_WRAPPER_NUM_THREADS = NUM_THREADS;
+    }
+    N_Vector y0 = wrap_(Y0);  // Problem vector.
+
+    // 5. Create CVODE object.
+    cvode_mem = CVodeCreate(LMM, sunctx);
+    if (cvode_mem == NULL) {
+        fprintf(stderr, "%s CVodeCreate call failed\n", prefix);
+        return 1;
+    }
+    CVODE_LMM = LMM;
+    T_CURRENT = T0;
+    RHS_TIME = 0.0;
+
+    // 6. Initialize CVODE solver.
+    status = CVodeInit(cvode_mem, cvode_rhs, T0, y0);
+    if (status) {
+        fprintf(stderr, "%s CVodeInit call failed", prefix);
+        return 1;
+    }
+
+    // 7. Specify integration tolerances.
+    CVodeSStolerances(cvode_mem, RTOL, ATOL);
+    CVodeSetUserData(cvode_mem, USER_DATA);
+
+    // 8-15. Create and attach the nonlinear and linear solvers.
+    status = setup_solvers_(y0);
+    if (status != 0) {
+        return status;
+    }
+
+    // 16. Specify rootfinding problem (optional)
+    status = setup_events_();
+
+    return status;
+}
+
+/**
+ * Discard the Jacobian functions, the sparsity pattern, and the preconditioner.
+ */
+static void
+clear_jacobian_(void)
+{
+    OIF_JAC_FN = NULL;
+    OIF_JAC_CSR_FN = NULL;
+    OIF_JAC_TIMES_FN = NULL;
+    OIF_PREC_SETUP_FN = NULL;
+    OIF_PREC_SOLVE_FN = NULL;
+    free(JAC_CSR_INDPTR);
+    free(JAC_CSR_INDICES);
+    JAC_CSR_INDPTR = NULL;
+    JAC_CSR_INDICES = NULL;
+}
+
 int
 set_initial_value(OIFArrayF64 *y0_in, double t0_in)
 {
@@ -57,21 +332,22 @@ set_initial_value(OIFArrayF64 *y0_in, double t0_in)
         fprintf(stderr, "`set_initial_value` received NULL argument\n");
         exit(1);
     }
-    int status;                  // Check errors
-    sunrealtype abstol = 1e-15;  // absolute tolerance
-    sunrealtype reltol = 1e-15;  // relative tolerance
+    int status;  // Check errors
 
     // 1. Initialize parallel or multi-threaded environment, if appropriate.
     // No, it is not appropriate here as we work with serial code :-)
 
     // 2. Create the Sundials context object.
-    status = SUNContext_Create(SUN_COMM_NULL, &sunctx);
-    if (status) {
-        fprintf(stderr, "%s An error occurred when creating SUNContext", prefix);
-        return 1;
+    if (sunctx == NULL) {
+        status = SUNContext_Create(SUN_COMM_NULL, &sunctx);
+        if (status) {
+            fprintf(stderr, "%s An error occurred when creating SUNContext", prefix);
+            return 1;
+        }
     }
 
     // 3. Set problem dimensions, etc.
+    sunindextype N_prev = N;
     if (sizeof(SUNDIALS_INDEX_TYPE) == sizeof(int)) {
         if (y0_in->dimensions[0] > INT_MAX) {
             fprintf(stderr,
@@ -90,121 +366,691 @@ set_initial_value(OIFArrayF64 *y0_in, double t0_in)
         return 2;
     }
 
-    // 4. Set vector of initial values.
-    N_Vector y0 = N_VMake_Serial(N, y0_in->data, sunctx);  // Problem vector.
-    // Sanity check that `sunrealtype` is actually the same as OIF_FLOAT64.
-    assert(NV_Ith_S(y0, 0) == y0_in->data[0]);
+    // The initial value is copied, so that the integration can be restarted
+    // from it when the method is changed.
+    sunrealtype *y0 = realloc(Y0, sizeof(*y0) * (N + 1));
+    if (y0 == NULL) {
+        fprintf(stderr, "%s Could not allocate memory for the initial value\n", prefix);
+        return 1;
+    }
+    Y0 = y0;
+    for (sunindextype i = 0; i < N; ++i) {
+        Y0[i] = y0_in->data[i];
+    }
 
-    sunrealtype t0 = t0_in;
-    assert(t0 == t0_in);
+    // The Jacobian buffer and the sparsity pattern are sized for the previous system.
+    if (N != N_prev) {
+        clear_jacobian_();
+    }
 
-    // 5. Create CVODE object.
-    cvode_mem = CVodeCreate(CV_ADAMS, sunctx);
+    T0 = t0_in;
+    assert(T0 == t0_in);
 
-    // 6. Initialize CVODE solver.
-    status = CVodeInit(cvode_mem, cvode_rhs, t0, y0);
-    if (status) {
-        fprintf(stderr, "%s CVodeInit call failed", prefix);
+    return init_cvode_();
+}
+
+int
+set_user_data(void *user_data)
+{
+    USER_DATA = user_data;
+    if (cvode_mem == NULL) {
+        return 0;
+    }
+    int status = CVodeSetUserData(cvode_mem, user_data);
+    assert(status == CV_SUCCESS);
+    return 0;
+}
+
+int
+set_rhs_fn(oif_ivp_rhs_fn_t rhs)
+{
+    if (rhs == NULL) {
+        fprintf(stderr, "`set_rhs_fn` accepts non-null function pointer only\n");
         return 1;
     }
+    OIF_RHS_FN = rhs;
+    return 0;
+}
 
-    // 7. Specify integration tolerances.
-    CVodeSStolerances(cvode_mem, reltol, abstol);
-
-    // 8. Create matrix object
-    /* A = SUNDenseMatrix(N, N, sunctx); */
-    /* if (A == NULL) { */
-    /*     fprintf(stderr, "[sundials_cvode] Could not create matrix for dense
-     * linear solver\n"); */
-    /*     return 2; */
-    /* } */
+/**
+ * Create the linear solver of the selected type and attach it
+ * together with the provided Jacobian.
+ */
+static int
+setup_linear_solver_(N_Vector y, SUNMatrix *A_out, SUNLinearSolver *LS_out)
+{
+    int status;
+    SUNMatrix A = NULL;
+    SUNLinearSolver LS = NULL;
 
-    // 9. Create linear solver object
-    /* SUNLinearSolver linear_solver = */
-    /*     SUNLinSol_Dense(y0, A, sunctx); */
-    /* if (linear_solver == NULL) { */
-    /*     fprintf(stderr, */
-    /*             "%s An error occurred when creating SUNLinearSolver", */
-    /*             prefix); */
-    /*     return 3; */
-    /* } */
+    enum linear_solver_type_ ls_type = LINEAR_SOLVER_TYPE;
+    if (ls_type == LS_AUTO_) {
+        bool is_matrix_free = OIF_JAC_TIMES_FN != NULL || OIF_PREC_SOLVE_FN != NULL;
+        ls_type = is_matrix_free ? LS_SPGMR_ : LS_DENSE_;
+#if defined(OIF_HAVE_KLU)
+        if (OIF_JAC_CSR_FN != NULL) {
+            ls_type = LS_KLU_;
+        }
+#endif
+    }
+    // The preconditioner is applied on the left.
+    int prec_type = OIF_PREC_SOLVE_FN != NULL ? SUN_PREC_LEFT : SUN_PREC_NONE;
+    switch (ls_type) {
+        case LS_BAND_:
+            A = SUNBandMatrix(N, UPPER_BANDWIDTH, LOWER_BANDWIDTH, sunctx);
+            if (A != NULL) {
+                LS = SUNLinSol_Band(y, A, sunctx);
+            }
+            break;
+        case LS_SPGMR_:
+            LS = SUNLinSol_SPGMR(y, prec_type, MAX_KRYLOV_DIM, sunctx);
+            break;
+        case LS_SPBCGS_:
+            LS = SUNLinSol_SPBCGS(y, prec_type, MAX_KRYLOV_DIM, sunctx);
+            break;
+        case LS_KLU_:
+#if defined(OIF_HAVE_KLU)
+            // Sparse matrices have no difference-quotient approximation in CVODE.
+            if (OIF_JAC_CSR_FN == NULL) {
+                fprintf(stderr, "%s Linear solver 'klu' requires `set_jac_csr_fn`\n",
+                        prefix);
+                break;
+            }
+            A = SUNSparseMatrix(N, N, JAC_CSR_INDPTR[N] > 0 ? JAC_CSR_INDPTR[N] : 1, CSR_MAT,
+                                sunctx);
+            if (A != NULL) {
+                LS = SUNLinSol_KLU(y, A, sunctx);
+            }
+#endif
+            break;
+        default:
+            // Without KLU, sparse Jacobians are assembled into the dense matrix.
+            A = SUNDenseMatrix(N, N, sunctx);
+            if (A != NULL) {
+                LS = SUNLinSol_Dense(y, A, sunctx);
+            }
+            break;
+    }
+    if (LS == NULL) {
+        fprintf(stderr, "%s An error occurred when creating linear solver '%s'\n", prefix,
+                LINEAR_SOLVER_NAMES[ls_type]);
+        if (A != NULL) {
+            SUNMatDestroy(A);
+        }
+        return 3;
+    }
+    *A_out = A;
+    *LS_out = LS;
 
-    // 10. Set linear solver optional inputs
-
-    // 11. Attach linear solver module.
-    /* status = CVodeSetLinearSolver(cvode_mem, linear_solver, A); */
-    /* if (status == CVLS_MEM_FAIL) { */
-    /*     fprintf( */
-    /*         stderr, */
-    /*         "[sundials_cvode] Setting linear solver failed\n" */
-    /*     ); */
-    /*     return 4; */
-    /* } else if (status == CVLS_ILL_INPUT) { */
-    /*     fprintf( */
-    /*         stderr, */
-    /*         "[sundials_cvode] Setting linear solver failed due to ill
-     * input\n" */
-    /*     ); */
-    /*     return 5; */
-    /* } else if (status != CVLS_SUCCESS) { */
-    /*     fprintf( */
-    /*         stderr, */
-    /*         "[sundials_cvode] Setting linear solver was unsuccessful\n" */
-    /*     ); */
-    /*     return 6; */
-    /* } */
+    status = CVodeSetLinearSolver(cvode_mem, LS, A);
+    if (status != CVLS_SUCCESS) {
+        fprintf(stderr, "%s Setting linear solver failed with code %d\n", prefix, status);
+        return 4;
+    }
+    // Without the user-provided Jacobian, CVODE uses difference quotients.
+    // Matrix-based solvers use the Jacobian matrix, and matrix-free solvers
+    // use Jacobian-vector products.
+    status = CVLS_SUCCESS;
+    if (A != NULL && OIF_JAC_FN != NULL) {
+        status = CVodeSetJacFn(cvode_mem, cvode_jac);
+    }
+    else if (A != NULL && OIF_JAC_CSR_FN != NULL) {
+        status = CVodeSetJacFn(cvode_mem, cvode_jac_csr);
+    }
+    else if (A == NULL && OIF_JAC_TIMES_FN != NULL) {
+        status = CVodeSetJacTimes(cvode_mem, NULL, cvode_jac_times);
+    }
+    if (status != CVLS_SUCCESS) {
+        fprintf(stderr, "%s Setting Jacobian failed with code %d\n", prefix, status);
+        return 5;
+    }
+    if (A == NULL && OIF_PREC_SOLVE_FN != NULL) {
+        status = CVodeSetPreconditioner(cvode_mem, cvode_prec_setup, cvode_prec_solve);
+        if (status != CVLS_SUCCESS) {
+            fprintf(stderr, "%s Setting preconditioner failed with code %d\n", prefix,
+                    status);
+            return 6;
+        }
+    }
+    return 0;
+}
 
-    // 12. Set optional inputs
-    // 13. Create nonlinear solver object (optional)
-    SUNNonlinearSolver NLS = SUNNonlinSol_FixedPoint(y0, 0, sunctx);
+/**
+ * Attach the nonlinear solver selected by the options, and for Newton iteration
+ * also the linear solver, replacing the previously attached ones.
+ */
+static int
+setup_solvers_(N_Vector y)
+{
+    int status;
+    SUNMatrix A = NULL;
+    SUNLinearSolver LS = NULL;
+    SUNNonlinearSolver NLS = NULL;
+
+    enum nonlinear_solver_type_ nls_type = NONLINEAR_SOLVER_TYPE;
+    if (nls_type == NLS_AUTO_) {
+        bool has_jac = OIF_JAC_FN != NULL || OIF_JAC_CSR_FN != NULL ||
+                       OIF_JAC_TIMES_FN != NULL || OIF_PREC_SOLVE_FN != NULL;
+        nls_type = (LMM == CV_ADAMS && !has_jac) ? NLS_FIXED_POINT_ : NLS_NEWTON_;
+    }
+
+    if (nls_type == NLS_NEWTON_) {
+        status = setup_linear_solver_(y, &A, &LS);
+        if (status != 0) {
+            goto cleanup;
+        }
+        NLS = SUNNonlinSol_Newton(y, sunctx);
+    }
+    else {
+        // Fixed-point iteration does not use the linear solver,
+        // so the previously attached one, if any, is kept.
+        NLS = SUNNonlinSol_FixedPoint(y, ANDERSON_DEPTH, sunctx);
+    }
     if (NLS == NULL) {
-        fprintf(stderr, "%s Could not create Fixed Point Nonlinear solver\n", prefix);
-        return 7;
+        fprintf(stderr, "%s Could not create nonlinear solver '%s'\n", prefix,
+                NONLINEAR_SOLVER_NAMES[nls_type]);
+        status = 7;
+        goto cleanup;
     }
-    // 14. Attach nonlinear solver module (optional)
     status = CVodeSetNonlinearSolver(cvode_mem, NLS);
     if (status != CV_SUCCESS) {
         fprintf(stderr, "%s CVodeSetNonlinearSolver failed with code %d\n", prefix, status);
-        return 8;
+        status = 8;
+        goto cleanup;
     }
-    // 15. Set nonlinear solver optional inputs (optional)
-    // 16. Specify rootfinding problem (optional)
-
-    N_VDestroy_Serial(y0);
 
+    if (NONLINEAR_SOLVER != NULL) {
+        SUNNonlinSolFree(NONLINEAR_SOLVER);
+    }
+    NONLINEAR_SOLVER = NLS;
+    if (LS != NULL) {
+        if (LINEAR_SOLVER != NULL) {
+            SUNLinSolFree(LINEAR_SOLVER);
+        }
+        if (JAC_MATRIX != NULL) {
+            SUNMatDestroy(JAC_MATRIX);
+        }
+        LINEAR_SOLVER = LS;
+        JAC_MATRIX = A;
+    }
     return 0;
+
+cleanup:
+    if (NLS != NULL) {
+        SUNNonlinSolFree(NLS);
+    }
+    if (LS != NULL) {
+        SUNLinSolFree(LS);
+    }
+    if (A != NULL) {
+        SUNMatDestroy(A);
+    }
+    return status;
+}
+
+/**
+ * Re-create the solvers after the Jacobian or the options have changed.
+ */
+static int
+reset_solvers_(void)
+{
+    if (cvode_mem == NULL) {
+        return 0;
+    }
+    // The solvers use the vector only as a template.
+    return setup_solvers_(wrap_(Y0));
+}
+
+static int
+set_jacobian_(oif_ivp_jac_fn_t jac, oif_ivp_jac_csr_fn_t jac_csr,
+              oif_ivp_jac_times_fn_t jac_times, size_t buffer_size)
+{
+    if (cvode_mem == NULL) {
+        fprintf(stderr, "%s `set_initial_value` must be called before setting Jacobian\n",
+                prefix);
+        return 1;
+    }
+
+    sunrealtype *buffer = realloc(JAC_BUFFER, sizeof(*buffer) * (buffer_size + 1));
+    if (buffer == NULL) {
+        fprintf(stderr, "%s Could not allocate memory for Jacobian\n", prefix);
+        return 1;
+    }
+    JAC_BUFFER = buffer;
+    OIF_JAC_FN = jac;
+    OIF_JAC_CSR_FN = jac_csr;
+    OIF_JAC_TIMES_FN = jac_times;
+
+    return reset_solvers_();
 }
 
 int
-set_user_data(void *user_data)
+set_jac_fn(oif_ivp_jac_fn_t jac)
 {
-    int status = CVodeSetUserData(cvode_mem, user_data);
-    if (status == CV_MEM_NULL) {
+    if (jac == NULL) {
+        fprintf(stderr, "%s `set_jac_fn` accepts non-null function pointer only\n", prefix);
+        return 1;
+    }
+    return set_jacobian_(jac, NULL, NULL, (size_t)N * N);
+}
+
+int
+set_jac_csr_fn(oif_ivp_jac_csr_fn_t jac, OIFArrayF64 *indptr, OIFArrayF64 *indices)
+{
+    if (jac == NULL) {
+        fprintf(stderr, "%s `set_jac_csr_fn` accepts non-null function pointer only\n",
+                prefix);
+        return 1;
+    }
+    if (indptr->nd != 1 || indptr->dimensions[0] != N + 1 || indices->nd != 1 ||
+        indices->dimensions[0] != (intptr_t)indptr->data[N]) {
+        fprintf(stderr, "%s Sparsity pattern does not match the problem size %d\n", prefix,
+                (int)N);
+        return 1;
+    }
+    // The pattern is used to write into the matrix, so it must stay within it.
+    if (indptr->data[0] != 0.0) {
+        fprintf(stderr, "%s Sparsity pattern must start with `indptr[0]` = 0\n", prefix);
+        return 1;
+    }
+    for (sunindextype i = 0; i < N; ++i) {
+        if (!(indptr->data[i + 1] >= indptr->data[i]) ||
+            indptr->data[i + 1] != (sunindextype)indptr->data[i + 1]) {
+            fprintf(stderr,
+                    "%s Sparsity pattern must have nondecreasing integer `indptr`, "
+                    "but `indptr[%d]` is %g\n",
+                    prefix, (int)(i + 1), indptr->data[i + 1]);
+            return 1;
+        }
+    }
+    for (intptr_t k = 0; k < indices->dimensions[0]; ++k) {
+        if (!(indices->data[k] >= 0.0 && indices->data[k] < N) ||
+            indices->data[k] != (sunindextype)indices->data[k]) {
+            fprintf(stderr,
+                    "%s Sparsity pattern must have integer `indices` in [0, %d), "
+                    "but `indices[%d]` is %g\n",
+                    prefix, (int)N, (int)k, indices->data[k]);
+            return 1;
+        }
+    }
+
+    sunindextype nnz = (sunindextype)indices->dimensions[0];
+    sunindextype *new_indptr = malloc(sizeof(*new_indptr) * (N + 1));
+    sunindextype *new_indices = malloc(sizeof(*new_indices) * (nnz + 1));
+    if (new_indptr == NULL || new_indices == NULL) {
+        fprintf(stderr, "%s Could not allocate memory for sparsity pattern\n", prefix);
+        free(new_indptr);
+        free(new_indices);
+        return 1;
+    }
+    for (sunindextype i = 0; i <= N; ++i) {
+        new_indptr[i] = (sunindextype)indptr->data[i];
+    }
+    for (sunindextype k = 0; k < nnz; ++k) {
+        new_indices[k] = (sunindextype)indices->data[k];
+    }
+    free(JAC_CSR_INDPTR);
+    free(JAC_CSR_INDICES);
+    JAC_CSR_INDPTR = new_indptr;
+    JAC_CSR_INDICES = new_indices;
+
+    return set_jacobian_(NULL, jac, NULL, nnz);
+}
+
+int
+set_jac_times_fn(oif_ivp_jac_times_fn_t jac_times)
+{
+    if (jac_times == NULL) {
+        fprintf(stderr, "%s `set_jac_times_fn` accepts non-null function pointer only\n",
+                prefix);
+        return 1;
+    }
+    return set_jacobian_(NULL, NULL, jac_times, 0);
+}
+
+/**
+ * Set the preconditioner for the matrix-free linear solvers.
+ *
+ * Unless the linear solver is selected with the option `linear_solver`,
+ * GMRES is used, as matrix-based solvers do not use preconditioners.
+ */
+int
+set_preconditioner(oif_ivp_prec_setup_fn_t setup, oif_ivp_prec_solve_fn_t solve)
+{
+    if (setup == NULL || solve == NULL) {
+        fprintf(stderr, "%s `set_preconditioner` accepts non-null function pointers only\n",
+                prefix);
+        return 1;
+    }
+    if (cvode_mem == NULL) {
         fprintf(stderr,
-                "%s Could not set user data as "
-                "CVODE memory block is not yet initialized\n",
+                "%s `set_initial_value` must be called before setting preconditioner\n",
                 prefix);
         return 1;
     }
-    assert(status == CV_SUCCESS);
+    OIF_PREC_SETUP_FN = setup;
+    OIF_PREC_SOLVE_FN = solve;
+    return reset_solvers_();
+}
+
+// Attach the event functions to the CVODE memory block.
+static int
+setup_events_(void)
+{
+    if (cvode_mem == NULL) {
+        return 0;
+    }
+    int status = CVodeRootInit(cvode_mem, NUM_EVENTS, NUM_EVENTS > 0 ? cvode_events : NULL);
+    if (status == CV_SUCCESS && NUM_EVENTS > 0) {
+        status = CVodeSetRootDirection(cvode_mem, EVENT_DIRECTIONS);
+    }
+    if (status != CV_SUCCESS) {
+        fprintf(stderr, "%s Could not set event functions, error code %d\n", prefix, status);
+        return 1;
+    }
     return 0;
 }
 
+/**
+ * Set the event functions, whose zero crossings are located
+ * with the rootfinding of CVODE.
+ *
+ * Events that are not terminal are reported via `get_last_event`,
+ * and the integration continues.
+ */
 int
-set_rhs_fn(oif_ivp_rhs_fn_t rhs)
+set_events(int n_events, oif_ivp_event_fn_t event_fn, OIFArrayF64 *directions,
+           OIFArrayF64 *terminal)
 {
-    if (rhs == NULL) {
-        fprintf(stderr, "`set_rhs_fn` accepts non-null function pointer only\n");
+    if (n_events < 0 || (n_events > 0 && event_fn == NULL)) {
+        fprintf(stderr, "%s `set_events` expects nonnegative number of events "
+                        "and non-null event function\n",
+                prefix);
         return 1;
     }
-    OIF_RHS_FN = rhs;
+    // Arrays are not needed to disable the events.
+    bool no_arrays = n_events == 0 && (directions == NULL || terminal == NULL);
+    if (!no_arrays && (directions == NULL || terminal == NULL || directions->nd != 1 ||
+                       directions->dimensions[0] != n_events || terminal->nd != 1 ||
+                       terminal->dimensions[0] != n_events)) {
+        fprintf(stderr, "%s Arrays `directions` and `terminal` must have %d elements\n",
+                prefix, n_events);
+        return 1;
+    }
+
+    int *new_directions = malloc(sizeof(*new_directions) * (n_events + 1));
+    bool *new_terminal = malloc(sizeof(*new_terminal) * (n_events + 1));
+    int *new_found = malloc(sizeof(*new_found) * (n_events + 1));
+    if (new_directions == NULL || new_terminal == NULL || new_found == NULL) {
+        fprintf(stderr, "%s Could not allocate memory for events\n", prefix);
+        free(new_directions);
+        free(new_terminal);
+        free(new_found);
+        return 1;
+    }
+    for (int i = 0; i < n_events; ++i) {
+        double direction = directions->data[i];
+        new_directions[i] = direction > 0 ? 1 : (direction < 0 ? -1 : 0);
+        new_terminal[i] = terminal->data[i] != 0.0;
+    }
+    free(EVENT_DIRECTIONS);
+    free(EVENT_TERMINAL);
+    free(EVENTS_FOUND);
+    EVENT_DIRECTIONS = new_directions;
+    EVENT_TERMINAL = new_terminal;
+    EVENTS_FOUND = new_found;
+    OIF_EVENT_FN = event_fn;
+    NUM_EVENTS = n_events;
+    LAST_EVENT_INDEX = -1;
+    LAST_EVENT_T = NAN;
+
+    return setup_events_();
+}
+
+int
+get_last_event(OIFArrayF64 *event)
+{
+    if (event->nd != 1 || event->dimensions[0] != 2) {
+        fprintf(stderr, "%s `get_last_event` expects an array with 2 elements\n", prefix);
+        return 1;
+    }
+    event->data[0] = LAST_EVENT_INDEX;
+    event->data[1] = LAST_EVENT_T;
     return 0;
 }
 
+/**
+ * Call `CVode` and record the events that it returns at.
+ *
+ * The solver continues after the events that are not terminal.
+ * Returns the return value of the last call to `CVode`
+ * and sets `stopped` if a terminal event stopped the integration.
+ */
+static int
+advance_(sunrealtype tout, N_Vector yout, sunrealtype *tret, int task, bool *stopped)
+{
+    *stopped = false;
+    int ier = CVode(cvode_mem, tout, yout, tret, task);
+    while (ier == CV_ROOT_RETURN) {
+        CVodeGetRootInfo(cvode_mem, EVENTS_FOUND);
+        for (int i = 0; i < NUM_EVENTS; ++i) {
+            if (EVENTS_FOUND[i] != 0 && !*stopped) {
+                LAST_EVENT_INDEX = i;
+                LAST_EVENT_T = *tret;
+                *stopped = EVENT_TERMINAL[i];
+            }
+        }
+        if (*stopped || task == CV_ONE_STEP) {
+            ier = CV_SUCCESS;
+            break;
+        }
+        ier = CVode(cvode_mem, tout, yout, tret, task);
+    }
+    if (ier == CV_SUCCESS || ier == CV_TSTOP_RETURN) {
+        T_CURRENT = *tret;
+    }
+    return ier;
+}
+
 int
 set_tolerances(double rtol, double atol)
 {
-    CVodeSStolerances(cvode_mem, rtol, atol);
+    RTOL = rtol;
+    ATOL = atol;
+    if (cvode_mem != NULL) {
+        CVodeSStolerances(cvode_mem, rtol, atol);
+    }
+    return 0;
+}
+
+/**
+ * Select the linear multistep method: "adams" for nonstiff problems
+ * or "bdf" for stiff problems.
+ *
+ * As CVODE cannot change the method of the memory block,
+ * the integration is restarted from the initial value.
+ */
+int
+set_integrator(const char *integrator_name)
+{
+    if (strcmp(integrator_name, "adams") == 0) {
+        LMM = CV_ADAMS;
+    }
+    else if (strcmp(integrator_name, "bdf") == 0) {
+        LMM = CV_BDF;
+    }
+    else {
+        fprintf(stderr, "%s Unknown integrator '%s', supported integrators: adams, bdf\n",
+                prefix, integrator_name);
+        return 1;
+    }
+    if (cvode_mem == NULL) {
+        return 0;
+    }
+    return init_cvode_();
+}
+
+// Find `value` among `n` names and write its index to `index`.
+static int
+parse_name_(const char *name, const char *value, const char **names, int n, int *index)
+{
+    for (int i = 0; i < n; ++i) {
+        if (strcmp(value, names[i]) == 0) {
+            *index = i;
+            return 0;
+        }
+    }
+    fprintf(stderr, "%s Unknown value '%s' of option '%s', supported values:", prefix, value,
+            name);
+    for (int i = 0; i < n; ++i) {
+        fprintf(stderr, "%s %s", i == 0 ? "" : ",", names[i]);
+    }
+    fprintf(stderr, "\n");
+    return 1;
+}
+
+// Parse `value` as a nonnegative integer.
+static int
+parse_count_(const char *name, const char *value, long *count)
+{
+    char *end;
+    errno = 0;
+    long result = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || errno != 0 || result < 0 || result > INT_MAX) {
+        fprintf(stderr, "%s Option '%s' expects a nonnegative integer, got '%s'\n", prefix,
+                name, value);
+        return 1;
+    }
+    *count = result;
+    return 0;
+}
+
+/**
+ * Set the number of threads for the vector operations.
+ *
+ * The vectors of CVODE cannot change their type,
+ * so the integration is restarted from the initial value.
+ */
+static int
+set_num_threads_(const char *value)
+{
+    long num_threads;
+    if (parse_count_("num_threads", value, &num_threads) != 0) {
+        return 1;
+    }
+    if (num_threads < 1) {
+        fprintf(stderr, "%s Option 'num_threads' must be positive\n", prefix);
+        return 1;
+    }
+#if !defined(OIF_HAVE_NVECOPENMP) && !defined(OIF_HAVE_NVECPTHREADS)
+    if (num_threads > 1) {
+        fprintf(stderr,
+                "%s Sundials is built without OpenMP and Pthreads vectors, "
+                "so only one thread is supported\n",
+                prefix);
+        return 1;
+    }
+#endif
+    NUM_THREADS = num_threads;
+    if (cvode_mem == NULL) {
+        return 0;
+    }
+    return init_cvode_();
+}
+
+/**
+ * Set the option `name` that selects or configures the solvers to `value`.
+ *
+ * The options are listed by `print_options`.
+ * They take effect immediately, without restarting the integration,
+ * except `num_threads`, which restarts it from the initial value.
+ */
+int
+set_option(const char *name, const char *value)
+{
+    int status;
+    int index;
+    if (strcmp(name, "nonlinear_solver") == 0) {
+        status = parse_name_(name, value, NONLINEAR_SOLVER_NAMES,
+                             sizeof(NONLINEAR_SOLVER_NAMES) / sizeof(char *), &index);
+        if (status == 0) {
+            NONLINEAR_SOLVER_TYPE = index;
+        }
+    }
+    else if (strcmp(name, "linear_solver") == 0) {
+        status = parse_name_(name, value, LINEAR_SOLVER_NAMES,
+                             sizeof(LINEAR_SOLVER_NAMES) / sizeof(char *), &index);
+#if !defined(OIF_HAVE_KLU)
+        if (status == 0 && index == LS_KLU_) {
+            fprintf(stderr, "%s Sundials is built without KLU\n", prefix);
+            status = 1;
+        }
+#endif
+        if (status == 0) {
+            LINEAR_SOLVER_TYPE = index;
+        }
+    }
+    else if (strcmp(name, "anderson_depth") == 0) {
+        status = parse_count_(name, value, &ANDERSON_DEPTH);
+    }
+    else if (strcmp(name, "upper_bandwidth") == 0) {
+        status = parse_count_(name, value, &UPPER_BANDWIDTH);
+    }
+    else if (strcmp(name, "lower_bandwidth") == 0) {
+        status = parse_count_(name, value, &LOWER_BANDWIDTH);
+    }
+    else if (strcmp(name, "max_krylov_dim") == 0) {
+        status = parse_count_(name, value, &MAX_KRYLOV_DIM);
+    }
+    else if (strcmp(name, "num_threads") == 0) {
+        return set_num_threads_(value);
+    }
+    else {
+        fprintf(stderr, "%s Unknown option '%s', see `print_options` for supported options\n",
+                prefix, name);
+        return 1;
+    }
+    if (status != 0) {
+        return status;
+    }
+    return reset_solvers_();
+}
+
+int
+print_options(void)
+{
+    printf("Options of %s (current value: supported values)\n", prefix);
+    printf("  integrator        %-12s adams, bdf (set with `set_integrator`)\n",
+           LMM == CV_ADAMS ? "adams" : "bdf");
+    printf("  nonlinear_solver  %-12s auto, fixed_point, newton\n",
+           NONLINEAR_SOLVER_NAMES[NONLINEAR_SOLVER_TYPE]);
+    printf("  anderson_depth    %-12ld nonnegative integer, for fixed_point\n", ANDERSON_DEPTH);
+#if defined(OIF_HAVE_KLU)
+    const char *klu_name = ", klu";
+#else
+    const char *klu_name = "";
+#endif
+    printf("  linear_solver     %-12s auto, dense, band, spgmr, spbcgs%s, for newton\n",
+           LINEAR_SOLVER_NAMES[LINEAR_SOLVER_TYPE], klu_name);
+    printf("  upper_bandwidth   %-12ld nonnegative integer, for band\n", UPPER_BANDWIDTH);
+    printf("  lower_bandwidth   %-12ld nonnegative integer, for band\n", LOWER_BANDWIDTH);
+    printf("  max_krylov_dim    %-12ld nonnegative integer, for spgmr and spbcgs\n",
+           MAX_KRYLOV_DIM);
+#if defined(OIF_HAVE_NVECOPENMP)
+    const char *vector_name = "openmp";
+#elif defined(OIF_HAVE_NVECPTHREADS)
+    const char *vector_name = "pthreads";
+#else
+    const char *vector_name = NULL;
+#endif
+    if (vector_name != NULL) {
+        printf("  num_threads       %-12ld positive integer, for the %s vector if > 1\n",
+               NUM_THREADS, vector_name);
+    }
+    else {
+        printf("  num_threads       %-12ld 1 (Sundials is built without threaded vectors)\n",
+               NUM_THREADS);
+    }
     return 0;
 }
 
@@ -214,6 +1060,61 @@ print_stats(void)
     return CVodePrintAllStats(cvode_mem, stdout, SUN_OUTPUTFORMAT_TABLE);
 }
 
+int
+get_stats(OIFArrayF64 *stats)
+{
+    if (stats->nd != 1 || stats->dimensions[0] != OIF_IVP_NUM_STATS) {
+        fprintf(stderr, "%s `get_stats` expects the array with %d elements\n", prefix,
+                OIF_IVP_NUM_STATS);
+        return 1;
+    }
+    for (int i = 0; i < OIF_IVP_NUM_STATS; ++i) {
+        stats->data[i] = NAN;
+    }
+    if (cvode_mem == NULL) {
+        return 0;
+    }
+
+    long int nsteps, nfevals, nlinsetups, netfails;
+    int qlast, qcur;
+    sunrealtype hinused, hlast, hcur, tcur;
+    int status = CVodeGetIntegratorStats(cvode_mem, &nsteps, &nfevals, &nlinsetups, &netfails,
+                                         &qlast, &qcur, &hinused, &hlast, &hcur, &tcur);
+    if (status != CV_SUCCESS) {
+        fprintf(stderr, "%s Could not obtain the integrator statistics\n", prefix);
+        return 1;
+    }
+    stats->data[OIF_IVP_STAT_NUM_STEPS] = nsteps;
+    stats->data[OIF_IVP_STAT_NUM_RHS_EVALS] = nfevals;
+    stats->data[OIF_IVP_STAT_NUM_ERROR_TEST_FAILS] = netfails;
+    stats->data[OIF_IVP_STAT_LAST_STEP] = hlast;
+
+    long int nniters, nncfails;
+    if (CVodeGetNonlinSolvStats(cvode_mem, &nniters, &nncfails) == CV_SUCCESS) {
+        stats->data[OIF_IVP_STAT_NUM_NONLINEAR_ITERS] = nniters;
+        stats->data[OIF_IVP_STAT_NUM_NONLINEAR_CONV_FAILS] = nncfails;
+    }
+
+    // The linear solver and its statistics exist only with Newton iteration.
+    long int njevals, lenrw, leniw, lenrw_ls = 0, leniw_ls = 0;
+    if (LINEAR_SOLVER != NULL) {
+        if (CVodeGetNumJacEvals(cvode_mem, &njevals) == CV_SUCCESS) {
+            stats->data[OIF_IVP_STAT_NUM_JAC_EVALS] = njevals;
+        }
+        if (CVodeGetLinWorkSpace(cvode_mem, &lenrw_ls, &leniw_ls) != CV_SUCCESS) {
+            lenrw_ls = leniw_ls = 0;
+        }
+    }
+    if (CVodeGetWorkSpace(cvode_mem, &lenrw, &leniw) == CV_SUCCESS) {
+        stats->data[OIF_IVP_STAT_WORKSPACE_BYTES] =
+            (double)(lenrw + lenrw_ls) * sizeof(sunrealtype) +
+            (double)(leniw + leniw_ls) * sizeof(long int);
+    }
+    stats->data[OIF_IVP_STAT_RHS_TIME] = RHS_TIME;
+
+    return 0;
+}
+
 int
 integrate(double t, OIFArrayF64 *y)
 {
@@ -223,7 +1124,7 @@ integrate(double t, OIFArrayF64 *y)
     /* } */
     int ier;  // Error checking.
 
-    N_Vector yout = N_VMake_Serial(N, y->data, sunctx);
+    N_Vector yout = wrap_(y->data);
     sunrealtype tout = t;
 
     // Time that will be reached by solver during integration.
@@ -232,10 +1133,12 @@ integrate(double t, OIFArrayF64 *y)
     // When we request CV_ONE_STEP task, than it will be just time reached
     // via internal time step (time step that satisfies error tolerances).
     sunrealtype tret;
+    bool stopped;
 
     // 17. Advance solution in time.
-    ier = CVode(cvode_mem, tout, yout, &tret, CV_NORMAL);
-    N_VDestroy(yout);
+    LAST_EVENT_INDEX = -1;
+    LAST_EVENT_T = NAN;
+    ier = advance_(tout, yout, &tret, CV_NORMAL, &stopped);
     // TODO: Handle all cases: write good error messages for all `ier`.
     switch (ier) {
         case CV_SUCCESS:
@@ -246,6 +1149,226 @@ integrate(double t, OIFArrayF64 *y)
     }
 }
 
+int
+integrate_many(OIFArrayF64 *times, OIFArrayF64 *Y)
+{
+    if (times->nd != 1 || Y->nd != 2 || Y->dimensions[0] != times->dimensions[0] ||
+        Y->dimensions[1] != N) {
+        fprintf(stderr,
+                "%s `integrate_many` expects the output array "
+                "with shape (len(times), %d)\n",
+                prefix, (int)N);
+        return 1;
+    }
+
+    // The vector is pointed to consecutive rows of `Y`.
+    N_Vector yout = wrap_(Y->data);
+    sunrealtype tret;
+    bool stopped = false;
+    int ier = CV_SUCCESS;
+    LAST_EVENT_INDEX = -1;
+    LAST_EVENT_T = NAN;
+    for (intptr_t i = 0; i < times->dimensions[0]; ++i) {
+        if (stopped) {
+            // The solution after a terminal event is not computed.
+            for (sunindextype j = 0; j < N; ++j) {
+                Y->data[i * N + j] = NAN;
+            }
+            continue;
+        }
+        wrap_(Y->data + i * N);
+        ier = advance_(times->data[i], yout, &tret, CV_NORMAL, &stopped);
+        if (ier != CV_SUCCESS) {
+            fprintf(stderr,
+                    "%s During call to `CVode` for output time #%ld, "
+                    "an error occurred\n",
+                    prefix, (long)i);
+            break;
+        }
+    }
+
+    return ier == CV_SUCCESS ? 0 : 1;
+}
+
+int
+integrate_one_step(double t_end, OIFArrayF64 *t, OIFArrayF64 *y)
+{
+    // The stop time prevents the step from going beyond `t_end`.
+    int ier = CVodeSetStopTime(cvode_mem, t_end);
+    if (ier != CV_SUCCESS) {
+        fprintf(stderr, "%s Could not set stop time %g\n", prefix, t_end);
+        return 1;
+    }
+
+    N_Vector yout = wrap_(y->data);
+    sunrealtype tret;
+    bool stopped;
+    LAST_EVENT_INDEX = -1;
+    LAST_EVENT_T = NAN;
+    ier = advance_(t_end, yout, &tret, CV_ONE_STEP, &stopped);
+    // Remove the stop time for subsequent calls, if it has not been reached.
+    // Setting it to infinity instead would stop backward integration.
+    int clear_ier = CVodeClearStopTime(cvode_mem);
+    if (ier != CV_SUCCESS && ier != CV_TSTOP_RETURN) {
+        fprintf(stderr, "%s During call to `CVode`, an error occurred\n", prefix);
+        return 1;
+    }
+    if (clear_ier != CV_SUCCESS) {
+        fprintf(stderr, "%s Could not clear stop time\n", prefix);
+        return 1;
+    }
+
+    t->data[0] = tret;
+    return 0;
+}
+
+int
+interpolate(double t, OIFArrayF64 *y)
+{
+    // CVODE keeps the Nordsieck history array that allows to evaluate
+    // the interpolating polynomial within the last step.
+    N_Vector yout = wrap_(y->data);
+    int ier = CVodeGetDky(cvode_mem, t, 0, yout);
+    if (ier == CV_BAD_T) {
+        fprintf(stderr, "%s Time %g is outside of the last step\n", prefix, t);
+        return 1;
+    }
+    else if (ier != CV_SUCCESS) {
+        fprintf(stderr, "%s Could not interpolate the solution\n", prefix);
+        return 1;
+    }
+    return 0;
+}
+
+// Signature at the beginning of the files with the saved state, followed by
+// the number of equations, the method, the time, the step size, and the solution.
+static const char STATE_SIGNATURE[8] = "OIFCVODE";
+
+/**
+ * Save the solution at the time it was returned last together with the step size
+ * that the integrator is going to attempt next.
+ *
+ * The history array of CVODE cannot be set through its public API,
+ * so it is not saved, and the integration is resumed with the saved step size
+ * but from the first order.
+ */
+int
+save_state(const char *filename)
+{
+    if (cvode_mem == NULL) {
+        fprintf(stderr, "%s Initial value must be set before saving the state\n", prefix);
+        return 1;
+    }
+
+    int status = 1;
+    FILE *fp = NULL;
+    sunrealtype *y = malloc(sizeof(*y) * N);
+    if (y == NULL) {
+        fprintf(stderr, "%s Could not allocate memory for the state\n", prefix);
+        return 1;
+    }
+    // The internal time of the integrator can be ahead of the returned solution,
+    // so the solution is interpolated.
+    sunrealtype h;
+    if (CVodeGetDky(cvode_mem, T_CURRENT, 0, wrap_(y)) != CV_SUCCESS ||
+        CVodeGetCurrentStep(cvode_mem, &h) != CV_SUCCESS) {
+        fprintf(stderr, "%s Could not obtain the state of the integrator\n", prefix);
+        goto cleanup;
+    }
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "%s Could not open file '%s': %s\n", prefix, filename,
+                strerror(errno));
+        goto cleanup;
+    }
+    int64_t n = N;
+    int32_t lmm = CVODE_LMM;
+    double t_and_h[] = {T_CURRENT, h};
+    if (fwrite(STATE_SIGNATURE, sizeof(STATE_SIGNATURE), 1, fp) != 1 ||
+        fwrite(&n, sizeof(n), 1, fp) != 1 || fwrite(&lmm, sizeof(lmm), 1, fp) != 1 ||
+        fwrite(t_and_h, sizeof(t_and_h), 1, fp) != 1 ||
+        fwrite(y, sizeof(*y), N, fp) != (size_t)N) {
+        fprintf(stderr, "%s Could not write the state to file '%s'\n", prefix, filename);
+        goto cleanup;
+    }
+    status = 0;
+
+cleanup:
+    if (fp != NULL && fclose(fp) != 0) {
+        fprintf(stderr, "%s Could not write the state to file '%s'\n", prefix, filename);
+        status = 1;
+    }
+    free(y);
+    return status;
+}
+
+/**
+ * Restart the integration from the state saved with `save_state`.
+ *
+ * The saved state replaces the initial value and the method,
+ * so that a subsequent `set_integrator` restarts from the saved state.
+ */
+int
+load_state(const char *filename)
+{
+    if (cvode_mem == NULL) {
+        fprintf(stderr, "%s Initial value must be set before loading the state\n", prefix);
+        return 1;
+    }
+
+    int status = 1;
+    sunrealtype *y = malloc(sizeof(*y) * N);
+    if (y == NULL) {
+        fprintf(stderr, "%s Could not allocate memory for the state\n", prefix);
+        return 1;
+    }
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "%s Could not open file '%s': %s\n", prefix, filename,
+                strerror(errno));
+        goto cleanup;
+    }
+    char signature[sizeof(STATE_SIGNATURE)];
+    int64_t n;
+    int32_t lmm;
+    double t_and_h[2];
+    if (fread(signature, sizeof(signature), 1, fp) != 1 ||
+        memcmp(signature, STATE_SIGNATURE, sizeof(signature)) != 0 ||
+        fread(&n, sizeof(n), 1, fp) != 1 || fread(&lmm, sizeof(lmm), 1, fp) != 1 ||
+        fread(t_and_h, sizeof(t_and_h), 1, fp) != 1 || (lmm != CV_ADAMS && lmm != CV_BDF)) {
+        fprintf(stderr, "%s File '%s' does not contain a saved state\n", prefix, filename);
+        goto cleanup;
+    }
+    if (n != N) {
+        fprintf(stderr,
+                "%s Saved state has %ld equations, but the initial value has %ld\n",
+                prefix, (long)n, (long)N);
+        goto cleanup;
+    }
+    if (fread(y, sizeof(*y), N, fp) != (size_t)N) {
+        fprintf(stderr, "%s Could not read the state from file '%s'\n", prefix, filename);
+        goto cleanup;
+    }
+
+    memcpy(Y0, y, sizeof(*y) * N);
+    T0 = t_and_h[0];
+    LMM = lmm;
+    LAST_EVENT_INDEX = -1;
+    LAST_EVENT_T = NAN;
+    status = init_cvode_();
+    if (status == 0 && t_and_h[1] != 0.0) {
+        status = CVodeSetInitStep(cvode_mem, t_and_h[1]) == CV_SUCCESS ? 0 : 1;
+    }
+
+cleanup:
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    free(y);
+    return status;
+}
+
 // Function that computes the right-hand side of the ODE system.
 static int
 cvode_rhs(sunrealtype t, N_Vector y, N_Vector ydot, void *user_data)
@@ -263,7 +1386,153 @@ cvode_rhs(sunrealtype t, N_Vector y, N_Vector ydot, void *user_data)
                             .dimensions = (intptr_t[]){N_VGetLength(ydot)},
                             .data = N_VGetArrayPointer(ydot)};
 
+    struct timespec start, end;
+    timespec_get(&start, TIME_UTC);
     int result = OIF_RHS_FN(t, &oif_y, &oif_ydot, user_data);
+    timespec_get(&end, TIME_UTC);
+    RHS_TIME += (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec);
+
+    return result;
+}
+
+// Function that computes the Jacobian of the right-hand side
+// and copies it to the dense or banded matrix.
+static int
+cvode_jac(sunrealtype t, N_Vector y, N_Vector fy, SUNMatrix J, void *user_data, N_Vector tmp1,
+          N_Vector tmp2, N_Vector tmp3)
+{
+    (void)fy;
+    (void)tmp1;
+    (void)tmp2;
+    (void)tmp3;
+    OIFArrayF64 oif_y = {
+        .nd = 1, .dimensions = (intptr_t[]){N}, .data = N_VGetArrayPointer(y)};
+    OIFArrayF64 oif_J = {.nd = 2, .dimensions = (intptr_t[]){N, N}, .data = JAC_BUFFER};
+
+    int result = OIF_JAC_FN(t, &oif_y, &oif_J, user_data);
+
+    if (SUNMatGetID(J) == SUNMATRIX_BAND) {
+        // Elements outside of the band are ignored.
+        for (sunindextype i = 0; i < N; ++i) {
+            sunindextype j_first = i > LOWER_BANDWIDTH ? i - LOWER_BANDWIDTH : 0;
+            sunindextype j_last = i + UPPER_BANDWIDTH < N ? i + UPPER_BANDWIDTH : N - 1;
+            for (sunindextype j = j_first; j <= j_last; ++j) {
+                SM_ELEMENT_B(J, i, j) = JAC_BUFFER[i * N + j];
+            }
+        }
+        return result;
+    }
+
+    // Dense matrices in Sundials are stored in column-major order.
+    for (sunindextype j = 0; j < N; ++j) {
+        sunrealtype *column = SM_COLUMN_D(J, j);
+        for (sunindextype i = 0; i < N; ++i) {
+            column[i] = JAC_BUFFER[i * N + j];
+        }
+    }
+    return result;
+}
+
+// Function that writes the sparse Jacobian to the sparse matrix
+// or assembles it into the dense or banded matrix.
+static int
+cvode_jac_csr(sunrealtype t, N_Vector y, N_Vector fy, SUNMatrix J, void *user_data,
+              N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+{
+    (void)fy;
+    (void)tmp1;
+    (void)tmp2;
+    (void)tmp3;
+    OIFArrayF64 oif_y = {
+        .nd = 1, .dimensions = (intptr_t[]){N}, .data = N_VGetArrayPointer(y)};
+    OIFArrayF64 oif_data = {
+        .nd = 1, .dimensions = (intptr_t[]){JAC_CSR_INDPTR[N]}, .data = JAC_BUFFER};
+
+#if defined(OIF_HAVE_KLU)
+    if (SUNMatGetID(J) == SUNMATRIX_SPARSE) {
+        // The matrix has the same CSR layout, so the values are written to it directly,
+        // and the pattern is restored after CVODE has zeroed the matrix.
+        sunindextype *indptr = SUNSparseMatrix_IndexPointers(J);
+        sunindextype *indices = SUNSparseMatrix_IndexValues(J);
+        memcpy(indptr, JAC_CSR_INDPTR, sizeof(*indptr) * (N + 1));
+        memcpy(indices, JAC_CSR_INDICES, sizeof(*indices) * JAC_CSR_INDPTR[N]);
+        oif_data.data = SUNSparseMatrix_Data(J);
+        return OIF_JAC_CSR_FN(t, &oif_y, &oif_data, user_data);
+    }
+#endif
 
+    int result = OIF_JAC_CSR_FN(t, &oif_y, &oif_data, user_data);
+
+    SUNMatZero(J);
+    bool is_band = SUNMatGetID(J) == SUNMATRIX_BAND;
+    for (sunindextype i = 0; i < N; ++i) {
+        for (sunindextype k = JAC_CSR_INDPTR[i]; k < JAC_CSR_INDPTR[i + 1]; ++k) {
+            sunindextype j = JAC_CSR_INDICES[k];
+            if (!is_band) {
+                SM_ELEMENT_D(J, i, j) = JAC_BUFFER[k];
+            }
+            else if (j - i <= UPPER_BANDWIDTH && i - j <= LOWER_BANDWIDTH) {
+                SM_ELEMENT_B(J, i, j) = JAC_BUFFER[k];
+            }
+        }
+    }
     return result;
 }
+
+// Function that computes the Jacobian-vector product Jv = J(t, y) v.
+static int
+cvode_jac_times(N_Vector v, N_Vector Jv, sunrealtype t, N_Vector y, N_Vector fy,
+                void *user_data, N_Vector tmp)
+{
+    (void)fy;
+    (void)tmp;
+    intptr_t dims[] = {N};
+    OIFArrayF64 oif_v = {.nd = 1, .dimensions = dims, .data = N_VGetArrayPointer(v)};
+    OIFArrayF64 oif_Jv = {.nd = 1, .dimensions = dims, .data = N_VGetArrayPointer(Jv)};
+    OIFArrayF64 oif_y = {.nd = 1, .dimensions = dims, .data = N_VGetArrayPointer(y)};
+
+    return OIF_JAC_TIMES_FN(t, &oif_y, &oif_v, &oif_Jv, user_data);
+}
+
+// Function that prepares the preconditioner.
+static int
+cvode_prec_setup(sunrealtype t, N_Vector y, N_Vector fy, sunbooleantype jok,
+                 sunbooleantype *jcurPtr, sunrealtype gamma, void *user_data)
+{
+    (void)fy;
+    OIFArrayF64 oif_y = {
+        .nd = 1, .dimensions = (intptr_t[]){N}, .data = N_VGetArrayPointer(y)};
+
+    int result = OIF_PREC_SETUP_FN(t, &oif_y, jok ? 1 : 0, gamma, user_data);
+
+    // The interface does not report whether the Jacobian data were recomputed,
+    // so they are assumed to be recomputed exactly when reuse is not allowed.
+    *jcurPtr = jok ? SUNFALSE : SUNTRUE;
+    return result;
+}
+
+// Function that solves the preconditioner system P z = r.
+static int
+cvode_prec_solve(sunrealtype t, N_Vector y, N_Vector fy, N_Vector r, N_Vector z,
+                 sunrealtype gamma, sunrealtype delta, int lr, void *user_data)
+{
+    (void)fy;
+    (void)lr;
+    intptr_t dims[] = {N};
+    OIFArrayF64 oif_y = {.nd = 1, .dimensions = dims, .data = N_VGetArrayPointer(y)};
+    OIFArrayF64 oif_r = {.nd = 1, .dimensions = dims, .data = N_VGetArrayPointer(r)};
+    OIFArrayF64 oif_z = {.nd = 1, .dimensions = dims, .data = N_VGetArrayPointer(z)};
+
+    return OIF_PREC_SOLVE_FN(t, &oif_y, &oif_r, &oif_z, gamma, delta, user_data);
+}
+
+// Function that computes the values of the event functions.
+static int
+cvode_events(sunrealtype t, N_Vector y, sunrealtype *gout, void *user_data)
+{
+    OIFArrayF64 oif_y = {
+        .nd = 1, .dimensions = (intptr_t[]){N}, .data = N_VGetArrayPointer(y)};
+    OIFArrayF64 oif_g = {.nd = 1, .dimensions = (intptr_t[]){NUM_EVENTS}, .data = gout};
+
+    return OIF_EVENT_FN(t, &oif_y, &oif_g, user_data);
+}
@@ -0,0 +1,643 @@
+/**
+ * Implementation of the `ivp_ensemble` interface with Sundials CVODE solver.
+ *
+ * Each member of the ensemble has its own Sundials context and CVODE memory block,
+ * so that the members are integrated independently of each other.
+ * A pool of threads integrates them in parallel: the threads take the members
+ * one by one from a shared atomic counter, so that the threads that get
+ * cheap members take more of them, and the load is balanced dynamically.
+ *
+ * If the right-hand side is evaluated for all members at once (batch mode),
+ * the members are integrated in lockstep as one system of size M * N instead,
+ * so that the right-hand side is called once per stage for the whole ensemble.
+ */
+// Required for POSIX threads and `sysconf`.
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cvode/cvode.h>
+#include <nvector/nvector_serial.h>
+#include <sundials/sundials_nvector.h>
+#include <sundials/sundials_types.h>
+#include <sunlinsol/sunlinsol_band.h>
+#include <sunlinsol/sunlinsol_dense.h>
+#include <sunmatrix/sunmatrix_band.h>
+#include <sunmatrix/sunmatrix_dense.h>
+#include <sunnonlinsol/sunnonlinsol_fixedpoint.h>
+#include <sunnonlinsol/sunnonlinsol_newton.h>
+
+#include "oif/api.h"
+#include "oif_impl/ivp_ensemble.h"
+
+static const char *prefix = "[ivp_ensemble::sundials_cvode]";
+
+/*
+ * In Sundials 7.0, `SUNContext_Create` accepts `SUNComm` instead of `void *`
+ * as the first argument.
+ * This is required for compatibility with versions <7.0.
+ */
+#ifndef SUN_COMM_NULL
+#define SUN_COMM_NULL NULL
+#endif
+
+// Right-hand side provided by the interface, shared by all members.
+static oif_ivp_rhs_fn_t OIF_RHS_FN;
+
+// Right-hand side of all members at once; if set, it is used instead of `OIF_RHS_FN`.
+static oif_ivp_ensemble_rhs_batch_fn_t OIF_RHS_BATCH_FN;
+static void *BATCH_USER_DATA;
+
+static int
+cvode_rhs(sunrealtype t, N_Vector y, N_Vector ydot, void *user_data);
+
+static int
+cvode_rhs_batch(sunrealtype t, N_Vector y, N_Vector ydot, void *user_data);
+
+// State of one member of the ensemble.
+typedef struct {
+    SUNContext sunctx;
+    void *cvode_mem;
+    // Vector that wraps the row of the output array during integration.
+    N_Vector y;
+    SUNMatrix A;
+    SUNLinearSolver LS;
+    SUNNonlinearSolver NLS;
+} Member;
+
+static Member *MEMBERS;
+// Number of members.
+static sunindextype M;
+// Number of equations of each member.
+static sunindextype N;
+// User data of the members, set with `set_user_data`.
+static void **USER_DATA;
+// Copy of the initial values, from which the batch system is started.
+static sunrealtype *Y_INITIAL;
+static sunrealtype T_INITIAL;
+
+// The whole ensemble as one system in batch mode; created in `integrate`.
+static Member BATCH;
+// Whether `integrate` has been called since `set_initial_values`.
+// The member and batch systems do not share their states, so switching between
+// `set_rhs_fn` and `set_rhs_batch_fn` is rejected afterwards.
+static bool INTEGRATED;
+// Times passed to the batch right-hand side, equal for all members.
+static sunrealtype *T_BATCH;
+
+// Linear multistep method: `CV_ADAMS` or `CV_BDF`.
+static int LMM = CV_ADAMS;
+static sunrealtype RTOL = 1e-6;
+static sunrealtype ATOL = 1e-8;
+
+// Pool of worker threads.
+// The thread that calls `integrate` takes part in the work as well,
+// so the pool has one thread less than requested.
+typedef struct {
+    pthread_t *threads;
+    int num_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    // Incremented for each task, so that workers distinguish new tasks.
+    unsigned long generation;
+    // Generation at the time the workers are started.
+    unsigned long start_generation;
+    int num_busy;
+    bool shutdown;
+
+    // Current task: integrate all members to `t`.
+    atomic_long next_member;
+    double t;
+    OIFArrayF64 *Y;
+    OIFArrayF64 *status;
+} ThreadPool;
+
+static ThreadPool POOL = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_ready = PTHREAD_COND_INITIALIZER,
+    .work_done = PTHREAD_COND_INITIALIZER,
+};
+// Requested number of threads; zero means the number of available processors.
+static int NUM_THREADS = 0;
+
+static void
+free_member_(Member *member)
+{
+    if (member->cvode_mem != NULL) {
+        CVodeFree(&member->cvode_mem);
+    }
+    if (member->NLS != NULL) {
+        SUNNonlinSolFree(member->NLS);
+    }
+    if (member->LS != NULL) {
+        SUNLinSolFree(member->LS);
+    }
+    if (member->A != NULL) {
+        SUNMatDestroy(member->A);
+    }
+    if (member->y != NULL) {
+        N_VDestroy(member->y);
+    }
+    if (member->sunctx != NULL) {
+        SUNContext_Free(&member->sunctx);
+    }
+    memset(member, 0, sizeof(*member));
+}
+
+static void
+free_members_(void)
+{
+    for (sunindextype m = 0; m < M; ++m) {
+        free_member_(&MEMBERS[m]);
+    }
+    free(MEMBERS);
+    MEMBERS = NULL;
+    free(USER_DATA);
+    USER_DATA = NULL;
+    free_member_(&BATCH);
+    free(Y_INITIAL);
+    Y_INITIAL = NULL;
+    free(T_BATCH);
+    T_BATCH = NULL;
+    M = 0;
+}
+
+/**
+ * Error weights of the batch system.
+ *
+ * CVODE controls the root-mean-square norm of the weighted error over all M * N
+ * components, which allows the error of one member to be sqrt(M) times
+ * larger than the tolerances. The weights are scaled by sqrt(M),
+ * so that the error of each member satisfies the tolerances.
+ */
+static int
+batch_ewt_(N_Vector y, N_Vector ewt, void *user_data)
+{
+    (void)user_data;
+    sunrealtype *y_data = N_VGetArrayPointer(y);
+    sunrealtype *w = N_VGetArrayPointer(ewt);
+    sunrealtype scale = sqrt((sunrealtype)M);
+    for (sunindextype i = 0; i < M * N; ++i) {
+        sunrealtype tol = RTOL * fabs(y_data[i]) + ATOL;
+        if (tol <= 0.0) {
+            return -1;
+        }
+        w[i] = scale / tol;
+    }
+    return 0;
+}
+
+/**
+ * Create the CVODE memory block of the member starting at `y0`.
+ *
+ * In batch mode, the "member" is the whole ensemble of size M * N;
+ * its Jacobian is block diagonal and is stored as a band matrix.
+ */
+static int
+init_member_(Member *member, sunrealtype *y0, sunrealtype t0, void *user_data, bool batch)
+{
+    sunindextype size = batch ? M * N : N;
+    int status = SUNContext_Create(SUN_COMM_NULL, &member->sunctx);
+    if (status) {
+        fprintf(stderr, "%s An error occurred when creating SUNContext\n", prefix);
+        return 1;
+    }
+    member->y = N_VMake_Serial(size, y0, member->sunctx);
+    member->cvode_mem = CVodeCreate(LMM, member->sunctx);
+    if (member->y == NULL || member->cvode_mem == NULL) {
+        fprintf(stderr, "%s Could not create CVODE memory block\n", prefix);
+        return 1;
+    }
+    status = CVodeInit(member->cvode_mem, batch ? cvode_rhs_batch : cvode_rhs, t0, member->y);
+    if (status != CV_SUCCESS) {
+        fprintf(stderr, "%s CVodeInit call failed\n", prefix);
+        return 1;
+    }
+    if (batch) {
+        CVodeWFtolerances(member->cvode_mem, batch_ewt_);
+    }
+    else {
+        CVodeSStolerances(member->cvode_mem, RTOL, ATOL);
+    }
+    CVodeSetUserData(member->cvode_mem, user_data);
+
+    // Fixed-point iteration suits nonstiff problems integrated with the Adams method,
+    // and Newton iteration with the dense solver suits stiff problems and BDF.
+    if (LMM == CV_ADAMS) {
+        member->NLS = SUNNonlinSol_FixedPoint(member->y, 0, member->sunctx);
+    }
+    else {
+        if (batch) {
+            member->A = SUNBandMatrix(size, N - 1, N - 1, member->sunctx);
+        }
+        else {
+            member->A = SUNDenseMatrix(N, N, member->sunctx);
+        }
+        if (member->A == NULL) {
+            fprintf(stderr, "%s Could not create matrix for linear solver\n", prefix);
+            return 2;
+        }
+        if (batch) {
+            member->LS = SUNLinSol_Band(member->y, member->A, member->sunctx);
+        }
+        else {
+            member->LS = SUNLinSol_Dense(member->y, member->A, member->sunctx);
+        }
+        if (member->LS == NULL ||
+            CVodeSetLinearSolver(member->cvode_mem, member->LS, member->A) != CVLS_SUCCESS) {
+            fprintf(stderr, "%s Could not set linear solver\n", prefix);
+            return 3;
+        }
+        member->NLS = SUNNonlinSol_Newton(member->y, member->sunctx);
+    }
+    if (member->NLS == NULL) {
+        fprintf(stderr, "%s Could not create nonlinear solver\n", prefix);
+        return 7;
+    }
+    status = CVodeSetNonlinearSolver(member->cvode_mem, member->NLS);
+    if (status != CV_SUCCESS) {
+        fprintf(stderr, "%s CVodeSetNonlinearSolver failed with code %d\n", prefix, status);
+        return 8;
+    }
+    return 0;
+}
+
+int
+set_initial_values(OIFArrayF64 *Y0, double t0)
+{
+    if (Y0 == NULL || Y0->data == NULL || Y0->nd != 2) {
+        fprintf(stderr, "%s `set_initial_values` expects array with shape (M, N)\n", prefix);
+        return 1;
+    }
+    if (Y0->dimensions[0] > INT_MAX || Y0->dimensions[1] > INT_MAX) {
+        fprintf(stderr,
+                "%s Dimensions of the array are larger "
+                "than the internal Sundials type 'sunindextype'\n",
+                prefix);
+        return 1;
+    }
+
+    if (Y0->dimensions[0] * Y0->dimensions[1] > INT_MAX) {
+        fprintf(stderr,
+                "%s Size of the ensemble is larger "
+                "than the internal Sundials type 'sunindextype'\n",
+                prefix);
+        return 1;
+    }
+
+    free_members_();
+    intptr_t size = Y0->dimensions[0] * Y0->dimensions[1];
+    N = (sunindextype)Y0->dimensions[1];
+    MEMBERS = calloc(Y0->dimensions[0], sizeof(*MEMBERS));
+    USER_DATA = calloc(Y0->dimensions[0], sizeof(*USER_DATA));
+    T_BATCH = malloc(sizeof(*T_BATCH) * Y0->dimensions[0]);
+    Y_INITIAL = malloc(sizeof(*Y_INITIAL) * size);
+    if (MEMBERS == NULL || USER_DATA == NULL || T_BATCH == NULL || Y_INITIAL == NULL) {
+        fprintf(stderr, "%s Could not allocate memory for the ensemble\n", prefix);
+        free_members_();
+        return 1;
+    }
+    M = (sunindextype)Y0->dimensions[0];
+    memcpy(Y_INITIAL, Y0->data, sizeof(*Y_INITIAL) * size);
+    T_INITIAL = t0;
+    INTEGRATED = false;
+
+    for (sunindextype m = 0; m < M; ++m) {
+        // CVODE copies the initial value, so the vector does not keep `Y0`.
+        int status = init_member_(&MEMBERS[m], Y0->data + m * N, t0, NULL, false);
+        if (status != 0) {
+            free_members_();
+            return status;
+        }
+    }
+    return 0;
+}
+
+int
+set_rhs_fn(oif_ivp_rhs_fn_t rhs)
+{
+    if (rhs == NULL) {
+        fprintf(stderr, "%s `set_rhs_fn` accepts non-null function pointer only\n", prefix);
+        return 1;
+    }
+    if (INTEGRATED && OIF_RHS_BATCH_FN != NULL) {
+        fprintf(stderr,
+                "%s Switching from `set_rhs_batch_fn` to `set_rhs_fn` after `integrate` "
+                "requires `set_initial_values`\n",
+                prefix);
+        return 1;
+    }
+    OIF_RHS_FN = rhs;
+    OIF_RHS_BATCH_FN = NULL;
+    return 0;
+}
+
+/**
+ * Set the right-hand side of all members, with which the members are integrated
+ * in lockstep as one system.
+ *
+ * The system starts from the initial values, so after the members have been
+ * integrated with `set_rhs_fn`, `set_initial_values` must be called first.
+ */
+int
+set_rhs_batch_fn(oif_ivp_ensemble_rhs_batch_fn_t rhs, void *user_data)
+{
+    if (rhs == NULL) {
+        fprintf(stderr, "%s `set_rhs_batch_fn` accepts non-null function pointer only\n",
+                prefix);
+        return 1;
+    }
+    if (INTEGRATED && OIF_RHS_BATCH_FN == NULL) {
+        fprintf(stderr,
+                "%s Switching from `set_rhs_fn` to `set_rhs_batch_fn` after `integrate` "
+                "requires `set_initial_values`\n",
+                prefix);
+        return 1;
+    }
+    OIF_RHS_BATCH_FN = rhs;
+    BATCH_USER_DATA = user_data;
+    if (BATCH.cvode_mem != NULL) {
+        CVodeSetUserData(BATCH.cvode_mem, BATCH_USER_DATA);
+    }
+    return 0;
+}
+
+int
+set_user_data(void *user_data)
+{
+    if (MEMBERS == NULL) {
+        fprintf(stderr, "%s `set_initial_values` must be called before `set_user_data`\n",
+                prefix);
+        return 1;
+    }
+    void **user_data_array = user_data;
+    for (sunindextype m = 0; m < M; ++m) {
+        USER_DATA[m] = user_data_array[m];
+        CVodeSetUserData(MEMBERS[m].cvode_mem, USER_DATA[m]);
+    }
+    return 0;
+}
+
+int
+set_tolerances(double rtol, double atol)
+{
+    RTOL = rtol;
+    ATOL = atol;
+    for (sunindextype m = 0; m < M; ++m) {
+        CVodeSStolerances(MEMBERS[m].cvode_mem, rtol, atol);
+    }
+    return 0;
+}
+
+/**
+ * Select the linear multistep method: "adams" for nonstiff problems
+ * or "bdf" for stiff problems.
+ *
+ * Must be called before `set_initial_values`, as CVODE cannot change
+ * the method of the existing memory blocks.
+ */
+int
+set_integrator(const char *integrator_name)
+{
+    if (MEMBERS != NULL) {
+        fprintf(stderr, "%s `set_integrator` must be called before `set_initial_values`\n",
+                prefix);
+        return 1;
+    }
+    if (strcmp(integrator_name, "adams") == 0) {
+        LMM = CV_ADAMS;
+    }
+    else if (strcmp(integrator_name, "bdf") == 0) {
+        LMM = CV_BDF;
+    }
+    else {
+        fprintf(stderr, "%s Unknown integrator '%s', supported integrators: adams, bdf\n",
+                prefix, integrator_name);
+        return 1;
+    }
+    return 0;
+}
+
+// Integrate the members taken from the shared counter until none are left.
+static void
+integrate_members_(void)
+{
+    long m;
+    while ((m = atomic_fetch_add(&POOL.next_member, 1)) < M) {
+        Member *member = &MEMBERS[m];
+        sunrealtype tret;
+        N_VSetArrayPointer(POOL.Y->data + m * N, member->y);
+        int ier = CVode(member->cvode_mem, POOL.t, member->y, &tret, CV_NORMAL);
+        POOL.status->data[m] = ier == CV_SUCCESS ? 0 : ier;
+    }
+}
+
+static void *
+worker_(void *arg)
+{
+    (void)arg;
+    // The first task may be posted before the worker starts waiting for it,
+    // so the worker does not read the current generation itself.
+    unsigned long generation = POOL.start_generation;
+    pthread_mutex_lock(&POOL.lock);
+    while (true) {
+        while (POOL.generation == generation && !POOL.shutdown) {
+            pthread_cond_wait(&POOL.work_ready, &POOL.lock);
+        }
+        if (POOL.shutdown) {
+            break;
+        }
+        generation = POOL.generation;
+        pthread_mutex_unlock(&POOL.lock);
+
+        integrate_members_();
+
+        pthread_mutex_lock(&POOL.lock);
+        if (--POOL.num_busy == 0) {
+            pthread_cond_signal(&POOL.work_done);
+        }
+    }
+    pthread_mutex_unlock(&POOL.lock);
+    return NULL;
+}
+
+static void
+stop_pool_(void)
+{
+    pthread_mutex_lock(&POOL.lock);
+    POOL.shutdown = true;
+    pthread_cond_broadcast(&POOL.work_ready);
+    pthread_mutex_unlock(&POOL.lock);
+    for (int i = 0; i < POOL.num_threads; ++i) {
+        pthread_join(POOL.threads[i], NULL);
+    }
+    free(POOL.threads);
+    POOL.threads = NULL;
+    POOL.num_threads = 0;
+    POOL.shutdown = false;
+}
+
+static int
+start_pool_(int num_threads)
+{
+    POOL.threads = malloc(sizeof(*POOL.threads) * num_threads);
+    if (POOL.threads == NULL) {
+        fprintf(stderr, "%s Could not allocate memory for the thread pool\n", prefix);
+        return 1;
+    }
+    POOL.start_generation = POOL.generation;
+    for (int i = 0; i < num_threads; ++i) {
+        if (pthread_create(&POOL.threads[i], NULL, worker_, NULL) != 0) {
+            fprintf(stderr, "%s Could not create thread\n", prefix);
+            POOL.num_threads = i;
+            stop_pool_();
+            return 1;
+        }
+    }
+    POOL.num_threads = num_threads;
+    return 0;
+}
+
+// Stop the threads before the library is unloaded.
+__attribute__((destructor)) static void
+finalize_(void)
+{
+    if (POOL.threads != NULL) {
+        stop_pool_();
+    }
+    free_members_();
+}
+
+int
+set_num_threads(int num_threads)
+{
+    if (num_threads < 0) {
+        fprintf(stderr, "%s Number of threads must be nonnegative\n", prefix);
+        return 1;
+    }
+    // The pool is resized in `integrate`, when the number of members is known.
+    NUM_THREADS = num_threads;
+    return 0;
+}
+
+// Integrate all members in lockstep as one system; they share the status.
+static int
+integrate_batch_(double t, OIFArrayF64 *Y, OIFArrayF64 *status)
+{
+    if (BATCH.cvode_mem == NULL) {
+        int ier = init_member_(&BATCH, Y_INITIAL, T_INITIAL, BATCH_USER_DATA, true);
+        if (ier != 0) {
+            free_member_(&BATCH);
+            return ier;
+        }
+    }
+    sunrealtype tret;
+    N_VSetArrayPointer(Y->data, BATCH.y);
+    int ier = CVode(BATCH.cvode_mem, t, BATCH.y, &tret, CV_NORMAL);
+    for (sunindextype m = 0; m < M; ++m) {
+        status->data[m] = ier == CV_SUCCESS ? 0 : ier;
+    }
+    return 0;
+}
+
+int
+integrate(double t, OIFArrayF64 *Y, OIFArrayF64 *status)
+{
+    if (MEMBERS == NULL || (OIF_RHS_FN == NULL && OIF_RHS_BATCH_FN == NULL)) {
+        fprintf(stderr,
+                "%s `set_initial_values` and `set_rhs_fn` or `set_rhs_batch_fn` "
+                "must be called "
+                "before `integrate`\n",
+                prefix);
+        return 1;
+    }
+    if (Y->nd != 2 || Y->dimensions[0] != M || Y->dimensions[1] != N || status->nd != 1 ||
+        status->dimensions[0] != M) {
+        fprintf(stderr,
+                "%s `integrate` expects the output arrays with shapes (%d, %d) and (%d,)\n",
+                prefix, (int)M, (int)N, (int)M);
+        return 1;
+    }
+
+    INTEGRATED = true;
+    if (OIF_RHS_BATCH_FN != NULL) {
+        return integrate_batch_(t, Y, status);
+    }
+
+    int num_threads = NUM_THREADS;
+    if (num_threads == 0) {
+        num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    // There is no use in more threads than members.
+    if (num_threads > M) {
+        num_threads = M;
+    }
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    if (POOL.num_threads != num_threads - 1) {
+        if (POOL.threads != NULL) {
+            stop_pool_();
+        }
+        if (num_threads > 1 && start_pool_(num_threads - 1) != 0) {
+            return 1;
+        }
+    }
+
+    pthread_mutex_lock(&POOL.lock);
+    POOL.t = t;
+    POOL.Y = Y;
+    POOL.status = status;
+    atomic_store(&POOL.next_member, 0);
+    POOL.num_busy = POOL.num_threads;
+    POOL.generation++;
+    pthread_cond_broadcast(&POOL.work_ready);
+    pthread_mutex_unlock(&POOL.lock);
+
+    integrate_members_();
+
+    pthread_mutex_lock(&POOL.lock);
+    while (POOL.num_busy > 0) {
+        pthread_cond_wait(&POOL.work_done, &POOL.lock);
+    }
+    pthread_mutex_unlock(&POOL.lock);
+
+    return 0;
+}
+
+// Function that computes the right-hand side of the ODE system of one member.
+static int
+cvode_rhs(sunrealtype t, N_Vector y, N_Vector ydot, void *user_data)
+{
+    intptr_t dims[] = {N};
+    OIFArrayF64 oif_y = {.nd = 1, .dimensions = dims, .data = N_VGetArrayPointer(y)};
+    OIFArrayF64 oif_ydot = {.nd = 1, .dimensions = dims, .data = N_VGetArrayPointer(ydot)};
+
+    return OIF_RHS_FN(t, &oif_y, &oif_ydot, user_data);
+}
+
+// Function that computes the right-hand side of all members at once.
+static int
+cvode_rhs_batch(sunrealtype t, N_Vector y, N_Vector ydot, void *user_data)
+{
+    for (sunindextype m = 0; m < M; ++m) {
+        T_BATCH[m] = t;
+    }
+    intptr_t t_dims[] = {M};
+    intptr_t dims[] = {M, N};
+    OIFArrayF64 oif_t = {.nd = 1, .dimensions = t_dims, .data = T_BATCH};
+    OIFArrayF64 oif_Y = {.nd = 2, .dimensions = dims, .data = N_VGetArrayPointer(y)};
+    OIFArrayF64 oif_Ydot = {.nd = 2, .dimensions = dims, .data = N_VGetArrayPointer(ydot)};
+
+    return OIF_RHS_BATCH_FN(&oif_t, &oif_Y, &oif_Ydot, user_data);
+}
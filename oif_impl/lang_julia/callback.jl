@@ -1,30 +1,217 @@
 module CallbackWrapper
-export make_wrapper_for_c_callback
+export make_wrapper_over_c_callback
 
 import SciMLBase
 
-using OpenInterfaces: OIFArrayF64
+using OpenInterfaces: OIFArrayF64, OIF_INT, OIF_FLOAT64, OIF_ARRAY_F64, OIF_USER_DATA
 
-function make_wrapper_over_c_callback(fn_c::Ptr{Cvoid})::Function
-    function wrapper(t, y, ydot, user_data)::Int
-        if typeof(user_data) == SciMLBase.NullParameters
-            user_data = C_NULL
-        end
+"""
+Callable wrapper over a C function with the signature of the right-hand side
+`int rhs(double t, OIFArrayF64 *y, OIFArrayF64 *ydot, void *user_data)`,
+which is also the signature of Jacobian functions.
 
-        oif_y = _oif_array_f64_pointer_from_array_f64(y)
-        oif_ydot = _oif_array_f64_pointer_from_array_f64(ydot)
+Buffers for dimensions and `OIFArrayF64` structs are allocated once
+and reused on every call, so that calling the wrapper does not allocate.
+"""
+mutable struct CCallbackRHS <: Function
+    fn_c::Ptr{Cvoid}
+    y_dims::Vector{Int64}
+    ydot_dims::Vector{Int64}
+    oif_y::Base.RefValue{OIFArrayF64}
+    oif_ydot::Base.RefValue{OIFArrayF64}
+end
+
+function CCallbackRHS(fn_c::Ptr{Cvoid})
+    null_array = OIFArrayF64(0, C_NULL, C_NULL)
+    return CCallbackRHS(fn_c, Int64[], Int64[], Ref(null_array), Ref(null_array))
+end
+
+"""
+Callable wrapper over a C function with the signature of Jacobian-vector products
+`int jac_times(double t, OIFArrayF64 *y, OIFArrayF64 *v, OIFArrayF64 *Jv, void *user_data)`.
+"""
+mutable struct CCallbackJacTimes <: Function
+    fn_c::Ptr{Cvoid}
+    y_dims::Vector{Int64}
+    v_dims::Vector{Int64}
+    Jv_dims::Vector{Int64}
+    oif_y::Base.RefValue{OIFArrayF64}
+    oif_v::Base.RefValue{OIFArrayF64}
+    oif_Jv::Base.RefValue{OIFArrayF64}
+end
+
+function CCallbackJacTimes(fn_c::Ptr{Cvoid})
+    null_array = OIFArrayF64(0, C_NULL, C_NULL)
+    return CCallbackJacTimes(
+        fn_c, Int64[], Int64[], Int64[], Ref(null_array), Ref(null_array), Ref(null_array)
+    )
+end
+
+"""
+Callable wrapper over a C function with the signature of preconditioner setup
+`int setup(double t, OIFArrayF64 *y, int jok, double gamma, void *user_data)`.
+"""
+mutable struct CCallbackPrecSetup <: Function
+    fn_c::Ptr{Cvoid}
+    y_dims::Vector{Int64}
+    oif_y::Base.RefValue{OIFArrayF64}
+end
+
+function CCallbackPrecSetup(fn_c::Ptr{Cvoid})
+    return CCallbackPrecSetup(fn_c, Int64[], Ref(OIFArrayF64(0, C_NULL, C_NULL)))
+end
+
+"""
+Callable wrapper over a C function with the signature of preconditioner solve
+`int solve(double t, OIFArrayF64 *y, OIFArrayF64 *r, OIFArrayF64 *z,
+double gamma, double delta, void *user_data)`.
+"""
+mutable struct CCallbackPrecSolve <: Function
+    fn_c::Ptr{Cvoid}
+    y_dims::Vector{Int64}
+    r_dims::Vector{Int64}
+    z_dims::Vector{Int64}
+    oif_y::Base.RefValue{OIFArrayF64}
+    oif_r::Base.RefValue{OIFArrayF64}
+    oif_z::Base.RefValue{OIFArrayF64}
+end
+
+function CCallbackPrecSolve(fn_c::Ptr{Cvoid})
+    null_array = OIFArrayF64(0, C_NULL, C_NULL)
+    return CCallbackPrecSolve(
+        fn_c, Int64[], Int64[], Int64[], Ref(null_array), Ref(null_array), Ref(null_array)
+    )
+end
+
+const RHS_ARG_TYPES = [OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA]
+const JAC_TIMES_ARG_TYPES =
+    [OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA]
+const PREC_SETUP_ARG_TYPES = [OIF_FLOAT64, OIF_ARRAY_F64, OIF_INT, OIF_FLOAT64, OIF_USER_DATA]
+const PREC_SOLVE_ARG_TYPES = [
+    OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_FLOAT64, OIF_FLOAT64,
+    OIF_USER_DATA,
+]
+
+# Types of the wrappers that `make_wrapper_over_c_callback` returns.
+const CALLBACK_TYPES = [CCallbackRHS, CCallbackJacTimes, CCallbackPrecSetup, CCallbackPrecSolve]
+
+"""
+Wrap the C function `fn_c` with arguments of `arg_types` into a Julia callable.
+"""
+function make_wrapper_over_c_callback(fn_c::Ptr{Cvoid}, arg_types::Vector{Int32})::Function
+    if arg_types == RHS_ARG_TYPES
+        return CCallbackRHS(fn_c)
+    elseif arg_types == JAC_TIMES_ARG_TYPES
+        return CCallbackJacTimes(fn_c)
+    elseif arg_types == PREC_SETUP_ARG_TYPES
+        return CCallbackPrecSetup(fn_c)
+    elseif arg_types == PREC_SOLVE_ARG_TYPES
+        return CCallbackPrecSolve(fn_c)
+    end
+    throw(ArgumentError("Callbacks with argument types $arg_types are not supported"))
+end
+
+function (w::CCallbackRHS)(t, y, ydot, user_data)::Int
+    _update_dims!(w.y_dims, y)
+    _update_dims!(w.ydot_dims, ydot)
+
+    status = GC.@preserve w y ydot begin
+        w.oif_y[] = OIFArrayF64(ndims(y), pointer(w.y_dims), pointer(y))
+        w.oif_ydot[] = OIFArrayF64(ndims(ydot), pointer(w.ydot_dims), pointer(ydot))
+        ccall(
+            w.fn_c,
+            Cint,
+            (Float64, Ptr{OIFArrayF64}, Ptr{OIFArrayF64}, Ptr{Cvoid}),
+            t,
+            w.oif_y,
+            w.oif_ydot,
+            _c_user_data(user_data),
+        )
+    end
+    return status
+end
+
+function (w::CCallbackJacTimes)(t, y, v, Jv, user_data)::Int
+    _update_dims!(w.y_dims, y)
+    _update_dims!(w.v_dims, v)
+    _update_dims!(w.Jv_dims, Jv)
+
+    status = GC.@preserve w y v Jv begin
+        w.oif_y[] = OIFArrayF64(ndims(y), pointer(w.y_dims), pointer(y))
+        w.oif_v[] = OIFArrayF64(ndims(v), pointer(w.v_dims), pointer(v))
+        w.oif_Jv[] = OIFArrayF64(ndims(Jv), pointer(w.Jv_dims), pointer(Jv))
+        ccall(
+            w.fn_c,
+            Cint,
+            (Float64, Ptr{OIFArrayF64}, Ptr{OIFArrayF64}, Ptr{OIFArrayF64}, Ptr{Cvoid}),
+            t,
+            w.oif_y,
+            w.oif_v,
+            w.oif_Jv,
+            _c_user_data(user_data),
+        )
+    end
+    return status
+end
+
+function (w::CCallbackPrecSetup)(t, y, jok, gamma, user_data)::Int
+    _update_dims!(w.y_dims, y)
 
-        @ccall $fn_c(t::Float64, oif_y::Ptr{OIFArrayF64}, oif_ydot::Ptr{OIFArrayF64}, user_data::Ptr{Cvoid})::Cint
-        return 0
+    status = GC.@preserve w y begin
+        w.oif_y[] = OIFArrayF64(ndims(y), pointer(w.y_dims), pointer(y))
+        ccall(
+            w.fn_c,
+            Cint,
+            (Float64, Ptr{OIFArrayF64}, Cint, Float64, Ptr{Cvoid}),
+            t,
+            w.oif_y,
+            jok,
+            gamma,
+            _c_user_data(user_data),
+        )
     end
-    return wrapper
+    return status
 end
 
-function _oif_array_f64_pointer_from_array_f64(arr::AbstractArray{T, N}) where {T<:Float64, N}
-    ndim = ndims(arr)
-    dimensions = Base.unsafe_convert(Ptr{Clong}, collect(size(arr)))
-    data = Base.unsafe_convert(Ptr{Float64}, arr)
-    oif_arr = Ref(OIFArrayF64(ndim, dimensions, data))
-    return oif_arr
+function (w::CCallbackPrecSolve)(t, y, r, z, gamma, delta, user_data)::Int
+    _update_dims!(w.y_dims, y)
+    _update_dims!(w.r_dims, r)
+    _update_dims!(w.z_dims, z)
+
+    status = GC.@preserve w y r z begin
+        w.oif_y[] = OIFArrayF64(ndims(y), pointer(w.y_dims), pointer(y))
+        w.oif_r[] = OIFArrayF64(ndims(r), pointer(w.r_dims), pointer(r))
+        w.oif_z[] = OIFArrayF64(ndims(z), pointer(w.z_dims), pointer(z))
+        ccall(
+            w.fn_c,
+            Cint,
+            (
+                Float64, Ptr{OIFArrayF64}, Ptr{OIFArrayF64}, Ptr{OIFArrayF64},
+                Float64, Float64, Ptr{Cvoid},
+            ),
+            t,
+            w.oif_y,
+            w.oif_r,
+            w.oif_z,
+            gamma,
+            delta,
+            _c_user_data(user_data),
+        )
+    end
+    return status
 end
+
+function _update_dims!(dims::Vector{Int64}, arr::AbstractArray{Float64})
+    if length(dims) != ndims(arr)
+        resize!(dims, ndims(arr))
+    end
+    for i in 1:ndims(arr)
+        @inbounds dims[i] = size(arr, i)
+    end
+    return nothing
+end
+
+_c_user_data(::SciMLBase.NullParameters) = C_NULL
+_c_user_data(::Nothing) = C_NULL
+_c_user_data(user_data::Ptr) = Ptr{Cvoid}(user_data)
 end
@@ -0,0 +1,17 @@
+# Build a Julia system image that contains OrdinaryDiffEq and the Julia modules
+# of Open Interfaces, so that Julia implementations start without compilation.
+#
+# Usage (from the root of the repository, in an environment
+# with PackageCompiler, OrdinaryDiffEq, SciMLBase and OpenInterfaces):
+#     julia oif_impl/lang_julia/create_sysimage.jl [path/to/oif_sysimage.so]
+# Then set the environment variable `OIF_JULIA_SYSIMAGE` to the resulting path
+# or call `oif_set_julia_sysimage` before loading Julia implementations.
+using PackageCompiler
+
+sysimage_path = length(ARGS) >= 1 ? ARGS[1] : joinpath(pwd(), "oif_sysimage.so")
+
+create_sysimage(
+    ["OrdinaryDiffEq", "SciMLBase", "OpenInterfaces"];
+    sysimage_path=sysimage_path,
+    script=joinpath(@__DIR__, "sysimage_script.jl"),
+)
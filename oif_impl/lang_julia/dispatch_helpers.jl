@@ -0,0 +1,107 @@
+module DispatchHelpers
+export root!, unroot!, precompile_methods
+
+# Objects referenced from C code of the dispatcher
+# that must not be collected by the garbage collector.
+# Values are the numbers of references.
+const ROOTS = IdDict{Any,Int}()
+
+function root!(x)::Nothing
+    ROOTS[x] = get(ROOTS, x, 0) + 1
+    return nothing
+end
+
+function unroot!(x)::Nothing
+    count = get(ROOTS, x, 0)
+    if count <= 1
+        delete!(ROOTS, x)
+    else
+        ROOTS[x] = count - 1
+    end
+    return nothing
+end
+
+# Types of the arguments that the dispatcher passes to implementations,
+# see `call_impl_` in `dispatch_julia.c`: integers, floating-point numbers,
+# strings, arrays that wrap `OIFArrayF64`, and user data from C.
+const ARGUMENT_TYPES = Any[Int64, Float64, String, Vector{Float64}, Matrix{Float64}, Ptr{Cvoid}]
+
+# Methods with more combinations of argument types are not precompiled.
+const MAX_SIGNATURES = 64
+
+"""
+    precompile_methods(mod::Module, callback_file::String)::Int
+
+Precompile the exported methods of the implementation module `mod`
+that take `mod.Self` as the first argument, for the concrete argument types
+that the dispatcher passes to them.
+
+A declared parameter type is replaced with the types in `ARGUMENT_TYPES`
+and the wrappers over C callbacks that are subtypes of it.
+Untyped parameters of implementations take callbacks or user data,
+so they are replaced with the wrappers and `Ptr{Cvoid}`.
+The wrappers are defined in `callback_file` that is included
+only when some method takes a callback.
+Return the number of successfully precompiled signatures.
+"""
+function precompile_methods(mod::Module, callback_file::String)::Int
+    callback_types = nothing
+    count = 0
+    for name in names(mod)
+        f = getfield(mod, name)
+        f isa Function || continue
+        for m in methods(f)
+            m.module === mod || continue
+            params = Base.unwrap_unionall(m.sig).parameters
+            if length(params) < 2 || params[2] !== mod.Self
+                continue
+            end
+            try
+                if isnothing(callback_types) && any(_takes_callback, params[3:end])
+                    callback_types = _callback_types(callback_file)
+                end
+                candidates = [
+                    _argument_types(P, something(callback_types, Any[])) for P in params[3:end]
+                ]
+                signatures = Iterators.product(candidates...)
+                length(signatures) <= MAX_SIGNATURES || continue
+                for types in signatures
+                    if precompile(f, Tuple{mod.Self,types...})
+                        count += 1
+                    end
+                end
+            catch
+                # Signatures that cannot be expressed with concrete types,
+                # for example, with varargs, are compiled on the first call.
+            end
+        end
+    end
+    return count
+end
+
+function _takes_callback(P)::Bool
+    P isa TypeVar && (P = P.ub)
+    return P isa Type && (Function <: P || P <: Function)
+end
+
+function _argument_types(P, callback_types::Vector{Any})::Vector{Any}
+    P isa TypeVar && (P = P.ub)
+    if isconcretetype(P)
+        return Any[P]
+    elseif P === Any
+        return Any[callback_types..., Ptr{Cvoid}]
+    end
+    return filter(T -> T <: P, Any[ARGUMENT_TYPES..., callback_types...])
+end
+
+function _callback_types(callback_file::String)::Vector{Any}
+    try
+        isdefined(Main, :CallbackWrapper) || Base.include(Main, callback_file)
+        callback_module = Base.invokelatest(getfield, Main, :CallbackWrapper)
+        return collect(Any, Base.invokelatest(getfield, callback_module, :CALLBACK_TYPES))
+    catch
+        # Methods are then precompiled without the wrappers.
+        return Any[]
+    end
+end
+end
@@ -1,9 +1,15 @@
+// Required for `setenv`.
+#define _POSIX_C_SOURCE 200112L
+
 #include <assert.h>
 #include <dlfcn.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <julia.h>
 
@@ -18,38 +24,290 @@ enum {
     JULIA_MAX_MODULE_NAME_,
 };
 
+enum {
+    JULIA_MAX_NDIMS_ = 8,
+    JULIA_MAX_ARGS_ = 32,
+    JULIA_MAX_METHODS_ = 16,
+    JULIA_MAX_METHOD_NAME_ = 64,
+};
+
 static const char *OIF_IMPL_ROOT_DIR = NULL;
 
-static bool INITIALIZED_ = false;
+// Whether to print diagnostic information, see `init_module_`.
+static bool VERBOSE_ = false;
+
+// Whether `init_module_` succeeded; it runs under `INIT_LOCK_`, see `load_impl`.
+static atomic_bool INITIALIZED_ = false;
+static pthread_mutex_t INIT_LOCK_ = PTHREAD_MUTEX_INITIALIZER;
+
+// Serializes loading and unloading of implementations
+// and lazy initialization of the callback module.
+static pthread_mutex_t RUNTIME_LOCK_ = PTHREAD_MUTEX_INITIALIZER;
+
+// Whether the runtime was started by the caller, that is, the caller is Julia code.
+// Then the caller owns the runtime and its threads.
+static bool HOSTED_ = false;
+
+// Number of loaded implementations.
+// The runtime is kept alive until process exit regardless of it,
+// as Julia cannot be initialized again after `jl_atexit_hook`.
+static int IMPL_COUNTER_ = 0;
+
+// Whether the current thread is known to the Julia runtime:
+// either it initialized the runtime or it was adopted.
+static _Thread_local bool IS_JULIA_THREAD_ = false;
 
 static jl_module_t *CALLBACK_MODULE_;
 
+static jl_module_t *HELPERS_MODULE_;
+
+// Functions used for keeping Julia objects referenced from C alive.
+static jl_function_t *ROOT_FN_;
+static jl_function_t *UNROOT_FN_;
+
+// Types `NTuple{N, Int}` and `Array{Float64, N}` for converting arrays,
+// indexed by the number of dimensions and filled during initialization.
+// Types are interned by Julia, so the pointers stay valid.
+static jl_datatype_t *DIMS_TYPES_[JULIA_MAX_NDIMS_ + 1];
+static jl_value_t *ARRAY_TYPES_[JULIA_MAX_NDIMS_ + 1];
+
+// Functions used for reporting exceptions.
+static jl_function_t *SPRINT_FN_;
+static jl_function_t *SHOWERROR_FN_;
+static jl_function_t *CATCH_BACKTRACE_FN_;
+
+typedef struct {
+    char name[JULIA_MAX_METHOD_NAME_];
+    jl_function_t *fn;
+} JuliaMethod;
+
 typedef struct {
     ImplInfo base;
     char module_name[64];
     jl_module_t *module;
     jl_value_t *self;
+    // Serializes calls from different threads, as they share `args` and `methods`.
+    pthread_mutex_t lock;
+    // Rooted `Vector{Any}` that holds the arguments of a call,
+    // so that there is no need to push a GC frame on each call.
+    jl_array_t *args;
+    // Methods resolved on the first call to them.
+    size_t num_methods;
+    JuliaMethod methods[JULIA_MAX_METHODS_];
 } JuliaImplInfo;
 
 
+/**
+ * Print and clear the pending Julia exception.
+ *
+ * Does nothing if there is none, for example, when the error is not
+ * a Julia exception or the exception has already been handled by a callee.
+ */
 static void
 handle_exception_(void)
 {
     jl_value_t *exc = jl_exception_occurred();
-    jl_value_t *sprint_fn = jl_get_function(jl_base_module, "sprint");
-    jl_value_t *showerror_fn = jl_get_function(jl_base_module, "showerror");
-    jl_value_t *catch_backtrace_fn = jl_get_function(jl_base_module, "catch_backtrace");
-
-    jl_value_t *backtrace = jl_call0(catch_backtrace_fn);
-    const char *exc_msg = jl_string_ptr(jl_call3(sprint_fn, showerror_fn, exc, backtrace));
+    if (exc == NULL) {
+        return;
+    }
+    jl_value_t *backtrace = jl_call0(CATCH_BACKTRACE_FN_);
+    const char *exc_msg =
+        jl_string_ptr(jl_call3(SPRINT_FN_, SHOWERROR_FN_, exc, backtrace));
     printf("[%s] ERROR: %s\n", prefix_, exc_msg);
 
     jl_exception_clear();
 }
 
+/**
+ * Find a module with the given name in `Main`.
+ *
+ * Modules are already there when they were loaded before
+ * or when Julia started from a system image that contains them.
+ *
+ * @return The module if it is defined, `NULL` otherwise
+ */
+static jl_module_t *
+find_main_module_(const char *module_name)
+{
+    jl_value_t *value = jl_get_global(jl_main_module, jl_symbol(module_name));
+    if (value != NULL && jl_is_module(value)) {
+        return (jl_module_t *)value;
+    }
+    return NULL;
+}
+
+/**
+ * Include a Julia file from `oif_impl/lang_julia` and import the module from it.
+ *
+ * @return The module on success, `NULL` otherwise
+ */
+static jl_module_t *
+include_dispatch_module_(const char *filename, const char *module_name)
+{
+    jl_module_t *module = find_main_module_(module_name);
+    if (module != NULL) {
+        return module;
+    }
+
+    char statement[512];
+    int nchars_written = snprintf(statement, 512, "include(\"%s/oif_impl/lang_julia/%s\")",
+                                  OIF_IMPL_ROOT_DIR, filename);
+    if (nchars_written >= 512 - 1) {
+        fprintf(stderr,
+                "[%s] Could not execute include statement for `%s` "
+                "while the provided buffer is only 512 characters, and %d "
+                "characters are supposed to be written\n",
+                prefix_, filename, nchars_written + 1);
+        return NULL;
+    }
+    jl_eval_string(statement);
+    if (jl_exception_occurred()) {
+        handle_exception_();
+        return NULL;
+    }
+    snprintf(statement, 512, "import .%s", module_name);
+    jl_eval_string(statement);
+    if (jl_exception_occurred()) {
+        handle_exception_();
+        return NULL;
+    }
+    module = (jl_module_t *)jl_eval_string(module_name);
+    if (jl_exception_occurred()) {
+        handle_exception_();
+        return NULL;
+    }
+    return module;
+}
+
+static int
+root_(jl_value_t *value)
+{
+    jl_call1(ROOT_FN_, value);
+    if (jl_exception_occurred()) {
+        handle_exception_();
+        return -1;
+    }
+    return 0;
+}
+
+static void
+unroot_(jl_value_t *value)
+{
+    jl_call1(UNROOT_FN_, value);
+    if (jl_exception_occurred()) {
+        handle_exception_();
+    }
+}
+
+/**
+ * Acquire `mutex` from any thread.
+ *
+ * Threads known to Julia wait in the GC-safe state, so that a collection
+ * requested by the thread holding the mutex does not wait for them forever.
+ */
+static void
+lock_(pthread_mutex_t *mutex)
+{
+    if (pthread_mutex_trylock(mutex) == 0) {
+        return;
+    }
+    if (!jl_is_initialized() || jl_get_pgcstack() == NULL) {
+        pthread_mutex_lock(mutex);
+        return;
+    }
+    int8_t gc_state = jl_gc_safe_enter(jl_current_task->ptls);
+    pthread_mutex_lock(mutex);
+    jl_gc_safe_leave(jl_current_task->ptls, gc_state);
+}
+
+static void
+unlock_(pthread_mutex_t *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+/**
+ * Find the function for the method with the given name.
+ *
+ * Functions are looked up in the implementation module once
+ * and then kept in `impl_info`.
+ * Must be called with `impl_info->lock` held.
+ *
+ * @return Function on success, `NULL` otherwise
+ */
+static jl_function_t *
+get_method_(JuliaImplInfo *impl_info, const char *method)
+{
+    for (size_t i = 0; i < impl_info->num_methods; ++i) {
+        if (strcmp(impl_info->methods[i].name, method) == 0) {
+            return impl_info->methods[i].fn;
+        }
+    }
+
+    jl_function_t *fn = jl_get_function(impl_info->module, method);
+    if (fn == NULL) {
+        return NULL;
+    }
+
+    if (impl_info->num_methods < JULIA_MAX_METHODS_ &&
+        strlen(method) < JULIA_MAX_METHOD_NAME_ && root_(fn) == 0) {
+        JuliaMethod *entry = &impl_info->methods[impl_info->num_methods];
+        strcpy(entry->name, method);
+        entry->fn = fn;
+        impl_info->num_methods++;
+    }
+    return fn;
+}
+
+static void
+finalize_runtime_(void);
+
+/**
+ * Start the Julia runtime in the calling thread.
+ */
+static void
+start_runtime_(void)
+{
+    // Julia reads the number of threads from the environment during initialization.
+    const char *num_threads = getenv("OIF_JULIA_NUM_THREADS");
+    if (num_threads != NULL) {
+        setenv("JULIA_NUM_THREADS", num_threads, 1);
+    }
+
+    // Start from a custom system image, for example, with precompiled
+    // OrdinaryDiffEq and OIF modules, see `create_sysimage.jl`.
+    const char *sysimage = getenv("OIF_JULIA_SYSIMAGE");
+    if (sysimage != NULL && sysimage[0] != '\0') {
+        char bindir[1024];
+        const char *julia_bindir = getenv("JULIA_BINDIR");
+        if (julia_bindir != NULL) {
+            snprintf(bindir, sizeof(bindir), "%s", julia_bindir);
+        }
+        else {
+            // The same default as in `jl_init`.
+            snprintf(bindir, sizeof(bindir), "%s/../bin", jl_get_libdir());
+        }
+        fprintf(stderr, "[%s] Using system image '%s'\n", prefix_, sysimage);
+        jl_init_with_image(bindir, sysimage);
+    }
+    else {
+        jl_init();
+    }
+}
+
+/**
+ * Start or attach to the Julia runtime and load the dispatch helpers.
+ *
+ * Diagnostic output about loading implementations is printed only
+ * when the environment variable `OIF_DISPATCH_JULIA_VERBOSE` is set.
+ *
+ * @return 0 on success, non-zero otherwise
+ */
 static int
 init_module_(void)
 {
+    VERBOSE_ = getenv("OIF_DISPATCH_JULIA_VERBOSE") != NULL;
+
     OIF_IMPL_ROOT_DIR = getenv("OIF_IMPL_ROOT_DIR");
     if (OIF_IMPL_ROOT_DIR == NULL) {
         fprintf(stderr,
@@ -58,17 +316,94 @@ init_module_(void)
         return -1;
     }
 
-    jl_init();
+    if (jl_is_initialized()) {
+        HOSTED_ = true;
+    }
+    else {
+        start_runtime_();
+    }
+    IS_JULIA_THREAD_ = true;
     static_assert(sizeof(int) == 4, "The code is written in assumption that C int is 32-bit");
 
-    INITIALIZED_ = true;
+    SPRINT_FN_ = jl_get_function(jl_base_module, "sprint");
+    SHOWERROR_FN_ = jl_get_function(jl_base_module, "showerror");
+    CATCH_BACKTRACE_FN_ = jl_get_function(jl_base_module, "catch_backtrace");
+
+    HELPERS_MODULE_ = include_dispatch_module_("dispatch_helpers.jl", "DispatchHelpers");
+    if (HELPERS_MODULE_ == NULL) {
+        return -1;
+    }
+    ROOT_FN_ = jl_get_function(HELPERS_MODULE_, "root!");
+    UNROOT_FN_ = jl_get_function(HELPERS_MODULE_, "unroot!");
+
+    jl_value_t *params[JULIA_MAX_NDIMS_];
+    for (int i = 0; i < JULIA_MAX_NDIMS_; ++i) {
+        params[i] = (jl_value_t *)jl_long_type;
+    }
+    for (int nd = 0; nd <= JULIA_MAX_NDIMS_; ++nd) {
+        DIMS_TYPES_[nd] = (jl_datatype_t *)jl_apply_tuple_type_v(params, nd);
+    }
+    for (int nd = 1; nd <= JULIA_MAX_NDIMS_; ++nd) {
+        ARRAY_TYPES_[nd] = jl_apply_array_type((jl_value_t *)jl_float64_type, nd);
+    }
+
+    if (HOSTED_) {
+        return 0;
+    }
+    atexit(finalize_runtime_);
+
+    // Outside of calls to the dispatcher the initializing thread runs foreign code,
+    // so it must not block garbage collection triggered by other threads.
+    jl_gc_safe_enter(jl_current_task->ptls);
     return 0;
 }
 
 /**
- * Build a Julia tuple from an `intptr_t` array.
+ * Prepare the calling thread for running Julia code.
+ *
+ * Threads not known to Julia are adopted on their first entry.
+ * Known threads switch to the GC-unsafe state, as required for using Julia objects.
+ *
+ * @return GC state to pass to `leave_julia_`
+ */
+static int8_t
+enter_julia_(void)
+{
+    if (!IS_JULIA_THREAD_ && HOSTED_ && jl_get_pgcstack() != NULL) {
+        // Thread of the calling Julia program.
+        IS_JULIA_THREAD_ = true;
+    }
+    if (!IS_JULIA_THREAD_) {
+        jl_adopt_thread();
+        IS_JULIA_THREAD_ = true;
+        // Adopted thread starts in the unsafe state.
+        return JL_GC_STATE_SAFE;
+    }
+    return jl_gc_unsafe_enter(jl_current_task->ptls);
+}
+
+static void
+leave_julia_(int8_t gc_state)
+{
+    jl_gc_unsafe_leave(jl_current_task->ptls, gc_state);
+}
+
+static void
+finalize_runtime_(void)
+{
+    if (IMPL_COUNTER_ > 0) {
+        fprintf(stderr, "[%s] Finalizing Julia with %d implementations still loaded\n",
+                prefix_, IMPL_COUNTER_);
+    }
+    enter_julia_();
+    jl_atexit_hook(0);
+}
+
+/**
+ * Build a Julia `Dims` tuple from an `intptr_t` array.
  *
- * Due to complicated Julia C API, the tuple is created via `jl_eval_string`.
+ * The tuple is filled in place, as `NTuple{N, Int}` is stored inline
+ * without boxing.
  *
  * @param dimensions Array with elements that are non-negative numbers
  * @param ndims Number of the elements in the array
@@ -77,118 +412,101 @@ init_module_(void)
 static jl_value_t *
 build_julia_tuple_from_size_t_array(intptr_t *dimensions, size_t ndims)
 {
-    char *tuple_string = malloc(sizeof(char) * 1024);
-    char *cursor = tuple_string;
-    char *right_bound = &tuple_string[1024 - 1];
-    intptr_t diff = right_bound - cursor;
-    snprintf(tuple_string, diff, "%s", "(");
-    cursor++;
-    char buffer[BUFFER_SIZE_];
-    int chars_written;
-    jl_value_t *tuple = NULL;
+    if (ndims > JULIA_MAX_NDIMS_) {
+        fprintf(stderr,
+                "[build_julia_tuple_from_size_t_array] Arrays with more than %d "
+                "dimensions are not supported\n",
+                JULIA_MAX_NDIMS_);
+        return NULL;
+    }
 
+    jl_value_t *tuple = jl_new_struct_uninit(DIMS_TYPES_[ndims]);
+    intptr_t *tuple_data = (intptr_t *)jl_data_ptr(tuple);
     for (size_t i = 0; i < ndims; ++i) {
-        chars_written = snprintf(buffer, BUFFER_SIZE_, "%zu", dimensions[i]);
-        assert(chars_written >= 1);
-        if (chars_written >= BUFFER_SIZE_) {
-            goto report_too_long;
-        }
-        diff = right_bound - cursor;
-        chars_written = snprintf(cursor, diff, "%s", buffer);
-        assert(chars_written >= 1);
-        if (chars_written >= diff) {
-            goto report_too_long;
-        }
-        cursor += chars_written;
-        diff = right_bound - cursor;
-        if (i < ndims - 1 || ndims == 1) {
-            chars_written = snprintf(cursor, diff, "%s", ",");
-            assert(chars_written >= 1);
-            if (chars_written >= diff) {
-                goto report_too_long;
-            }
-            cursor++;
-        }
-    }
-    diff = right_bound - cursor;
-    chars_written = snprintf(cursor, diff, "%s", ")");
-    if (chars_written >= diff) {
-        fprintf(stderr, "ERROR: the string to copy is too long\n");
-        exit(1);
+        tuple_data[i] = dimensions[i];
     }
 
-    tuple = jl_eval_string(tuple_string);
-    if (jl_exception_occurred()) {
-        const char *p = jl_string_ptr(
-            jl_eval_string("sprint(showerror, ccall(:jl_exception_occurred, Any, ()))"));
-        fprintf(stderr, "%s\n", p);
+    return tuple;
+}
+
+/**
+ * Wrap the data of an `OIFArrayF64` into a Julia array without copying.
+ *
+ * @return Julia array on success, `NULL` otherwise
+ */
+static jl_value_t *
+make_julia_array_from_oif_array_f64_(OIFArrayF64 *oif_array)
+{
+    bool own_buffer = false;
+
+    if (oif_array->nd < 1 || oif_array->nd > JULIA_MAX_NDIMS_) {
+        fprintf(stderr, "[%s] Cannot convert array with %d dimensions\n", prefix_,
+                oif_array->nd);
+        return NULL;
     }
-    goto cleanup;
 
-report_too_long:
-    fprintf(stderr,
-            "[build_julia_tuple_from_size_t_array] The string representation of the julia "
-            "tuple does not fit in the buffer\n");
+    jl_value_t *arr_type = ARRAY_TYPES_[oif_array->nd];
 
-cleanup:
-    free(tuple_string);
+    if (oif_array->nd == 1) {
+        return (jl_value_t *)jl_ptr_to_array_1d(arr_type, oif_array->data,
+                                                oif_array->dimensions[0], own_buffer);
+    }
 
-    return tuple;
+    jl_value_t *dims = NULL;
+    jl_value_t *arr = NULL;
+    JL_GC_PUSH1(&dims);
+    dims = build_julia_tuple_from_size_t_array(oif_array->dimensions, oif_array->nd);
+    if (dims != NULL) {
+        arr = (jl_value_t *)jl_ptr_to_array(arr_type, oif_array->data, dims, own_buffer);
+    }
+    JL_GC_POP();
+
+    return arr;
 }
 
 static jl_value_t *
 make_wrapper_over_c_callback(OIFCallback *p)
 {
     jl_value_t *wrapper = NULL;
+    lock_(&RUNTIME_LOCK_);
     if (CALLBACK_MODULE_ == NULL) {
-        char include_statement[512];
-        int nchars_written = snprintf(include_statement, 512, "include(\"%s/oif_impl/lang_julia/callback.jl\")", OIF_IMPL_ROOT_DIR);
-        if (nchars_written >= 512-1) {
-            fprintf(
-                stderr,
-                "[%s] Could not execute include statement for `callback.jl` "
-                "while the provided buffer is only 512 characters, and %d "
-                "characters are supposed to be written\n",
-                prefix_, nchars_written + 1
-            );
-        }
-        jl_eval_string(include_statement);
-        if (jl_exception_occurred()) {
-            handle_exception_();
-            goto cleanup;
-        }
-        jl_eval_string("import .CallbackWrapper");
-        if (jl_exception_occurred()) {
-            handle_exception_();
-            goto cleanup;
-        }
-        CALLBACK_MODULE_ = (jl_module_t *)jl_eval_string("CallbackWrapper");
-        if (jl_exception_occurred()) {
-            handle_exception_();
-            goto cleanup;
-        }
+        CALLBACK_MODULE_ = include_dispatch_module_("callback.jl", "CallbackWrapper");
+    }
+    jl_module_t *callback_module = CALLBACK_MODULE_;
+    unlock_(&RUNTIME_LOCK_);
+    if (callback_module == NULL) {
+        goto cleanup;
     }
 
-    jl_function_t *fn_callback = jl_get_function(CALLBACK_MODULE_, "make_wrapper_over_c_callback");   
+    jl_function_t *fn_callback =
+        jl_get_function(callback_module, "make_wrapper_over_c_callback");
     assert(fn_callback != NULL);
     assert(p->fn_p_c != NULL);
-    jl_value_t *fn_p_c_wrapped = jl_box_voidpointer(p->fn_p_c);
-    wrapper = jl_call1(fn_callback, fn_p_c_wrapped);
+    jl_value_t *fn_p_c_wrapped = NULL;
+    jl_value_t *arg_types = NULL;
+    JL_GC_PUSH2(&fn_p_c_wrapped, &arg_types);
+    fn_p_c_wrapped = jl_box_voidpointer(p->fn_p_c);
+    // The wrapper is selected by the argument types, which are only read
+    // during the call, so the array does not own the memory.
+    assert(sizeof(*p->arg_types) == sizeof(int32_t));
+    jl_value_t *arg_types_type = jl_apply_array_type((jl_value_t *)jl_int32_type, 1);
+    arg_types =
+        (jl_value_t *)jl_ptr_to_array_1d(arg_types_type, p->arg_types, p->nargs, 0);
+    wrapper = jl_call2(fn_callback, fn_p_c_wrapped, arg_types);
+    JL_GC_POP();
+    if (jl_exception_occurred()) {
+        handle_exception_();
+        wrapper = NULL;
+    }
 
 cleanup:
     return wrapper;
 }
 
-ImplInfo *
-load_impl(const char *impl_details, size_t version_major, size_t version_minor)
+static ImplInfo *
+load_impl_(const char *impl_details, size_t version_major, size_t version_minor)
 {
     int status = 0;
-    if (! INITIALIZED_) {
-        status = init_module_();
-        if (status) {
-            return NULL;
-        }
-    }
     (void)version_major;
     (void)version_minor;
     JuliaImplInfo *result = NULL;
@@ -215,28 +533,33 @@ load_impl(const char *impl_details, size_t version_major, size_t version_minor)
         }
     }
 
-    fprintf(stderr, "[%s] Provided module filename: '%s'\n", prefix_, module_filename);
-    fprintf(stderr, "[%s] Provided module name: '%s'\n", prefix_, module_name);
+    if (VERBOSE_) {
+        fprintf(stderr, "[%s] Provided module filename: '%s'\n", prefix_, module_filename);
+        fprintf(stderr, "[%s] Provided module name: '%s'\n", prefix_, module_name);
+    }
 
     char include_statement[1024];
     sprintf(include_statement, "include(\"%s/oif_impl/impl/%s\")", OIF_IMPL_ROOT_DIR, module_filename);
     char import_statement[1024];
     sprintf(import_statement, "import .%s", module_name);
 
-    jl_value_t *retval;
-    retval = jl_eval_string(include_statement);
-    if (jl_exception_occurred()) {
-        goto catch;
-    }
+    // Including the file again would replace the module and discard compiled code.
+    jl_module_t *module = find_main_module_(module_name);
+    if (module == NULL) {
+        jl_eval_string(include_statement);
+        if (jl_exception_occurred()) {
+            goto catch;
+        }
 
-    retval = jl_eval_string(import_statement);
-    if (jl_exception_occurred()) {
-        goto catch;
-    }
+        jl_eval_string(import_statement);
+        if (jl_exception_occurred()) {
+            goto catch;
+        }
 
-    jl_module_t *module = (jl_module_t *)jl_eval_string(module_name);
-    if (jl_exception_occurred()) {
-        goto catch;
+        module = (jl_module_t *)jl_eval_string(module_name);
+        if (jl_exception_occurred()) {
+            goto catch;
+        }
     }
 
     result = malloc(sizeof *result);
@@ -255,6 +578,9 @@ load_impl(const char *impl_details, size_t version_major, size_t version_minor)
         goto catch;
     }
     result->module = module;
+    result->self = NULL;
+    result->args = NULL;
+    result->num_methods = 0;
 
     char self_statement[512];
     strcpy(self_statement, module_name);
@@ -263,8 +589,37 @@ load_impl(const char *impl_details, size_t version_major, size_t version_minor)
     if (jl_exception_occurred()) {
         goto catch;
     }
+    if (root_(self) != 0) {
+        goto catch;
+    }
     result->self = self;
 
+    result->args = jl_alloc_vec_any(JULIA_MAX_ARGS_);
+    if (root_((jl_value_t *)result->args) != 0) {
+        unroot_(result->self);
+        goto catch;
+    }
+    jl_array_ptr_set(result->args, 0, result->self);
+
+    // Compile methods for the argument types that `call_impl_` passes now,
+    // so that the first call does not pay for it.
+    char callback_file[1024];
+    snprintf(callback_file, sizeof(callback_file), "%s/oif_impl/lang_julia/callback.jl",
+             OIF_IMPL_ROOT_DIR);
+    jl_function_t *precompile_fn = jl_get_function(HELPERS_MODULE_, "precompile_methods");
+    jl_value_t *num_precompiled =
+        jl_call2(precompile_fn, (jl_value_t *)module, jl_cstr_to_string(callback_file));
+    if (jl_exception_occurred()) {
+        // Not fatal: methods will be compiled on the first call.
+        handle_exception_();
+    }
+    else if (VERBOSE_) {
+        fprintf(stderr, "[%s] Precompiled %ld signatures of module '%s'\n", prefix_,
+                (long)jl_unbox_int64(num_precompiled), module_name);
+    }
+
+    pthread_mutex_init(&result->lock, NULL);
+    IMPL_COUNTER_++;
     goto finally;
 
 catch:
@@ -277,19 +632,25 @@ finally:
     return (ImplInfo *)result;
 }
 
-int
-unload_impl(ImplInfo *impl_info_)
+static int
+unload_impl_(ImplInfo *impl_info_)
 {
     assert(impl_info_->dh == OIF_LANG_JULIA);
     JuliaImplInfo *impl_info = (JuliaImplInfo *)impl_info_;
+    for (size_t i = 0; i < impl_info->num_methods; ++i) {
+        unroot_(impl_info->methods[i].fn);
+    }
+    unroot_((jl_value_t *)impl_info->args);
+    unroot_(impl_info->self);
+    pthread_mutex_destroy(&impl_info->lock);
     free(impl_info);
+    IMPL_COUNTER_--;
 
-    jl_atexit_hook(0);
     return 0;
 }
 
-int
-call_impl(ImplInfo *impl_info_, const char *method, OIFArgs *in_args, OIFArgs *out_args)
+static int
+call_impl_(ImplInfo *impl_info_, const char *method, OIFArgs *in_args, OIFArgs *out_args)
 {
     int result = -1;
 
@@ -304,39 +665,62 @@ call_impl(ImplInfo *impl_info_, const char *method, OIFArgs *in_args, OIFArgs *o
     int32_t in_num_args = (int32_t)in_args->num_args;
     int32_t out_num_args = (int32_t)out_args->num_args;
     int32_t num_args = in_num_args + out_num_args + 1;
+    if (num_args > JULIA_MAX_ARGS_) {
+        fprintf(stderr, "[%s] Methods with more than %d arguments are not supported\n",
+                prefix_, JULIA_MAX_ARGS_ - 1);
+        return -1;
+    }
 
-    jl_value_t **julia_args;
-    JL_GC_PUSHARGS(julia_args, num_args);  // NOLINT
+    lock_(&impl_info->lock);
 
-    julia_args[0] = impl_info->self;
+    // The first element is always `impl_info->self`.
+    jl_array_t *julia_args = impl_info->args;
 
     jl_value_t *cur_julia_arg;
     for (int32_t i = 0; i < in_num_args; ++i) {
-        if (in_args->arg_types[i] == OIF_FLOAT64) {
+        if (in_args->arg_types[i] == OIF_INT) {
+            cur_julia_arg = jl_box_int64(*(int *)in_args->arg_values[i]);
+        }
+        else if (in_args->arg_types[i] == OIF_FLOAT64) {
             cur_julia_arg = jl_box_float64(*(double *)in_args->arg_values[i]);
         }
+        else if (in_args->arg_types[i] == OIF_STR) {
+            cur_julia_arg = jl_cstr_to_string(*(char **)in_args->arg_values[i]);
+        }
         else if (in_args->arg_types[i] == OIF_ARRAY_F64) {
             OIFArrayF64 *oif_array = *(OIFArrayF64 **)in_args->arg_values[i];
-            jl_value_t *arr_type = jl_apply_array_type((jl_value_t *)jl_float64_type, 1);
-            jl_value_t *dims =
-                build_julia_tuple_from_size_t_array(oif_array->dimensions, oif_array->nd);
-            bool own_buffer = false;
-            cur_julia_arg =
-                (jl_value_t *)jl_ptr_to_array(arr_type, oif_array->data, (jl_value_t *)dims, own_buffer);
+            cur_julia_arg = make_julia_array_from_oif_array_f64_(oif_array);
+            if (cur_julia_arg == NULL) {
+                goto cleanup;
+            }
         }
         else if (in_args->arg_types[i] == OIF_CALLBACK) {
             OIFCallback *p = in_args->arg_values[i];
-            if (p->src == OIF_LANG_JULIA) {
-                fprintf(
-                    stderr,
-                    "[%s] This code path is not implemented yet\n",
-                    prefix_
-                );
-                exit(1);
+            if (p->src == OIF_LANG_JULIA && p->fn_p_jl != NULL) {
+                // The caller keeps the function object alive.
+                // Passing it directly lets the compiler specialize
+                // the implementation on the function.
+                cur_julia_arg = (jl_value_t *)p->fn_p_jl;
+            }
+            else {
+                cur_julia_arg = make_wrapper_over_c_callback(p);
+                if (cur_julia_arg == NULL) {
+                    goto cleanup;
+                }
+            }
+        }
+        else if (in_args->arg_types[i] == OIF_USER_DATA) {
+            OIFUserData *user_data = in_args->arg_values[i];
+            if (user_data->src == OIF_LANG_JULIA) {
+                cur_julia_arg = (jl_value_t *)user_data->jl;
+            }
+            else if (user_data->src == OIF_LANG_C) {
+                cur_julia_arg = jl_box_voidpointer(user_data->c);
             }
             else {
-                jl_value_t *wrapper = make_wrapper_over_c_callback(p);
-                cur_julia_arg = wrapper;
+                fprintf(stderr, "[%s] Cannot handle user data with src %d\n", prefix_,
+                        user_data->src);
+                goto cleanup;
             }
         }
         else {
@@ -346,7 +730,7 @@ call_impl(ImplInfo *impl_info_, const char *method, OIFArgs *in_args, OIFArgs *o
                     prefix_, i, in_args->arg_types[i]);
             goto cleanup;
         }
-        julia_args[i + 1] = cur_julia_arg;
+        jl_array_ptr_set(julia_args, i + 1, cur_julia_arg);
     }
 
     for (int32_t i = 0; i < out_num_args; ++i) {
@@ -355,12 +739,10 @@ call_impl(ImplInfo *impl_info_, const char *method, OIFArgs *in_args, OIFArgs *o
         }
         else if (out_args->arg_types[i] == OIF_ARRAY_F64) {
             OIFArrayF64 *oif_array = *(OIFArrayF64 **)out_args->arg_values[i];
-            jl_value_t *arr_type = jl_apply_array_type((jl_value_t *)jl_float64_type, 1);
-            jl_value_t *dims =
-                build_julia_tuple_from_size_t_array(oif_array->dimensions, oif_array->nd);
-            bool own_buffer = false;
-            cur_julia_arg = (jl_value_t *)jl_ptr_to_array(arr_type, oif_array->data,
-                                                          (jl_value_t *)dims, own_buffer);
+            cur_julia_arg = make_julia_array_from_oif_array_f64_(oif_array);
+            if (cur_julia_arg == NULL) {
+                goto cleanup;
+            }
         }
         else {
             fprintf(stderr,
@@ -370,18 +752,18 @@ call_impl(ImplInfo *impl_info_, const char *method, OIFArgs *in_args, OIFArgs *o
             goto cleanup;
         }
 
-        julia_args[i + 1 + in_num_args] = cur_julia_arg;
+        jl_array_ptr_set(julia_args, i + 1 + in_num_args, cur_julia_arg);
     }
 
     jl_function_t *fn;
-    fn = jl_get_function(impl_info->module, method);
+    fn = get_method_(impl_info, method);
     if (fn == NULL) {
         fprintf(stderr, "[%s] Could not find method '%s' in implementation with id %d\n",
                 prefix_, method, impl_info->base.implh);
         goto cleanup;
     }
 
-    jl_value_t *retval_ = jl_call(fn, julia_args, num_args);
+    jl_value_t *retval_ = jl_call(fn, jl_array_ptr_data(julia_args), num_args);
     if (jl_exception_occurred()) {
         handle_exception_();
         goto cleanup;
@@ -410,7 +792,51 @@ call_impl(ImplInfo *impl_info_, const char *method, OIFArgs *in_args, OIFArgs *o
     assert(result == 0);
 
 cleanup:
-    JL_GC_POP();
+    unlock_(&impl_info->lock);
+    return result;
+}
+
+ImplInfo *
+load_impl(const char *impl_details, size_t version_major, size_t version_minor)
+{
+    if (!INITIALIZED_) {
+        lock_(&INIT_LOCK_);
+        if (!INITIALIZED_ && init_module_() == 0) {
+            INITIALIZED_ = true;
+        }
+        unlock_(&INIT_LOCK_);
+        if (!INITIALIZED_) {
+            return NULL;
+        }
+    }
+
+    int8_t gc_state = enter_julia_();
+    lock_(&RUNTIME_LOCK_);
+    ImplInfo *result = load_impl_(impl_details, version_major, version_minor);
+    unlock_(&RUNTIME_LOCK_);
+    leave_julia_(gc_state);
+
+    return result;
+}
+
+int
+unload_impl(ImplInfo *impl_info)
+{
+    int8_t gc_state = enter_julia_();
+    lock_(&RUNTIME_LOCK_);
+    int result = unload_impl_(impl_info);
+    unlock_(&RUNTIME_LOCK_);
+    leave_julia_(gc_state);
+
+    return result;
+}
+
+int
+call_impl(ImplInfo *impl_info, const char *method, OIFArgs *in_args, OIFArgs *out_args)
+{
+    int8_t gc_state = enter_julia_();
+    int result = call_impl_(impl_info, method, in_args, out_args);
+    leave_julia_(gc_state);
 
     return result;
 }
@@ -0,0 +1,44 @@
+# Script executed while building the system image in `create_sysimage.jl`.
+# Modules defined here end up in `Main` of the system image,
+# and the dispatcher uses them instead of including the files again.
+# The code below exercises them, so that their methods are compiled.
+const OIF_ROOT = joinpath(@__DIR__, "..", "..")
+
+include(joinpath(OIF_ROOT, "oif_impl", "lang_julia", "dispatch_helpers.jl"))
+include(joinpath(OIF_ROOT, "oif_impl", "lang_julia", "callback.jl"))
+include(joinpath(OIF_ROOT, "oif_impl", "impl", "ivp", "jl_diffeq", "jl_diffeq.jl"))
+
+import .DispatchHelpers
+import .CallbackWrapper
+import .JlDiffEq
+
+using OpenInterfaces: OIFArrayF64, OIF_FLOAT64, OIF_ARRAY_F64, OIF_USER_DATA
+
+function _rhs_c(t::Float64, y::Ptr{OIFArrayF64}, ydot::Ptr{OIFArrayF64}, user_data::Ptr{Cvoid})::Cint
+    oif_y = unsafe_load(y)
+    oif_ydot = unsafe_load(ydot)
+    n = unsafe_load(oif_y.dimensions)
+    for i in 1:n
+        unsafe_store!(oif_ydot.data, -unsafe_load(oif_y.data, i), i)
+    end
+    return 0
+end
+
+let
+    DispatchHelpers.precompile_methods(
+        JlDiffEq, joinpath(OIF_ROOT, "oif_impl", "lang_julia", "callback.jl")
+    )
+    fn_c = @cfunction(_rhs_c, Cint, (Float64, Ptr{OIFArrayF64}, Ptr{OIFArrayF64}, Ptr{Cvoid}))
+    rhs = CallbackWrapper.make_wrapper_over_c_callback(
+        fn_c, Int32[OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA]
+    )
+    y = zeros(2)
+    for integrator_name in keys(JlDiffEq.INTEGRATORS)
+        self = JlDiffEq.Self()
+        JlDiffEq.set_initial_value(self, [1.0, 2.0], 0.0)
+        JlDiffEq.set_rhs_fn(self, rhs)
+        JlDiffEq.set_integrator(self, integrator_name)
+        JlDiffEq.set_tolerances(self, 1e-8, 1e-10)
+        JlDiffEq.integrate(self, 0.1, y)
+    end
+end
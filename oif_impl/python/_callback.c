@@ -4,6 +4,7 @@
 
 #include <ffi.h>
 #include <limits.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -12,261 +13,242 @@
 
 #include "oif/api.h"
 
+// Storage for the value of one argument converted to C.
+typedef union {
+    int i;
+    double f64;
+    void *p;
+} CArgValue;
+
 typedef struct {
-    PyObject_HEAD void *fn_p;   // raw C function pointer retrieved from PyCapsule
+    PyObject_HEAD void *fn_p;    // raw C function pointer retrieved from PyCapsule
+    vectorcallfunc vectorcall;  // Implementation of the vectorcall protocol
     unsigned int nargs;         // Number of function arguments
     OIFArgType *oif_arg_types;  // Arg types used in OpenInterFaces
+    OIFArgType oif_restype;     // Return type used in OpenInterFaces
     ffi_cif *cif_p;             // Pointer to libffi context object
     ffi_type **arg_types;       // Arg types in terms of libffi
-    void **arg_values;          // Memory for the data converted to C
-    unsigned int narray_args;   // Number of arrays among argument types
-    OIFArrayF64 **oif_arrays;
+    void **arg_values;          // Pointers to the data converted to C
+    CArgValue *values;          // Memory for the data converted to C
+    OIFArrayF64 *oif_arrays;    // Memory for the array arguments converted to C
 } PythonWrapperForCCallbackObject;
 
 static void
 PythonWrapperForCCallback_dealloc(PythonWrapperForCCallbackObject *self)
 {
-    unsigned int nargs = self->nargs;
-    unsigned int narray_args = self->narray_args;
-    for (unsigned int i = 0; i < narray_args; ++i) {
-        if (self->oif_arrays[i] != NULL) {
-            free(self->oif_arrays[i]);
-        }
-    }
     free(self->oif_arrays);
-
-    for (unsigned int i = 0; i < nargs; ++i) {
-        if (self->arg_values[i] != NULL) {
-            free(self->arg_values[i]);
-        }
-    }
+    free(self->values);
     free(self->arg_values);
-
     free(self->arg_types);
     free(self->cif_p);
     free(self->oif_arg_types);
     Py_TYPE(self)->tp_free((PyObject *)self);
 }
 
-static int
-PythonWrapperForCCallback_init(PythonWrapperForCCallbackObject *self, PyObject *args,
-                               PyObject *Py_UNUSED(kwds))
+static PyObject *
+PythonWrapperForCCallback_vectorcall(PyObject *myself, PyObject *const *args, size_t nargsf,
+                                     PyObject *kwnames)
 {
-    PyObject *capsule;
-    unsigned int nargs;
-
-    /* These lines must also parse for argument types list */
-    // O = object, I = unsigned int
-    if (!PyArg_ParseTuple(args, "OI", &capsule, &nargs)) {
-        fprintf(stderr, "[_callback] Could not parse arguments\n");
-        return -1;
-    }
-
-    self->fn_p = PyCapsule_GetPointer(capsule, "123");
-
-    assert(nargs == 4);
-    nargs = 4;
-    self->nargs = nargs;
+    PythonWrapperForCCallbackObject *self = (PythonWrapperForCCallbackObject *)myself;
 
-    self->oif_arg_types = malloc(sizeof(OIFArgType) * nargs);
-    if (self->oif_arg_types == NULL) {
-        fprintf(stderr, "[_callback] Could not allocated memory for oif_arg_types\n");
-        goto fail_clean_self;
+    Py_ssize_t nargs = PyVectorcall_NARGS(nargsf);
+    if (kwnames != NULL && PyTuple_GET_SIZE(kwnames) > 0) {
+        PyErr_SetString(PyExc_TypeError, "Callback does not accept keyword arguments");
+        return NULL;
     }
-    self->oif_arg_types[0] = OIF_FLOAT64;
-    self->oif_arg_types[1] = OIF_ARRAY_F64;
-    self->oif_arg_types[2] = OIF_ARRAY_F64;
-    self->oif_arg_types[3] = OIF_USER_DATA;
-
-    self->cif_p = malloc(sizeof(ffi_cif));
-    if (self->cif_p == NULL) {
-        goto fail_clean_oif_arg_types;
+    if (nargs != (Py_ssize_t)self->nargs) {
+        PyErr_Format(PyExc_TypeError, "Callback expects %u arguments, %zd given",
+                     self->nargs, nargs);
+        return NULL;
     }
 
-    self->arg_types = malloc(nargs * sizeof(ffi_type *));
-    if (self->arg_types == NULL) {
-        fprintf(stderr, "[_callback] Could not allocate memory for `arg_types`\n");
-        goto fail_clean_cif_p;
-    }
+    OIFArgType *arg_type_ids = self->oif_arg_types;
+    CArgValue *values = self->values;
 
-    // We need to allocate memory for all values, to make sure
-    // that the lifetime of the arguments ends after `ffi_call` below.
-    self->arg_values = calloc(nargs, sizeof(void *));
-    if (self->arg_values == NULL) {
-        fprintf(stderr, "[_callback] Could not allocate memory for `arg_values`\n");
-        goto fail_clean_arg_types;
-    }
-    unsigned int narray_args = 0;  // Number of arguments of type `OIFArrayF64 *`.
-    for (size_t i = 0; i < nargs; ++i) {
-        if (self->oif_arg_types[i] == OIF_INT) {
-            fprintf(stderr,
-                    "[_callback] WARNING: There must be better support "
-                    "for integer types\n");
-            self->arg_types[i] = &ffi_type_sint64;
-            self->arg_values[i] = malloc(sizeof(int));
-        }
-        else if (self->oif_arg_types[i] == OIF_FLOAT64) {
-            self->arg_types[i] = &ffi_type_double;
-            self->arg_values[i] = malloc(sizeof(double));
-        }
-        else if (self->oif_arg_types[i] == OIF_ARRAY_F64) {
-            self->arg_types[i] = &ffi_type_pointer;
-            self->arg_values[i] = malloc(sizeof(OIFArrayF64 **));
-            narray_args++;
+    // Convert function arguments to C types in the memory allocated
+    // during initialization; `self->arg_values` already points to it.
+    for (Py_ssize_t i = 0; i < nargs; ++i) {
+        PyObject *arg = args[i];
+        if (arg_type_ids[i] == OIF_INT) {
+            long value = PyLong_AsLong(arg);
+            if (value == -1 && PyErr_Occurred()) {
+                return NULL;
+            }
+            if (value < INT_MIN || value > INT_MAX) {
+                PyErr_Format(PyExc_OverflowError, "Argument #%zd does not fit into C int", i);
+                return NULL;
+            }
+            values[i].i = (int)value;
         }
-        else if (self->oif_arg_types[i] == OIF_USER_DATA) {
-            self->arg_types[i] = &ffi_type_pointer;
-            self->arg_values[i] = malloc(sizeof(void *));
+        else if (arg_type_ids[i] == OIF_FLOAT64) {
+            double value = PyFloat_AsDouble(arg);
+            if (value == -1.0 && PyErr_Occurred()) {
+                return NULL;
+            }
+            values[i].f64 = value;
         }
-        else {
-            fprintf(stderr, "[_callback] Unknown input arg type: %d\n",
-                    self->oif_arg_types[i]);
-            goto fail_clean_arg_values;
+        else if (arg_type_ids[i] == OIF_ARRAY_F64) {
+            if (!PyArray_Check(arg)) {
+                PyErr_Format(PyExc_TypeError,
+                             "Argument #%zd must be a NumPy ndarray of float64 type", i);
+                return NULL;
+            }
+            PyArrayObject *py_arr = (PyArrayObject *)arg;
+            if (PyArray_TYPE(py_arr) != NPY_FLOAT64 || !PyArray_IS_C_CONTIGUOUS(py_arr)) {
+                PyErr_Format(PyExc_TypeError,
+                             "Argument #%zd must be a C-contiguous array of float64 type", i);
+                return NULL;
+            }
+            self->oif_arrays[i].nd = PyArray_NDIM(py_arr);
+            self->oif_arrays[i].dimensions = PyArray_DIMS(py_arr);
+            self->oif_arrays[i].data = PyArray_DATA(py_arr);
         }
-        if (self->arg_values[i] == NULL) {
-            fprintf(stderr, "[_callback] Could not allocate memory for element #%zu\n", i);
-            goto fail_clean_arg_values;
+        else if (arg_type_ids[i] == OIF_USER_DATA) {
+            if (arg == Py_None) {
+                // User data were not set, so the C callback receives NULL.
+                values[i].p = NULL;
+            }
+            else if (PyCapsule_CheckExact(arg)) {
+                values[i].p = PyCapsule_GetPointer(arg, PyCapsule_GetName(arg));
+                if (values[i].p == NULL) {
+                    return NULL;
+                }
+            }
+            else {
+                // User data that originate in Python are passed as `PyObject *`.
+                values[i].p = arg;
+            }
         }
     }
 
-    self->narray_args = narray_args;
-
-    self->oif_arrays = calloc(narray_args, sizeof(OIFArrayF64 *));
-    if (self->oif_arrays == NULL) {
-        fprintf(stderr, "[_callback] Could not allocate memory for `oif_arrays`\n");
-        goto fail_clean_arg_values;
+    if (self->oif_restype == OIF_FLOAT64) {
+        double result;
+        ffi_call(self->cif_p, FFI_FN(self->fn_p), &result, self->arg_values);
+        return PyFloat_FromDouble(result);
     }
-    for (Py_ssize_t i = 0; i < narray_args; ++i) {
-        self->oif_arrays[i] = malloc(sizeof(OIFArrayF64));
-        if (self->oif_arrays[i] == NULL) {
-            fprintf(stderr, "[_callback] Could not allocate memory for `oif_arrays[%ld]`\n",
-                    i);
-            goto fail_clean_oif_arrays;
-        }
+    else {
+        // libffi requires return values of integral types to be widened
+        // to the size of `ffi_arg`.
+        ffi_arg result;
+        ffi_call(self->cif_p, FFI_FN(self->fn_p), &result, self->arg_values);
+        return PyLong_FromLong((int)result);
     }
+}
 
-    return 0;
+static int
+PythonWrapperForCCallback_init(PythonWrapperForCCallbackObject *self, PyObject *args,
+                               PyObject *Py_UNUSED(kwds))
+{
+    PyObject *capsule;
+    PyObject *py_arg_types;
+    int restype;
 
-fail_clean_oif_arrays:
-    for (unsigned int i = 0; i < narray_args; ++i) {
-        if (self->oif_arrays[i] != NULL) {
-            free(self->oif_arrays[i]);
-        }
+    // O = object, i = int
+    if (!PyArg_ParseTuple(args, "OOi", &capsule, &py_arg_types, &restype)) {
+        fprintf(stderr, "[_callback] Could not parse arguments\n");
+        return -1;
     }
-    free(self->oif_arrays);
-fail_clean_arg_values:
-    for (Py_ssize_t i = 0; i < nargs; ++i) {
-        if (self->arg_values[i] != NULL) {
-            free(self->arg_values[i]);
-        }
+    if (self->cif_p != NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "Callback wrapper is already initialized");
+        return -1;
     }
-    free(self->arg_values);
-fail_clean_arg_types:
-    free(self->arg_types);
-fail_clean_cif_p:
-    free(self->cif_p);
-fail_clean_oif_arg_types:
-    free(self->oif_arg_types);
-fail_clean_self:
-    Py_DECREF(self);
-
-    return -1;
-}
 
-static PyObject *
-PythonWrapperForCCallback_call(PyObject *myself, PyObject *args, PyObject *Py_UNUSED(kwds))
-{
-    PythonWrapperForCCallbackObject *self = (PythonWrapperForCCallbackObject *)myself;
-    PyObject *retval = NULL;
-
-    /* if (!PyArg_ParseTuple(args, "O!", &PyTuple_Type, &py_args)) { */
-    /*     fprintf(stderr, "[_callback] Could not parse function arguments\n");
-     */
-    /*     return NULL; */
-    /* } */
-    PyObject *py_args = args;
-
-    Py_ssize_t nargs_s = PyTuple_Size(py_args);
-    if (nargs_s < 0) {
-        fprintf(stderr,
-                "[_callback] Unexpected negative value for the size "
-                "of the tuple of args for the callback function\n");
-        return NULL;
+    self->fn_p = PyCapsule_GetPointer(capsule, "123");
+    if (self->fn_p == NULL) {
+        return -1;
     }
-    unsigned int nargs;
-    if (nargs_s <= UINT_MAX) {
-        nargs = (unsigned int)nargs_s;  // Explicit cast to eliminate compiler warning
+
+    PyObject *seq = PySequence_Fast(py_arg_types, "Argument types must be a sequence");
+    if (seq == NULL) {
+        return -1;
     }
-    else {
-        fprintf(stderr,
-                "[_callback] Could not convert size of the tuple of args "
-                "to 'unsigned int' type\n");
-        return NULL;
+    Py_ssize_t nargs_s = PySequence_Fast_GET_SIZE(seq);
+    if (nargs_s > UINT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Too many callback arguments");
+        goto fail;
     }
-    // assert(nargs == self->nargs);
-
-    OIFArgType *arg_type_ids = self->oif_arg_types;
-
-    ffi_cif cif;
-    void **arg_values = self->arg_values;
-    OIFArrayF64 **oif_arrays = self->oif_arrays;
+    unsigned int nargs = (unsigned int)nargs_s;
+    self->nargs = nargs;
 
-    void *fn_p = self->fn_p;
+    // Allocate one more element than needed, so that zero-argument callbacks
+    // do not request zero bytes.
+    self->oif_arg_types = malloc(sizeof(OIFArgType) * (nargs + 1));
+    self->cif_p = malloc(sizeof(ffi_cif));
+    self->arg_types = malloc(sizeof(ffi_type *) * (nargs + 1));
+    self->arg_values = calloc(nargs + 1, sizeof(void *));
+    self->values = calloc(nargs + 1, sizeof(CArgValue));
+    self->oif_arrays = calloc(nargs + 1, sizeof(OIFArrayF64));
+    if (self->oif_arg_types == NULL || self->cif_p == NULL || self->arg_types == NULL ||
+        self->arg_values == NULL || self->values == NULL || self->oif_arrays == NULL) {
+        fprintf(stderr, "[_callback] Could not allocate memory for callback arguments\n");
+        PyErr_NoMemory();
+        goto fail;
+    }
 
-    // Prepare function arguments for FFI expectations (pointers)
-    // and convert NumPy arrays to OIFArrayF64 structs.
-    for (size_t i = 0, j = 0; i < nargs; ++i) {
-        PyObject *arg = PyTuple_GetItem(py_args, i);
-        if (arg_type_ids[i] == OIF_FLOAT64) {
-            if (!PyFloat_Check(arg)) {
-                fprintf(stderr, "[_callback] Expected PyFloat object.\n");
-                return NULL;
-            }
-            double *double_value = arg_values[i];
-            *double_value = PyFloat_AsDouble(arg);
+    for (unsigned int i = 0; i < nargs; ++i) {
+        long t = PyLong_AsLong(PySequence_Fast_GET_ITEM(seq, i));
+        if (t == -1 && PyErr_Occurred()) {
+            goto fail;
         }
-        else if (arg_type_ids[i] == OIF_ARRAY_F64) {
-            PyArrayObject *py_arr = (PyArrayObject *)arg;
-            if (!PyArray_Check(py_arr)) {
-                fprintf(stderr,
-                        "[_callback] Expected PyArrayObject (NumPy ndarray) "
-                        "object\n");
-                return NULL;
-            }
-            oif_arrays[j]->nd = PyArray_NDIM(py_arr);
-            oif_arrays[j]->dimensions = PyArray_DIMS(py_arr);
-            oif_arrays[j]->data = PyArray_DATA(py_arr);
+        self->oif_arg_types[i] = (OIFArgType)t;
+        if (t == OIF_INT) {
+            self->arg_types[i] = &ffi_type_sint;
+            self->arg_values[i] = &self->values[i].i;
+        }
+        else if (t == OIF_FLOAT64) {
+            self->arg_types[i] = &ffi_type_double;
+            self->arg_values[i] = &self->values[i].f64;
+        }
+        else if (t == OIF_ARRAY_F64) {
             // We always pass array data structure as pointer: `OIFArrayF64 *`,
             // and FFI requires pointer to function arguments;
-            // hence, we need to obtain `OIFArrayF64 **`.
-            OIFArrayF64 **pp = arg_values[i];
-            *pp = oif_arrays[j];
-            j++;
+            // hence, we need to store `OIFArrayF64 *` and point to it.
+            self->arg_types[i] = &ffi_type_pointer;
+            self->values[i].p = &self->oif_arrays[i];
+            self->arg_values[i] = &self->values[i].p;
         }
-        else if (arg_type_ids[i] == OIF_USER_DATA) {
-            void **p_user_data = arg_values[i];
-            *p_user_data = PyCapsule_GetPointer(arg, NULL);
+        else if (t == OIF_USER_DATA) {
+            self->arg_types[i] = &ffi_type_pointer;
+            self->arg_values[i] = &self->values[i].p;
         }
         else {
-            fprintf(stderr, "[_callback] Unknown input arg type: %d\n", arg_type_ids[i]);
-            return NULL;
+            PyErr_Format(PyExc_ValueError, "Unknown input arg type: %ld", t);
+            goto fail;
         }
     }
 
+    ffi_type *ffi_restype;
+    if (restype == OIF_INT) {
+        ffi_restype = &ffi_type_sint;
+    }
+    else if (restype == OIF_FLOAT64) {
+        ffi_restype = &ffi_type_double;
+    }
+    else {
+        PyErr_Format(PyExc_ValueError, "Unsupported return type: %d", restype);
+        goto fail;
+    }
+    self->oif_restype = (OIFArgType)restype;
+
+    // The call interface depends only on the types, so it is prepared once
+    // and reused for all invocations of the callback.
     ffi_status status =
-        ffi_prep_cif(&cif, FFI_DEFAULT_ABI, nargs, &ffi_type_sint, self->arg_types);
+        ffi_prep_cif(self->cif_p, FFI_DEFAULT_ABI, nargs, ffi_restype, self->arg_types);
     if (status != FFI_OK) {
-        fflush(stdout);
-        fprintf(stderr, "[_callback] ffi_prep_cif was not OK");
-        return NULL;
+        PyErr_SetString(PyExc_RuntimeError, "ffi_prep_cif was not OK");
+        goto fail;
     }
 
-    int result;
-    ffi_call(&cif, FFI_FN(fn_p), &result, arg_values);
+    self->vectorcall = PythonWrapperForCCallback_vectorcall;
 
-    retval = PyLong_FromLong(result);
+    Py_DECREF(seq);
+    return 0;
 
-    return retval;
+fail:
+    Py_DECREF(seq);
+    free(self->cif_p);
+    self->cif_p = NULL;
+    return -1;
 }
 
 static PyMemberDef PythonWrapperForCCallback_members[] = {
@@ -278,11 +260,12 @@ static PyTypeObject PythonWrapperForCCallbackType = {
     .tp_doc = PyDoc_STR("Python wrapper for a C callback function"),
     .tp_basicsize = sizeof(PythonWrapperForCCallbackObject),
     .tp_itemsize = 0,
-    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_VECTORCALL,
     .tp_new = PyType_GenericNew,
     .tp_init = (initproc)PythonWrapperForCCallback_init,
     .tp_dealloc = (destructor)PythonWrapperForCCallback_dealloc,
-    .tp_call = (ternaryfunc)PythonWrapperForCCallback_call,
+    .tp_vectorcall_offset = offsetof(PythonWrapperForCCallbackObject, vectorcall),
+    .tp_call = PyVectorcall_Call,
     .tp_members = PythonWrapperForCCallback_members,
     // .tp_methods = PythonWrapperForCCallback_methods,
 };
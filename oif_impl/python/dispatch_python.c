@@ -23,14 +23,30 @@ static int IMPL_COUNTER = 0;
 
 static bool is_python_initialized_by_us = false;
 
+// Whether the Python runtime and NumPy C API are initialized by this module.
+static bool RUNTIME_INITIALIZED_ = false;
+
+// Whether to print diagnostic information, see `init_python_runtime_`.
+static bool VERBOSE_ = false;
+
+// Cache of imported implementation modules: module name -> module object.
+static PyObject *IMPL_MODULES_ = NULL;
+
 static char prefix[] = "dispatch_python";
 
 PyObject *
 instantiate_callback_class(void)
 {
+    // The callback class is resolved once and shared by all implementations.
+    static PyObject *CALLBACK_CLASS_P = NULL;
     char *moduleName = "_callback";
     char class_name[] = "PythonWrapperForCCallback";
 
+    if (CALLBACK_CLASS_P != NULL) {
+        Py_INCREF(CALLBACK_CLASS_P);
+        return CALLBACK_CLASS_P;
+    }
+
     PyObject *pFileName = PyUnicode_FromString(moduleName);
     PyObject *pModule = PyImport_Import(pFileName);
     Py_DECREF(pFileName);
@@ -41,17 +57,18 @@ instantiate_callback_class(void)
         exit(1);
     }
 
-    PyObject *CALLBACK_CLASS_P = PyObject_GetAttrString(pModule, class_name);
+    CALLBACK_CLASS_P = PyObject_GetAttrString(pModule, class_name);
+    Py_DECREF(pModule);
     if (CALLBACK_CLASS_P == NULL) {
         PyErr_Print();
         fprintf(stderr,
                 "[%s] Cannot proceed as callback class %s could "
                 "not be instantiated\n",
                 prefix, class_name);
+        return NULL;
     }
-    Py_INCREF(CALLBACK_CLASS_P);
-    Py_DECREF(pModule);
 
+    Py_INCREF(CALLBACK_CLASS_P);
     return CALLBACK_CLASS_P;
 }
 
@@ -62,37 +79,62 @@ convert_oif_callback(OIFCallback *p)
     PyObject *fn_p = PyCapsule_New(p->fn_p_c, id, NULL);
     if (fn_p == NULL) {
         fprintf(stderr, "[%s] Could not create PyCapsule\n", prefix);
+        return NULL;
+    }
+    PyObject *arg_types = PyTuple_New(p->nargs);
+    if (arg_types == NULL) {
+        fprintf(stderr, "[%s] Could not create tuple of callback argument types\n", prefix);
+        Py_DECREF(fn_p);
+        return NULL;
     }
-    fprintf(stderr, "[%s] HARDCODE!!!!!!\n", prefix);
-    unsigned int nargs = 4;
-    PyObject *obj = Py_BuildValue("(N, I)", fn_p, nargs);
+    for (unsigned int i = 0; i < p->nargs; ++i) {
+        PyObject *arg_type = PyLong_FromLong(p->arg_types[i]);
+        if (arg_type == NULL) {
+            Py_DECREF(fn_p);
+            Py_DECREF(arg_types);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(arg_types, i, arg_type);
+    }
+    PyObject *obj = Py_BuildValue("(N, N, i)", fn_p, arg_types, p->restype);
     if (obj == NULL) {
         fprintf(stderr, "[%s] Could not build arguments\n", prefix);
     }
     return obj;
 }
 
-ImplInfo *
-load_impl(const char *impl_details, size_t version_major, size_t version_minor)
+/**
+ * Bring up the Python runtime and NumPy C API once per process.
+ *
+ * Diagnostic output about the interpreter is printed only
+ * when the environment variable `OIF_DISPATCH_PYTHON_VERBOSE` is set.
+ *
+ * All implementations live in the main interpreter and share its GIL.
+ * Sub-interpreters with their own GIL (PEP 684) are not usable here yet:
+ * NumPy and the `_callback` module do not support multiple interpreters,
+ * objects cannot be passed between interpreters with separate allocators,
+ * and callbacks from C acquire the GIL via `PyGILState_Ensure`,
+ * which knows only the main interpreter.
+ *
+ * @return 0 on success, non-zero otherwise
+ */
+static int
+init_python_runtime_(void)
 {
-    PyObject *pFileName, *pModule;
-    PyObject *pClass, *pInstance;
-    PyObject *pFunc;
-    PyObject *pInitArgs;
-    PyObject *pArgs;
-    PyObject *pValue;
-    int status;
+    if (RUNTIME_INITIALIZED_) {
+        return 0;
+    }
+
+    VERBOSE_ = getenv("OIF_DISPATCH_PYTHON_VERBOSE") != NULL;
 
-    (void)version_major;
-    (void)version_minor;
     if (Py_IsInitialized()) {
-        fprintf(stderr, "[%s] Backend is already initialized\n", prefix);
+        if (VERBOSE_) {
+            fprintf(stderr, "[%s] Backend is already initialized\n", prefix);
+        }
     }
     else {
         Py_Initialize();
-        if (IMPL_COUNTER == 0) {
-            is_python_initialized_by_us = true;
-        }
+        is_python_initialized_by_us = true;
     }
 
     // We need to `dlopen` the Python library, otherwise,
@@ -100,70 +142,89 @@ load_impl(const char *impl_details, size_t version_major, size_t version_minor)
     // Details:
     // https://stackoverflow.com/questions/49784583/numpy-import-fails-on-multiarray-extension-library-when-called-from-embedded-pyt
     char libpython_name[1024];
-    pFileName = PyUnicode_DecodeFSDefault("sysconfig");
-    if (pFileName == NULL) {
-        fprintf(stderr, "[%s] Could not find `sysconfig` module file\n", prefix);
-        return NULL;
+    sprintf(libpython_name, "libpython%d.%d.so", PY_MAJOR_VERSION, PY_MINOR_VERSION);
+    if (VERBOSE_) {
+        fprintf(stderr, "[%s] Loading %s\n", prefix, libpython_name);
+    }
+    void *libpython = dlopen(libpython_name, RTLD_LAZY | RTLD_GLOBAL);
+    if (libpython == NULL) {
+        fprintf(stderr, "[%s] Cannot open python library\n", prefix);
+        exit(EXIT_FAILURE);
     }
-    pModule = PyImport_Import(pFileName);
-    Py_DECREF(pFileName);
 
-    if (pModule == NULL) {
-        fprintf(stderr, "[%s] Could not import `sysconfig` module\n", prefix);
-        return NULL;
+    import_array1(1);
+
+    if (VERBOSE_) {
+        int status = PyRun_SimpleString(
+            "import sys, sysconfig, numpy; "
+            "print('[dispatch_python]', sys.executable); "
+            "print('[dispatch_python]', sys.version); "
+            "print('[dispatch_python] libpython path:', sysconfig.get_config_var('LIBDIR')); "
+            "print('[dispatch_python] NumPy version: ', numpy.__version__)");
+        if (status < 0) {
+            fprintf(stderr, "[%s] An error occurred when initializating Python\n", prefix);
+            return 1;
+        }
     }
-    pFunc = PyObject_GetAttrString(pModule, "get_config_var");
-    if (pFunc == NULL || !PyCallable_Check(pFunc)) {
-        fprintf(stderr, "[%s] Could not find function `sysconfig.get_config_var`\n", prefix);
-        return NULL;
+
+    IMPL_MODULES_ = PyDict_New();
+    if (IMPL_MODULES_ == NULL) {
+        fprintf(stderr, "[%s] Could not create cache for implementation modules\n", prefix);
+        return 1;
     }
-    pArgs = PyTuple_New(1);
-    pValue = Py_BuildValue("s", "LIBDIR");
-    status = PyTuple_SetItem(pArgs, 0, pValue);
-    if (status != 0) {
-        fprintf(stderr,
-                "[%s] Could not build arguments for executing `sysconfig.get_config_var`\n",
-                prefix);
-        return NULL;
+
+    RUNTIME_INITIALIZED_ = true;
+    return 0;
+}
+
+/**
+ * Import the module with the given name or return it from the cache.
+ *
+ * Modules are cached so that all instances of an implementation
+ * share the same module object without going through the import machinery.
+ *
+ * @return New reference to the module or NULL in case of an error
+ */
+static PyObject *
+import_impl_module_(const char *moduleName)
+{
+    PyObject *pModule = PyDict_GetItemString(IMPL_MODULES_, moduleName);
+    if (pModule != NULL) {
+        Py_INCREF(pModule);
+        return pModule;
     }
-    pValue = PyObject_CallObject(pFunc, pArgs);
-    Py_DECREF(pArgs);
-    if (pValue == NULL) {
-        fprintf(stderr, "[%s] Could not execute `sysconfig.get_config_var`\n", prefix);
+
+    PyObject *pFileName = PyUnicode_FromString(moduleName);
+    if (pFileName == NULL) {
+        fprintf(stderr,
+                "[%s::load_impl] Provided moduleName '%s' "
+                "could not be resolved to file name\n",
+                prefix, moduleName);
         return NULL;
     }
-    const char *libpython_path = PyUnicode_AsUTF8(pValue);
-    Py_DECREF(pValue);
-    if (libpython_path == NULL) {
-        fprintf(stderr, "[%s] Could not convert path to `libpython`\n", prefix);
+    pModule = PyImport_Import(pFileName);
+    Py_DECREF(pFileName);
+    if (pModule == NULL) {
         return NULL;
     }
 
-    fprintf(stderr, "[%s] libpython path: %s\n", prefix, libpython_path);
-    sprintf(libpython_name, "libpython%d.%d.so", PY_MAJOR_VERSION, PY_MINOR_VERSION);
-    fprintf(stderr, "[%s] Loading %s\n", prefix, libpython_name);
-    void *libpython = dlopen(libpython_name, RTLD_LAZY | RTLD_GLOBAL);
-    if (libpython == NULL) {
-        fprintf(stderr, "[%s] Cannot open python library\n", prefix);
-        exit(EXIT_FAILURE);
-    }
-
-    status = PyRun_SimpleString(
-        "import sys; "
-        "print('[dispatch_python]', sys.executable); "
-        "print('[dispatch_python]', sys.version)");
-    if (status < 0) {
-        fprintf(stderr, "[%s] An error occurred when initializating Python\n", prefix);
+    if (PyDict_SetItemString(IMPL_MODULES_, moduleName, pModule) < 0) {
+        Py_DECREF(pModule);
         return NULL;
     }
+    return pModule;
+}
 
-    import_array2("Failed to initialize NumPy C API", NULL);
+ImplInfo *
+load_impl(const char *impl_details, size_t version_major, size_t version_minor)
+{
+    PyObject *pModule;
+    PyObject *pClass, *pInstance;
+    PyObject *pInitArgs;
 
-    status = PyRun_SimpleString(
-        "import numpy; "
-        "print('[dispatch_python] NumPy version: ', numpy.__version__)");
-    if (status < 0) {
-        fprintf(stderr, "[%s] An error occurred when initializating Python\n", prefix);
+    (void)version_major;
+    (void)version_minor;
+    if (init_python_runtime_() != 0) {
         return NULL;
     }
 
@@ -189,19 +250,11 @@ load_impl(const char *impl_details, size_t version_major, size_t version_minor)
         }
     }
 
-    fprintf(stderr, "[%s] Provided module name: '%s'\n", prefix, moduleName);
-    fprintf(stderr, "[%s] Provided class name: '%s'\n", prefix, className);
-    pFileName = PyUnicode_FromString(moduleName);
-    if (pFileName == NULL) {
-        fprintf(stderr,
-                "[%s::load_impl] Provided moduleName '%s' "
-                "could not be resolved to file name\n",
-                prefix, moduleName);
-        return NULL;
+    if (VERBOSE_) {
+        fprintf(stderr, "[%s] Provided module name: '%s'\n", prefix, moduleName);
+        fprintf(stderr, "[%s] Provided class name: '%s'\n", prefix, className);
     }
-    pModule = PyImport_Import(pFileName);
-    Py_DECREF(pFileName);
-
+    pModule = import_impl_module_(moduleName);
     if (pModule == NULL) {
         PyErr_Print();
         fprintf(stderr, "[%s] Failed to load module \"%s\"\n", prefix, moduleName);
@@ -209,17 +262,21 @@ load_impl(const char *impl_details, size_t version_major, size_t version_minor)
     }
 
     pClass = PyObject_GetAttrString(pModule, className);
+    Py_DECREF(pModule);
+    if (pClass == NULL) {
+        PyErr_Print();
+        fprintf(stderr, "[%s] Cannot find class %s\n", prefix, className);
+        return NULL;
+    }
     pInitArgs = Py_BuildValue("()");
     pInstance = PyObject_CallObject(pClass, pInitArgs);
+    Py_DECREF(pInitArgs);
+    Py_DECREF(pClass);
     if (pInstance == NULL) {
         PyErr_Print();
         fprintf(stderr, "[%s] Failed to instantiate class %s\n", prefix, className);
-        Py_DECREF(pClass);
         return NULL;
     }
-    Py_INCREF(pInstance);
-    Py_DECREF(pInitArgs);
-    Py_DECREF(pClass);
 
     PythonImplInfo *impl_info = malloc(sizeof(*impl_info));
     if (impl_info == NULL) {
@@ -227,6 +284,7 @@ load_impl(const char *impl_details, size_t version_major, size_t version_minor)
                 "[%s] Could not allocate memory for Python "
                 "implementation information\n",
                 prefix);
+        Py_DECREF(pInstance);
         return NULL;
     }
     impl_info->pInstance = pInstance;
@@ -257,9 +315,15 @@ call_impl(ImplInfo *impl_info, const char *method, OIFArgs *in_args, OIFArgs *ou
 
         // Convert input arguments.
         for (size_t i = 0; i < in_args->num_args; ++i) {
-            if (in_args->arg_types[i] == OIF_FLOAT64) {
+            if (in_args->arg_types[i] == OIF_INT) {
+                pValue = PyLong_FromLong(*(int *)in_args->arg_values[i]);
+            }
+            else if (in_args->arg_types[i] == OIF_FLOAT64) {
                 pValue = PyFloat_FromDouble(*(double *)in_args->arg_values[i]);
             }
+            else if (in_args->arg_types[i] == OIF_STR) {
+                pValue = PyUnicode_FromString(*(char **)in_args->arg_values[i]);
+            }
             else if (in_args->arg_types[i] == OIF_ARRAY_F64) {
                 OIFArrayF64 *arr = *(OIFArrayF64 **)in_args->arg_values[i];
                 pValue = PyArray_SimpleNewFromData(arr->nd, arr->dimensions, NPY_FLOAT64,
@@ -279,17 +343,19 @@ call_impl(ImplInfo *impl_info, const char *method, OIFArgs *in_args, OIFArgs *ou
                      */
                     Py_INCREF(pValue);
                 }
-                else if (p->src == OIF_LANG_C) {
-                    fprintf(stderr,
-                            "[%s] Check what callback to "
-                            "wrap via src field\n",
-                            prefix);
+                else if (p->src == OIF_LANG_C || p->src == OIF_LANG_JULIA) {
+                    // Julia callbacks are compiled to C functions as well.
                     if (impl->pCallbackClass == NULL) {
                         impl->pCallbackClass = instantiate_callback_class();
                     }
                     PyObject *callback_args = convert_oif_callback(p);
-                    pValue = PyObject_CallObject(impl->pCallbackClass, callback_args);
+                    pValue = NULL;
+                    if (callback_args != NULL) {
+                        pValue = PyObject_CallObject(impl->pCallbackClass, callback_args);
+                        Py_DECREF(callback_args);
+                    }
                     if (pValue == NULL) {
+                        PyErr_Print();
                         fprintf(stderr,
                                 "[%s] Could not instantiate "
                                 "Callback class for wrapping C functions\n",
@@ -300,7 +366,7 @@ call_impl(ImplInfo *impl_info, const char *method, OIFArgs *in_args, OIFArgs *ou
                     fprintf(stderr, "[%s] Cannot determine callback source\n", prefix);
                     pValue = NULL;
                 }
-                if (!PyCallable_Check(pValue)) {
+                if (pValue != NULL && !PyCallable_Check(pValue)) {
                     fprintf(stderr,
                             "[%s] Input argument #%zu "
                             "has type OIF_CALLBACK "
@@ -317,6 +383,10 @@ call_impl(ImplInfo *impl_info, const char *method, OIFArgs *in_args, OIFArgs *ou
                 else if (user_data->src == OIF_LANG_PYTHON) {
                     pValue = user_data->py;
                 }
+                else if (user_data->src == OIF_LANG_JULIA) {
+                    /* Julia objects are opaque for Python. */
+                    pValue = PyCapsule_New(user_data->jl, NULL, NULL);
+                }
                 else {
                     fprintf(stderr, "[%s] Cannot handle user data with src %d\n", prefix,
                             user_data->src);
@@ -3,6 +3,20 @@ from typing import Callable, Union
 
 import numpy as np
 
+# Names of the statistics of the integrator in the order of their indices
+# `OIF_IVP_STAT_*` in the C interface.
+STATS = (
+    "num_steps",
+    "num_rhs_evals",
+    "num_nonlinear_iters",
+    "num_nonlinear_conv_fails",
+    "num_error_test_fails",
+    "num_jac_evals",
+    "last_step",
+    "workspace_bytes",
+    "rhs_time",
+)
+
 
 class IVPInterface(abc.ABC):
     @abc.abstractmethod
@@ -13,14 +27,108 @@ class IVPInterface(abc.ABC):
     def set_rhs_fn(self, rhs: Callable) -> Union[int, None]:
         """Specify right-hand side function f."""
 
+    def set_jac_fn(self, jac: Callable) -> Union[int, None]:
+        """Specify function `jac(t, y, J, user_data)` that writes df/dy to `J`."""
+        raise NotImplementedError("Method `set_jac_fn` is not supported")
+
+    def set_jac_csr_fn(
+        self, jac: Callable, indptr: np.ndarray, indices: np.ndarray
+    ) -> Union[int, None]:
+        """Specify function `jac(t, y, data, user_data)` for the sparse Jacobian.
+
+        The function writes the nonzero values of df/dy to `data`
+        in the order of the CSR pattern given by `indptr` and `indices`.
+        """
+        raise NotImplementedError("Method `set_jac_csr_fn` is not supported")
+
+    def set_jac_times_fn(self, jac_times: Callable) -> Union[int, None]:
+        """Specify function `jac_times(t, y, v, Jv, user_data)` that writes df/dy v."""
+        raise NotImplementedError("Method `set_jac_times_fn` is not supported")
+
+    def set_preconditioner(self, setup: Callable, solve: Callable) -> Union[int, None]:
+        """Specify the preconditioner P ~ I - gamma df/dy for iterative solvers.
+
+        Function `setup(t, y, jok, gamma, user_data)` prepares the preconditioner,
+        and function `solve(t, y, r, z, gamma, delta, user_data)` writes
+        the approximate solution of P z = r to `z`.
+        """
+        raise NotImplementedError("Method `set_preconditioner` is not supported")
+
+    def set_events(
+        self,
+        n_events: int,
+        event_fn: Callable,
+        directions: np.ndarray,
+        terminal: np.ndarray,
+    ) -> Union[int, None]:
+        """Specify function `event_fn(t, y, g, user_data)` of `n_events` events.
+
+        The integration stops at the events `i` with nonzero `terminal[i]`;
+        `directions[i]` restricts the direction of the zero crossing.
+        """
+        raise NotImplementedError("Method `set_events` is not supported")
+
+    def get_last_event(self, event: np.ndarray) -> Union[int, None]:
+        """Write the index (-1 if none) and time (NaN if none) of the last event."""
+        raise NotImplementedError("Method `get_last_event` is not supported")
+
     @abc.abstractmethod
     def set_tolerances(self, rtol: float, atol: float) -> Union[int, None]:
         """Specify relative and absolute tolerances, respectively."""
 
+    @abc.abstractmethod
+    def set_integrator(self, integrator_name: str) -> Union[int, None]:
+        """Select the integrator (time-stepping method) by its name."""
+
+    def set_option(self, name: str, value: str) -> Union[int, None]:
+        """Set the implementation-specific option `name` to `value`."""
+        raise ValueError(f"Unknown option '{name}', the implementation has no options")
+
+    def print_options(self) -> Union[int, None]:
+        """Print the supported options with their current and supported values."""
+        print("The implementation has no options")
+
     @abc.abstractmethod
     def integrate(self, t: float, y: np.ndarray) -> Union[int, None]:
         """Integrate to time `t` and write solution to `y`."""
 
+    def integrate_many(self, times: np.ndarray, Y: np.ndarray) -> Union[int, None]:
+        """Integrate successively to each of `times` and write solutions to rows of `Y`.
+
+        Implementations override it when they can avoid repeated calls
+        to `integrate`.
+        """
+        for i, t in enumerate(times):
+            self.integrate(t, Y[i])
+
+    def integrate_one_step(
+        self, t_end: float, t: np.ndarray, y: np.ndarray
+    ) -> Union[int, None]:
+        """Take one internal step towards `t_end`, but not beyond it.
+
+        The reached time is written to `t[0]` and the solution to `y`.
+        """
+        raise NotImplementedError("Method `integrate_one_step` is not supported")
+
+    def interpolate(self, t: float, y: np.ndarray) -> Union[int, None]:
+        """Write the solution at time `t` within the last step to `y`."""
+        raise NotImplementedError("Method `interpolate` is not supported")
+
+    def get_stats(self, stats: np.ndarray) -> Union[int, None]:
+        """Write the statistics of the integrator to `stats` in the order of `STATS`.
+
+        Statistics that the implementation does not provide are NaN.
+        """
+        stats[:] = np.nan
+
+    def save_state(self, filename: str) -> Union[int, None]:
+        """Save the state of the integrator to the file `filename`."""
+        raise NotImplementedError("Method `save_state` is not supported")
+
+    def load_state(self, filename: str) -> Union[int, None]:
+        """Restore the state of the integrator from the file `filename`."""
+        raise NotImplementedError("Method `load_state` is not supported")
+
     @abc.abstractmethod
     def set_user_data(self, user_data: object) -> Union[int, None]:
         """Specify additional data that will be used for right-hand side function."""
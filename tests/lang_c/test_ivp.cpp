@@ -1,6 +1,7 @@
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <vector>
 
 #include "testutils.h"
 #include <gtest/gtest.h>
@@ -183,9 +184,707 @@ TEST_P(IvpImplementationsFixture, ScalarExpDecayTestCase)
     oif_unload_impl(implh);
 }
 
+TEST_P(IvpImplementationsFixture, IntegrateManyTestCase)
+{
+    const char *impl = std::get<0>(GetParam());
+    ODEProblem *problem = std::get<1>(GetParam());
+    double t0 = 0.0;
+    intptr_t dims[] = {
+        problem->N,
+    };
+    double t_span[] = {0.1, 0.2, 0.3, 0.4, 0.5, 1.0, 2.0};
+    intptr_t times_dims[] = {sizeof(t_span) / sizeof(t_span[0])};
+    intptr_t Y_dims[] = {times_dims[0], problem->N};
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem->y0);
+    OIFArrayF64 *times = oif_init_array_f64_from_data(1, times_dims, t_span);
+    OIFArrayF64 *Y = oif_create_array_f64(2, Y_dims);
+    ImplHandle implh = oif_init_impl("ivp", impl, 1, 0);
+    ASSERT_GT(implh, 0);
+
+    int status;
+    status = oif_ivp_set_initial_value(implh, y0, t0);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_user_data(implh, problem);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+    ASSERT_EQ(status, 0);
+
+    status = oif_ivp_integrate_many(implh, times, Y);
+    ASSERT_EQ(status, 0);
+    for (intptr_t i = 0; i < times_dims[0]; ++i) {
+        OIFArrayF64 y = {1, dims, Y->data + i * problem->N};
+        problem->verify(t_span[i], &y);
+    }
+
+    oif_free_array_f64(y0);
+    oif_free_array_f64(times);
+    oif_free_array_f64(Y);
+    oif_unload_impl(implh);
+}
+
+TEST_P(IvpImplementationsFixture, IntegrateOneStepTestCase)
+{
+    const char *impl = std::get<0>(GetParam());
+    ODEProblem *problem = std::get<1>(GetParam());
+    double t0 = 0.0;
+    double t_end = 1.0;
+    intptr_t dims[] = {
+        problem->N,
+    };
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem->y0);
+    OIFArrayF64 *y = oif_create_array_f64(1, dims);
+    ImplHandle implh = oif_init_impl("ivp", impl, 1, 0);
+    ASSERT_GT(implh, 0);
+
+    int status;
+    status = oif_ivp_set_initial_value(implh, y0, t0);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_user_data(implh, problem);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+    ASSERT_EQ(status, 0);
+
+    double t_prev = t0;
+    double t = t0;
+    while (t < t_end) {
+        status = oif_ivp_integrate_one_step(implh, t_end, &t, y);
+        ASSERT_EQ(status, 0);
+        ASSERT_GT(t, t_prev);
+        ASSERT_LE(t, t_end);
+        problem->verify(t, y);
+        t_prev = t;
+    }
+
+    status = oif_ivp_interpolate(implh, t_end, y);
+    ASSERT_EQ(status, 0);
+    problem->verify(t_end, y);
+
+    oif_free_array_f64(y0);
+    oif_free_array_f64(y);
+    oif_unload_impl(implh);
+}
+
 INSTANTIATE_TEST_SUITE_P(IvpImplementationsTests, IvpImplementationsFixture,
                          testing::Combine(testing::Values("sundials_cvode",
                                                           "scipy_ode_dopri5"),
                                           testing::Values(new ScalarExpDecayProblem(),
                                                           new LinearOscillatorProblem(),
                                                           new OrbitEquationsProblem())));
+
+TEST(IvpScipyOdeDopri5Test, SetIntegratorAndTolerances)
+{
+    LinearOscillatorProblem problem;
+    double t0 = 0.0;
+    intptr_t dims[] = {
+        problem.N,
+    };
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem.y0);
+    OIFArrayF64 *y = oif_create_array_f64(1, dims);
+    ImplHandle implh = oif_init_impl("ivp", "scipy_ode_dopri5", 1, 0);
+    ASSERT_GT(implh, 0);
+
+    int status;
+    status = oif_ivp_set_initial_value(implh, y0, t0);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_user_data(implh, &problem);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_integrator(implh, "dop853");
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_tolerances(implh, 1e-14, 1e-14);
+    ASSERT_EQ(status, 0);
+
+    auto t_span = {0.1, 0.5, 1.0};
+    for (auto t : t_span) {
+        status = oif_ivp_integrate(implh, t, y);
+        ASSERT_EQ(status, 0);
+        problem.verify(t, y);
+    }
+
+    status = oif_ivp_set_integrator(implh, "unknown_integrator");
+    EXPECT_NE(status, 0);
+
+    oif_free_array_f64(y0);
+    oif_free_array_f64(y);
+    oif_unload_impl(implh);
+}
+
+class IvpJacobianFixture : public testing::TestWithParam<const char *> {
+   public:
+    static int
+    jac(double /* t */, OIFArrayF64 * /* y */, OIFArrayF64 *J, void * /* user_data */)
+    {
+        // Row-major order.
+        J->data[0] = 0.0;
+        J->data[1] = 1.0;
+        J->data[2] = -M_PI * M_PI;
+        J->data[3] = 0.0;
+        return 0;
+    }
+
+    static int
+    jac_csr(double /* t */, OIFArrayF64 * /* y */, OIFArrayF64 *data, void * /* user_data */)
+    {
+        data->data[0] = 1.0;
+        data->data[1] = -M_PI * M_PI;
+        return 0;
+    }
+
+    static int
+    prec_setup(double /* t */, OIFArrayF64 * /* y */, int /* jok */, double /* gamma */,
+               void * /* user_data */)
+    {
+        return 0;
+    }
+
+    // Solve (I - gamma J) z = r exactly for the Jacobian of the linear oscillator.
+    static int
+    prec_solve(double /* t */, OIFArrayF64 * /* y */, OIFArrayF64 *r, OIFArrayF64 *z,
+               double gamma, double /* delta */, void * /* user_data */)
+    {
+        double w2 = M_PI * M_PI;
+        double det = 1.0 + gamma * gamma * w2;
+        z->data[0] = (r->data[0] + gamma * r->data[1]) / det;
+        z->data[1] = (r->data[1] - gamma * w2 * r->data[0]) / det;
+        return 0;
+    }
+};
+
+TEST_P(IvpJacobianFixture, DenseAndSparseJacobians)
+{
+    const char *impl = GetParam();
+    intptr_t indptr[] = {0, 1, 2};
+    intptr_t indices[] = {1, 0};
+
+    for (int variant = 0; variant < 2; ++variant) {
+        LinearOscillatorProblem problem;
+        intptr_t dims[] = {
+            problem.N,
+        };
+        OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem.y0);
+        OIFArrayF64 *y = oif_create_array_f64(1, dims);
+        ImplHandle implh = oif_init_impl("ivp", impl, 1, 0);
+        ASSERT_GT(implh, 0);
+
+        int status;
+        status = oif_ivp_set_initial_value(implh, y0, 0.0);
+        ASSERT_EQ(status, 0);
+        status = oif_ivp_set_user_data(implh, &problem);
+        ASSERT_EQ(status, 0);
+        status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+        ASSERT_EQ(status, 0);
+        if (variant == 0) {
+            status = oif_ivp_set_jac_fn(implh, IvpJacobianFixture::jac);
+        }
+        else {
+            status = oif_ivp_set_jac_csr_fn(implh, IvpJacobianFixture::jac_csr, problem.N,
+                                            indptr, indices);
+        }
+        ASSERT_EQ(status, 0);
+
+        status = oif_ivp_integrate(implh, 1.0, y);
+        ASSERT_EQ(status, 0);
+        problem.verify(1.0, y);
+
+        oif_free_array_f64(y0);
+        oif_free_array_f64(y);
+        oif_unload_impl(implh);
+    }
+}
+
+TEST_P(IvpJacobianFixture, Preconditioner)
+{
+    const char *impl = GetParam();
+    LinearOscillatorProblem problem;
+    intptr_t dims[] = {
+        problem.N,
+    };
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem.y0);
+    OIFArrayF64 *y = oif_create_array_f64(1, dims);
+    ImplHandle implh = oif_init_impl("ivp", impl, 1, 0);
+    ASSERT_GT(implh, 0);
+
+    int status;
+    status = oif_ivp_set_initial_value(implh, y0, 0.0);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_user_data(implh, &problem);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_preconditioner(implh, IvpJacobianFixture::prec_setup,
+                                        IvpJacobianFixture::prec_solve);
+    ASSERT_EQ(status, 0);
+
+    status = oif_ivp_integrate(implh, 1.0, y);
+    ASSERT_EQ(status, 0);
+    problem.verify(1.0, y);
+
+    oif_free_array_f64(y0);
+    oif_free_array_f64(y);
+    oif_unload_impl(implh);
+}
+
+INSTANTIATE_TEST_SUITE_P(IvpJacobianTests, IvpJacobianFixture,
+                         testing::Values("sundials_cvode", "scipy_ode_dopri5"));
+
+class IvpEventsFixture : public testing::TestWithParam<const char *> {
+   public:
+    // Event y = 0.5, which occurs at t = ln 2 for the exponential decay.
+    static int
+    event_fn(double /* t */, OIFArrayF64 *y, OIFArrayF64 *g, void * /* user_data */)
+    {
+        g->data[0] = y->data[0] - 0.5;
+        return 0;
+    }
+};
+
+TEST_P(IvpEventsFixture, TerminalEventStopsIntegration)
+{
+    const char *impl = GetParam();
+    ScalarExpDecayProblem problem;
+    intptr_t dims[] = {
+        problem.N,
+    };
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem.y0);
+    OIFArrayF64 *y = oif_create_array_f64(1, dims);
+    intptr_t event_dims[] = {1};
+    double direction = -1.0;
+    double terminal = 1.0;
+    OIFArrayF64 *directions = oif_init_array_f64_from_data(1, event_dims, &direction);
+    OIFArrayF64 *terminals = oif_init_array_f64_from_data(1, event_dims, &terminal);
+    ImplHandle implh = oif_init_impl("ivp", impl, 1, 0);
+    ASSERT_GT(implh, 0);
+
+    int status;
+    status = oif_ivp_set_initial_value(implh, y0, 0.0);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_user_data(implh, &problem);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_tolerances(implh, 1e-8, 1e-12);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_events(implh, 1, IvpEventsFixture::event_fn, directions, terminals);
+    ASSERT_EQ(status, 0);
+
+    int event_index;
+    double t_event;
+    status = oif_ivp_integrate(implh, 2.0, y);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_get_last_event(implh, &event_index, &t_event);
+    ASSERT_EQ(status, 0);
+    EXPECT_EQ(event_index, 0);
+    EXPECT_NEAR(t_event, log(2.0), 1e-6);
+    EXPECT_NEAR(y->data[0], 0.5, 1e-6);
+
+    // The integration continues from the event.
+    status = oif_ivp_integrate(implh, 2.0, y);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_get_last_event(implh, &event_index, &t_event);
+    ASSERT_EQ(status, 0);
+    EXPECT_EQ(event_index, -1);
+    EXPECT_NEAR(y->data[0], exp(-2.0), 1e-6);
+
+    // Disabling the events does not need the arrays.
+    status = oif_ivp_set_events(implh, 0, NULL, NULL, NULL);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_initial_value(implh, y0, 0.0);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_integrate(implh, 2.0, y);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_get_last_event(implh, &event_index, &t_event);
+    ASSERT_EQ(status, 0);
+    EXPECT_EQ(event_index, -1);
+    EXPECT_NEAR(y->data[0], exp(-2.0), 1e-6);
+
+    oif_free_array_f64(directions);
+    oif_free_array_f64(terminals);
+    oif_free_array_f64(y0);
+    oif_free_array_f64(y);
+    oif_unload_impl(implh);
+}
+
+INSTANTIATE_TEST_SUITE_P(IvpEventsTests, IvpEventsFixture,
+                         testing::Values("sundials_cvode", "scipy_ode_dopri5"));
+
+class IvpStatsFixture : public testing::TestWithParam<const char *> {};
+
+TEST_P(IvpStatsFixture, CountersAreReportedAndReset)
+{
+    const char *impl = GetParam();
+    ScalarExpDecayProblem problem;
+    intptr_t dims[] = {
+        problem.N,
+    };
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem.y0);
+    OIFArrayF64 *y = oif_create_array_f64(1, dims);
+    intptr_t stats_dims[] = {OIF_IVP_NUM_STATS};
+    OIFArrayF64 *stats = oif_create_array_f64(1, stats_dims);
+    ImplHandle implh = oif_init_impl("ivp", impl, 1, 0);
+    ASSERT_GT(implh, 0);
+
+    ASSERT_EQ(oif_ivp_set_initial_value(implh, y0, 0.0), 0);
+    ASSERT_EQ(oif_ivp_set_user_data(implh, &problem), 0);
+    ASSERT_EQ(oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper), 0);
+    ASSERT_EQ(oif_ivp_set_tolerances(implh, 1e-8, 1e-12), 0);
+    ASSERT_EQ(oif_ivp_integrate(implh, 1.0, y), 0);
+
+    ASSERT_EQ(oif_ivp_get_stats(implh, stats), 0);
+    EXPECT_GT(stats->data[OIF_IVP_STAT_NUM_RHS_EVALS], 0.0);
+    EXPECT_GE(stats->data[OIF_IVP_STAT_RHS_TIME], 0.0);
+
+    // Counters start anew from the initial value.
+    ASSERT_EQ(oif_ivp_set_initial_value(implh, y0, 0.0), 0);
+    ASSERT_EQ(oif_ivp_get_stats(implh, stats), 0);
+    EXPECT_EQ(stats->data[OIF_IVP_STAT_NUM_RHS_EVALS], 0.0);
+
+    oif_free_array_f64(stats);
+    oif_free_array_f64(y0);
+    oif_free_array_f64(y);
+    oif_unload_impl(implh);
+}
+
+INSTANTIATE_TEST_SUITE_P(IvpStatsTests, IvpStatsFixture,
+                         testing::Values("sundials_cvode", "scipy_ode_dopri5"));
+
+TEST(IvpSundialsCvodeTest, SetIntegratorAndOptions)
+{
+    // Each configuration is the integrator followed by option names and values.
+    const vector<vector<const char *>> configs = {
+        {"adams"},
+        {"adams", "anderson_depth", "3"},
+        {"bdf"},
+        {"bdf", "nonlinear_solver", "newton", "linear_solver", "dense"},
+        {"bdf", "linear_solver", "band", "upper_bandwidth", "1", "lower_bandwidth", "1"},
+        {"bdf", "linear_solver", "spgmr", "max_krylov_dim", "2"},
+        {"bdf", "linear_solver", "spbcgs"},
+        {"bdf", "linear_solver", "dense", "num_threads", "1"},
+    };
+
+    for (const auto &config : configs) {
+        LinearOscillatorProblem problem;
+        intptr_t dims[] = {
+            problem.N,
+        };
+        OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem.y0);
+        OIFArrayF64 *y = oif_create_array_f64(1, dims);
+        ImplHandle implh = oif_init_impl("ivp", "sundials_cvode", 1, 0);
+        ASSERT_GT(implh, 0);
+
+        int status;
+        status = oif_ivp_set_initial_value(implh, y0, 0.0);
+        ASSERT_EQ(status, 0);
+        status = oif_ivp_set_user_data(implh, &problem);
+        ASSERT_EQ(status, 0);
+        status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+        ASSERT_EQ(status, 0);
+        status = oif_ivp_set_tolerances(implh, 1e-8, 1e-10);
+        ASSERT_EQ(status, 0);
+        status = oif_ivp_set_integrator(implh, config[0]);
+        ASSERT_EQ(status, 0);
+        for (size_t i = 1; i + 1 < config.size(); i += 2) {
+            status = oif_ivp_set_option(implh, config[i], config[i + 1]);
+            ASSERT_EQ(status, 0) << config[i] << " = " << config[i + 1];
+        }
+
+        status = oif_ivp_integrate(implh, 1.0, y);
+        ASSERT_EQ(status, 0);
+        EXPECT_NEAR(y->data[0], cos(M_PI) + 0.5 * sin(M_PI) / M_PI, 1e-5);
+        EXPECT_NEAR(y->data[1], -M_PI * sin(M_PI) + 0.5 * cos(M_PI), 1e-5);
+
+        EXPECT_NE(oif_ivp_set_integrator(implh, "unknown_integrator"), 0);
+        EXPECT_NE(oif_ivp_set_option(implh, "unknown_option", "1"), 0);
+        EXPECT_NE(oif_ivp_set_option(implh, "linear_solver", "unknown_solver"), 0);
+        EXPECT_NE(oif_ivp_set_option(implh, "anderson_depth", "-1"), 0);
+        EXPECT_NE(oif_ivp_set_option(implh, "num_threads", "0"), 0);
+
+        oif_free_array_f64(y0);
+        oif_free_array_f64(y);
+        oif_unload_impl(implh);
+    }
+}
+
+TEST(IvpSundialsCvodeTest, TwoThreadsGiveSerialSolution)
+{
+    OrbitEquationsProblem problem;
+    intptr_t dims[] = {
+        problem.N,
+    };
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem.y0);
+    OIFArrayF64 *y_serial = oif_create_array_f64(1, dims);
+    OIFArrayF64 *y = oif_create_array_f64(1, dims);
+    ImplHandle implh = oif_init_impl("ivp", "sundials_cvode", 1, 0);
+    ASSERT_GT(implh, 0);
+
+    int status;
+    status = oif_ivp_set_initial_value(implh, y0, 0.0);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_user_data(implh, &problem);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_tolerances(implh, 1e-8, 1e-10);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_option(implh, "num_threads", "1");
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_integrate(implh, 1.0, y_serial);
+    ASSERT_EQ(status, 0);
+
+    // Sundials may be built without threaded vectors.
+    if (oif_ivp_set_option(implh, "num_threads", "2") != 0) {
+        oif_free_array_f64(y0);
+        oif_free_array_f64(y_serial);
+        oif_free_array_f64(y);
+        oif_unload_impl(implh);
+        GTEST_SKIP() << "Sundials is built without threaded vectors";
+    }
+    status = oif_ivp_set_initial_value(implh, y0, 0.0);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_integrate(implh, 1.0, y);
+    ASSERT_EQ(status, 0);
+    for (int i = 0; i < problem.N; ++i) {
+        // Threaded reductions sum in another order, hence not exactly equal.
+        EXPECT_NEAR(y->data[i], y_serial->data[i], 1e-8);
+    }
+
+    // Restore the default, as the implementation keeps its state across handles.
+    status = oif_ivp_set_option(implh, "num_threads", "1");
+    ASSERT_EQ(status, 0);
+
+    oif_free_array_f64(y0);
+    oif_free_array_f64(y_serial);
+    oif_free_array_f64(y);
+    oif_unload_impl(implh);
+}
+
+TEST(IvpSundialsCvodeTest, RestartFromNewInitialValues)
+{
+    ScalarExpDecayProblem problem;
+    ImplHandle implh = oif_init_impl("ivp", "sundials_cvode", 1, 0);
+    ASSERT_GT(implh, 0);
+
+    int status;
+    status = oif_ivp_set_integrator(implh, "bdf");
+    ASSERT_EQ(status, 0);
+    // The number of equations changes in the last restarts.
+    const vector<int> sizes = {1, 1, 1, 3, 3};
+    for (size_t k = 0; k < sizes.size(); ++k) {
+        intptr_t dims[] = {sizes[k]};
+        OIFArrayF64 *y0 = oif_create_array_f64(1, dims);
+        OIFArrayF64 *y = oif_create_array_f64(1, dims);
+        for (int i = 0; i < sizes[k]; ++i) {
+            y0->data[i] = 1.0 + k + i;
+        }
+        const double t0 = 0.25 * k;
+
+        status = oif_ivp_set_initial_value(implh, y0, t0);
+        ASSERT_EQ(status, 0);
+        status = oif_ivp_set_user_data(implh, &problem);
+        ASSERT_EQ(status, 0);
+        status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+        ASSERT_EQ(status, 0);
+        status = oif_ivp_set_tolerances(implh, 1e-8, 1e-12);
+        ASSERT_EQ(status, 0);
+
+        status = oif_ivp_integrate(implh, t0 + 1.0, y);
+        ASSERT_EQ(status, 0);
+        for (int i = 0; i < sizes[k]; ++i) {
+            EXPECT_NEAR(y->data[i], y0->data[i] * exp(-1.0), 1e-6 * y0->data[i]);
+        }
+
+        oif_free_array_f64(y0);
+        oif_free_array_f64(y);
+    }
+
+    oif_unload_impl(implh);
+}
+
+// Jacobian J = -I of the exponential decay that counts its calls.
+static int DECAY_JAC_CALLS = 0;
+
+static int
+decay_jac(double /* t */, OIFArrayF64 *y, OIFArrayF64 *J, void * /* user_data */)
+{
+    intptr_t n = y->dimensions[0];
+    for (intptr_t i = 0; i < n * n; ++i) {
+        J->data[i] = (i % (n + 1) == 0) ? -1.0 : 0.0;
+    }
+    ++DECAY_JAC_CALLS;
+    return 0;
+}
+
+static int
+decay_jac_csr(double /* t */, OIFArrayF64 *y, OIFArrayF64 *data, void * /* user_data */)
+{
+    for (intptr_t i = 0; i < y->dimensions[0]; ++i) {
+        data->data[i] = -1.0;
+    }
+    ++DECAY_JAC_CALLS;
+    return 0;
+}
+
+TEST(IvpSundialsCvodeTest, JacobianIsDiscardedWhenSizeChanges)
+{
+    ScalarExpDecayProblem problem;
+    ImplHandle implh = oif_init_impl("ivp", "sundials_cvode", 1, 0);
+    ASSERT_GT(implh, 0);
+
+    int status;
+    status = oif_ivp_set_integrator(implh, "bdf");
+    ASSERT_EQ(status, 0);
+    // Diagonal sparsity pattern for two equations.
+    intptr_t indptr[] = {0, 1, 2};
+    intptr_t indices[] = {0, 1};
+
+    for (int variant = 0; variant < 2; ++variant) {
+        for (int n : {2, 5}) {
+            intptr_t dims[] = {n};
+            OIFArrayF64 *y0 = oif_create_array_f64(1, dims);
+            OIFArrayF64 *y = oif_create_array_f64(1, dims);
+            for (int i = 0; i < n; ++i) {
+                y0->data[i] = 1.0 + i;
+            }
+
+            status = oif_ivp_set_initial_value(implh, y0, 0.0);
+            ASSERT_EQ(status, 0);
+            status = oif_ivp_set_user_data(implh, &problem);
+            ASSERT_EQ(status, 0);
+            status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+            ASSERT_EQ(status, 0);
+            // The Jacobian is set only for the first size,
+            // and must not be used with the buffers of that size for the second one.
+            if (n == 2 && variant == 0) {
+                status = oif_ivp_set_jac_fn(implh, decay_jac);
+                ASSERT_EQ(status, 0);
+            }
+            else if (n == 2) {
+                status = oif_ivp_set_jac_csr_fn(implh, decay_jac_csr, n, indptr, indices);
+                ASSERT_EQ(status, 0);
+            }
+
+            DECAY_JAC_CALLS = 0;
+            status = oif_ivp_integrate(implh, 1.0, y);
+            ASSERT_EQ(status, 0);
+            for (int i = 0; i < n; ++i) {
+                EXPECT_NEAR(y->data[i], y0->data[i] * exp(-1.0), 1e-4 * y0->data[i]);
+            }
+            if (n == 2) {
+                EXPECT_GT(DECAY_JAC_CALLS, 0);
+            }
+            else {
+                EXPECT_EQ(DECAY_JAC_CALLS, 0);
+            }
+
+            oif_free_array_f64(y0);
+            oif_free_array_f64(y);
+        }
+    }
+
+    oif_unload_impl(implh);
+}
+
+TEST(IvpSundialsCvodeTest, IntegrateBackwardAfterOneStep)
+{
+    ScalarExpDecayProblem problem;
+    intptr_t dims[] = {
+        problem.N,
+    };
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem.y0);
+    OIFArrayF64 *y = oif_create_array_f64(1, dims);
+    ImplHandle implh = oif_init_impl("ivp", "sundials_cvode", 1, 0);
+    ASSERT_GT(implh, 0);
+
+    int status;
+    status = oif_ivp_set_initial_value(implh, y0, 1.0);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_user_data(implh, &problem);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper);
+    ASSERT_EQ(status, 0);
+    status = oif_ivp_set_tolerances(implh, 1e-8, 1e-12);
+    ASSERT_EQ(status, 0);
+
+    double t_step;
+    status = oif_ivp_integrate_one_step(implh, 0.5, &t_step, y);
+    ASSERT_EQ(status, 0);
+    ASSERT_LT(t_step, 1.0);
+    // The stop time of the step must not remain in effect.
+    status = oif_ivp_integrate(implh, 0.0, y);
+    ASSERT_EQ(status, 0);
+    EXPECT_NEAR(y->data[0], exp(1.0), 1e-5);
+
+    oif_free_array_f64(y0);
+    oif_free_array_f64(y);
+    oif_unload_impl(implh);
+}
+
+TEST(IvpSundialsCvodeTest, InvalidSparsityPatternIsRejected)
+{
+    LinearOscillatorProblem problem;
+    intptr_t dims[] = {
+        problem.N,
+    };
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem.y0);
+    ImplHandle implh = oif_init_impl("ivp", "sundials_cvode", 1, 0);
+    ASSERT_GT(implh, 0);
+    ASSERT_EQ(oif_ivp_set_initial_value(implh, y0, 0.0), 0);
+
+    // Each pattern has two nonzeros in two rows.
+    const vector<vector<intptr_t>> patterns = {
+        {1, 1, 2, 0, 1},   // `indptr[0]` is not zero.
+        {0, 2, 1, 0, 1},   // `indptr` decreases.
+        {0, 1, 2, 0, 2},   // Column index is too large.
+        {0, 1, 2, -1, 1},  // Column index is negative.
+    };
+    for (const auto &pattern : patterns) {
+        EXPECT_NE(oif_ivp_set_jac_csr_fn(implh, decay_jac_csr, problem.N, pattern.data(),
+                                         pattern.data() + problem.N + 1),
+                  0);
+    }
+    intptr_t indptr[] = {0, 1, 2};
+    intptr_t indices[] = {0, 1};
+    EXPECT_EQ(oif_ivp_set_jac_csr_fn(implh, decay_jac_csr, problem.N, indptr, indices), 0);
+
+    oif_free_array_f64(y0);
+    oif_unload_impl(implh);
+}
+
+TEST(IvpSundialsCvodeTest, SaveAndLoadState)
+{
+    LinearOscillatorProblem problem;
+    intptr_t dims[] = {
+        problem.N,
+    };
+    OIFArrayF64 *y0 = oif_init_array_f64_from_data(1, dims, problem.y0);
+    OIFArrayF64 *y = oif_create_array_f64(1, dims);
+    OIFArrayF64 *y_resumed = oif_create_array_f64(1, dims);
+    const string filename = testing::TempDir() + "oif_ivp_sundials_cvode_state.bin";
+
+    ImplHandle implh = oif_init_impl("ivp", "sundials_cvode", 1, 0);
+    ASSERT_GT(implh, 0);
+    ASSERT_EQ(oif_ivp_set_initial_value(implh, y0, 0.0), 0);
+    ASSERT_EQ(oif_ivp_set_user_data(implh, &problem), 0);
+    ASSERT_EQ(oif_ivp_set_rhs_fn(implh, ODEProblem::rhs_wrapper), 0);
+    ASSERT_EQ(oif_ivp_set_tolerances(implh, 1e-8, 1e-10), 0);
+
+    ASSERT_EQ(oif_ivp_integrate(implh, 1.0, y), 0);
+    ASSERT_EQ(oif_ivp_save_state(implh, filename.c_str()), 0);
+    ASSERT_EQ(oif_ivp_integrate(implh, 2.0, y), 0);
+
+    // Restart from the initial value and resume from the saved state instead.
+    ASSERT_EQ(oif_ivp_set_initial_value(implh, y0, 0.0), 0);
+    ASSERT_EQ(oif_ivp_load_state(implh, filename.c_str()), 0);
+    ASSERT_EQ(oif_ivp_integrate(implh, 2.0, y_resumed), 0);
+    for (int i = 0; i < problem.N; ++i) {
+        EXPECT_NEAR(y_resumed->data[i], y->data[i], 1e-5);
+    }
+
+    EXPECT_NE(oif_ivp_load_state(implh, "nonexistent_state_file.bin"), 0);
+
+    remove(filename.c_str());
+    oif_free_array_f64(y0);
+    oif_free_array_f64(y);
+    oif_free_array_f64(y_resumed);
+    oif_unload_impl(implh);
+}
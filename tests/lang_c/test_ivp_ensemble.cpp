@@ -0,0 +1,127 @@
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "oif/c_bindings.h"
+#include "oif/interfaces/ivp_ensemble.h"
+
+using namespace std;
+
+// Right-hand side y' = -k y, where the decay rate k is the user data of the member.
+static int
+decay_rhs(double /* t */, OIFArrayF64 *y, OIFArrayF64 *ydot, void *user_data)
+{
+    double k = *reinterpret_cast<double *>(user_data);
+    for (int i = 0; i < y->dimensions[0]; ++i) {
+        ydot->data[i] = -k * y->data[i];
+    }
+    return 0;
+}
+
+// Right-hand side of all members at once; the user data are the decay rates.
+static int
+decay_rhs_batch(OIFArrayF64 * /* t */, OIFArrayF64 *Y, OIFArrayF64 *Ydot, void *user_data)
+{
+    const double *rates = reinterpret_cast<double *>(user_data);
+    intptr_t M = Y->dimensions[0];
+    intptr_t N = Y->dimensions[1];
+    for (intptr_t m = 0; m < M; ++m) {
+        for (intptr_t i = 0; i < N; ++i) {
+            Ydot->data[m * N + i] = -rates[m] * Y->data[m * N + i];
+        }
+    }
+    return 0;
+}
+
+class IvpEnsembleSundialsCvodeFixture : public testing::TestWithParam<int> {};
+
+TEST_P(IvpEnsembleSundialsCvodeFixture, MembersAreIntegratedIndependently)
+{
+    const int M = 37;
+    const int N = 2;
+    const int num_threads = GetParam();
+
+    vector<double> rates(M);
+    vector<void *> user_data(M);
+    intptr_t dims[] = {M, N};
+    OIFArrayF64 *Y0 = oif_create_array_f64(2, dims);
+    OIFArrayF64 *Y = oif_create_array_f64(2, dims);
+    intptr_t status_dims[] = {M};
+    OIFArrayF64 *status = oif_create_array_f64(1, status_dims);
+    for (int m = 0; m < M; ++m) {
+        rates[m] = 0.1 * (m + 1);
+        user_data[m] = &rates[m];
+        Y0->data[m * N] = 1.0;
+        Y0->data[m * N + 1] = -0.5 * m;
+    }
+
+    ImplHandle implh = oif_init_impl("ivp_ensemble", "sundials_cvode", 1, 0);
+    ASSERT_GT(implh, 0);
+    ASSERT_EQ(oif_ivp_ensemble_set_initial_values(implh, Y0, 0.0), 0);
+    ASSERT_EQ(oif_ivp_ensemble_set_rhs_fn(implh, decay_rhs), 0);
+    ASSERT_EQ(oif_ivp_ensemble_set_user_data(implh, user_data.data()), 0);
+    ASSERT_EQ(oif_ivp_ensemble_set_tolerances(implh, 1e-8, 1e-12), 0);
+    ASSERT_EQ(oif_ivp_ensemble_set_num_threads(implh, num_threads), 0);
+
+    const double times[] = {0.5, 1.0, 2.0};
+    for (double t : times) {
+        ASSERT_EQ(oif_ivp_ensemble_integrate(implh, t, Y, status), 0);
+        for (int m = 0; m < M; ++m) {
+            EXPECT_EQ(status->data[m], 0.0);
+            for (int i = 0; i < N; ++i) {
+                double exact = Y0->data[m * N + i] * exp(-rates[m] * t);
+                EXPECT_NEAR(Y->data[m * N + i], exact, 1e-5 * fabs(exact) + 1e-10);
+            }
+        }
+    }
+
+    oif_free_array_f64(status);
+    oif_free_array_f64(Y);
+    oif_free_array_f64(Y0);
+    oif_unload_impl(implh);
+}
+
+// Zero threads select the number of available processors.
+INSTANTIATE_TEST_SUITE_P(IvpEnsembleSundialsCvodeTests, IvpEnsembleSundialsCvodeFixture,
+                         testing::Values(1, 4, 0));
+
+TEST(IvpEnsembleSundialsCvodeTest, BatchRhs)
+{
+    const int M = 16;
+    const int N = 3;
+    vector<double> rates(M);
+    intptr_t dims[] = {M, N};
+    OIFArrayF64 *Y0 = oif_create_array_f64(2, dims);
+    OIFArrayF64 *Y = oif_create_array_f64(2, dims);
+    intptr_t status_dims[] = {M};
+    OIFArrayF64 *status = oif_create_array_f64(1, status_dims);
+    for (int m = 0; m < M; ++m) {
+        rates[m] = 0.25 * (m + 1);
+        for (int i = 0; i < N; ++i) {
+            Y0->data[m * N + i] = 1.0 + i;
+        }
+    }
+
+    ImplHandle implh = oif_init_impl("ivp_ensemble", "sundials_cvode", 1, 0);
+    ASSERT_GT(implh, 0);
+    ASSERT_EQ(oif_ivp_ensemble_set_integrator(implh, "bdf"), 0);
+    ASSERT_EQ(oif_ivp_ensemble_set_initial_values(implh, Y0, 0.0), 0);
+    ASSERT_EQ(oif_ivp_ensemble_set_rhs_batch_fn(implh, decay_rhs_batch, rates.data()), 0);
+    ASSERT_EQ(oif_ivp_ensemble_set_tolerances(implh, 1e-8, 1e-12), 0);
+
+    const double t = 1.5;
+    ASSERT_EQ(oif_ivp_ensemble_integrate(implh, t, Y, status), 0);
+    for (int m = 0; m < M; ++m) {
+        EXPECT_EQ(status->data[m], 0.0);
+        for (int i = 0; i < N; ++i) {
+            double exact = Y0->data[m * N + i] * exp(-rates[m] * t);
+            EXPECT_NEAR(Y->data[m * N + i], exact, 1e-5 * fabs(exact) + 1e-10);
+        }
+    }
+
+    oif_free_array_f64(status);
+    oif_free_array_f64(Y);
+    oif_free_array_f64(Y0);
+    oif_unload_impl(implh);
+}
@@ -1,3 +1,5 @@
+#include <thread>
+
 #include <gtest/gtest.h>
 
 #include "oif/c_bindings.h"
@@ -173,3 +175,35 @@ TEST(QeqJlQeqSolverTestSuite, ExtremeRoots)
     oif_free_array_f64(roots);
     oif_unload_impl(implh);
 }
+
+// Both threads make their first call concurrently, so that they race
+// on the lazily resolved methods and the shared argument vector.
+TEST(QeqJlQeqSolverTestSuite, SameImplementationFromTwoThreads)
+{
+    ImplHandle implh = oif_init_impl("qeq", "jl_qeq_solver", 1, 0);
+
+    auto solve_many = [implh](double root, int *num_failures) {
+        intptr_t dimensions[] = {
+            2,
+        };
+        OIFArrayF64 *roots = oif_create_array_f64(1, dimensions);
+        for (int i = 0; i < 1000; ++i) {
+            // Roots are `root` and -1.
+            int status = oif_solve_qeq(implh, 1.0, 1.0 - root, -root, roots);
+            if (status != 0 || roots->data[0] != root || roots->data[1] != -1.0) {
+                ++*num_failures;
+            }
+        }
+        oif_free_array_f64(roots);
+    };
+
+    int num_failures[2] = {0, 0};
+    std::thread first(solve_many, 2.0, &num_failures[0]);
+    std::thread second(solve_many, 3.0, &num_failures[1]);
+    first.join();
+    second.join();
+
+    EXPECT_EQ(num_failures[0], 0);
+    EXPECT_EQ(num_failures[1], 0);
+    oif_unload_impl(implh);
+}
@@ -0,0 +1,156 @@
+import ctypes
+import ctypes.util
+import gc
+import os
+import weakref
+
+import numpy as np
+import numpy.testing as npt
+from oif.core import (
+    OIF_ARRAY_F64,
+    OIF_FLOAT64,
+    OIF_INT,
+    OIF_LANG_C,
+    OIF_LANG_PYTHON,
+    OIF_USER_DATA,
+    CFunctionPointer,
+    OIFArrayF64,
+    c_function_address,
+    init_impl,
+    make_oif_callback,
+    unload_impl,
+)
+
+RHS_FN_T = ctypes.CFUNCTYPE(
+    ctypes.c_int,
+    ctypes.c_double,
+    ctypes.POINTER(OIFArrayF64),
+    ctypes.POINTER(OIFArrayF64),
+    ctypes.c_void_p,
+)
+
+
+def _rss_bytes():
+    with open("/proc/self/statm") as f:
+        return int(f.read().split()[1]) * os.sysconf("SC_PAGE_SIZE")
+
+
+def _make_oif_array_f64(arr):
+    dimensions = (ctypes.c_long * arr.ndim)(*arr.shape)
+    data = arr.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
+    return OIFArrayF64(arr.ndim, dimensions, data), dimensions
+
+
+def test_callback__c_function_pointer_invokes_python_callable():
+    calls = []
+
+    def rhs(t, y, ydot, user_data):
+        calls.append((t, user_data))
+        ydot[:] = -t * y
+
+    callback = make_oif_callback(
+        rhs, (OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA), OIF_INT
+    )
+    assert callback.src == OIF_LANG_PYTHON
+
+    y = np.array([1.0, 2.0, 3.0])
+    ydot = np.empty_like(y)
+    oif_y, __ = _make_oif_array_f64(y)
+    oif_ydot, __ = _make_oif_array_f64(ydot)
+    user_data = (12, 2.7)
+
+    fn = RHS_FN_T(callback.fn_p_c)
+    for t in [0.5, 2.0]:
+        status = fn(t, ctypes.byref(oif_y), ctypes.byref(oif_ydot), id(user_data))
+        assert status == 0
+        npt.assert_equal(ydot, -t * y)
+
+    assert calls == [(0.5, user_data), (2.0, user_data)]
+
+
+def test_callback__exception_in_callable_returns_error_status():
+    def rhs(t, y, ydot, __):
+        raise RuntimeError("Intentional error")
+
+    callback = make_oif_callback(
+        rhs, (OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA), OIF_INT
+    )
+    y = np.array([1.0])
+    oif_y, __ = _make_oif_array_f64(y)
+
+    fn = RHS_FN_T(callback.fn_p_c)
+    status = fn(0.0, ctypes.byref(oif_y), ctypes.byref(oif_y), None)
+    assert status != 0
+
+
+def test_callback__reference_cycle_through_callable_is_collected():
+    class Rhs:
+        def __call__(self, t, y, ydot, __):
+            ydot[:] = -y
+
+    rhs = Rhs()
+    # The callable refers to the callback that owns the C wrapper over it.
+    rhs.callback = make_oif_callback(
+        rhs, (OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA), OIF_INT
+    )
+    ref = weakref.ref(rhs)
+    del rhs
+    gc.collect()
+
+    assert ref() is None
+
+
+def test_callback__compiled_function_is_passed_as_c_callback():
+    libm = ctypes.CDLL(ctypes.util.find_library("m"))
+    fn = ctypes.CFUNCTYPE(ctypes.c_double, ctypes.c_double)(("cos", libm))
+    address = ctypes.cast(fn, ctypes.c_void_p).value
+
+    callback = make_oif_callback(fn, (OIF_FLOAT64,), OIF_FLOAT64)
+    assert callback.src == OIF_LANG_C
+    assert callback.fn_p_c == address
+
+    callback = make_oif_callback(CFunctionPointer(address), (OIF_FLOAT64,), OIF_FLOAT64)
+    assert callback.src == OIF_LANG_C
+    assert callback.fn_p_c == address
+
+
+def test_callback__ctypes_thunk_over_python_callable_is_not_compiled():
+    def rhs(t, y, ydot, __):
+        return 0
+
+    fn = RHS_FN_T(rhs)
+    address = ctypes.cast(fn, ctypes.c_void_p).value
+
+    assert c_function_address(fn) is None
+    assert c_function_address(ctypes.cast(fn, RHS_FN_T)) is None
+    # It is still passed as a C function, which acquires the GIL itself.
+    callback = make_oif_callback(
+        fn, (OIF_FLOAT64, OIF_ARRAY_F64, OIF_ARRAY_F64, OIF_USER_DATA), OIF_INT
+    )
+    assert callback.src == OIF_LANG_C
+    assert callback.fn_p_c == address
+
+
+def test_binding_call__rss_stays_flat_without_garbage_collector():
+    binding = init_impl("qeq", "c_qeq_solver", 1, 0)
+    result = np.empty(2)
+
+    for __ in range(1_000):
+        binding.call("solve_qeq", (1.0, 5.0, 4.0), (result,))
+    gc.collect()
+    gc.disable()
+    try:
+        rss_before = _rss_bytes()
+        for __ in range(50_000):
+            binding.call("solve_qeq", (1.0, 5.0, 4.0), (result,))
+        rss_growth = _rss_bytes() - rss_before
+        n_unreachable = gc.collect()
+    finally:
+        gc.enable()
+        unload_impl(binding)
+
+    npt.assert_equal(result, [-4.0, -1.0])
+    # Temporaries of a call must be freed by reference counting alone;
+    # only ctypes array types, created once per array length, are cyclic.
+    assert n_unreachable < 1_000
+    assert rss_growth < 2**20
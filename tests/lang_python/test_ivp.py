@@ -179,6 +179,41 @@ class TestIVP:
         for k in range(1, len(errors)):
             assert errors[k - 1] >= errors[k]
 
+    def test_5__integrate_many_matches_integrate(self, s, p):
+        s.set_initial_value(p.y0, p.t0)
+        s.set_rhs_fn(p.rhs)
+
+        t1 = p.t0 + 1
+        times = np.linspace(p.t0, t1, num=11)[1:]
+        Y = s.integrate_many(times)
+
+        assert Y.shape == (len(times), len(p.y0))
+        npt.assert_allclose(Y[-1], p.exact(t1), rtol=1e-10)
+
+        s.set_initial_value(p.y0, p.t0)
+        for t, y in zip(times, Y):
+            s.integrate(t)
+            npt.assert_allclose(y, s.y, rtol=1e-12)
+
+    def test_6__integrate_one_step_and_interpolate(self, s, p):
+        s.set_initial_value(p.y0, p.t0)
+        s.set_rhs_fn(p.rhs)
+        s.set_tolerances(1e-10, 1e-12)
+
+        t1 = p.t0 + 1
+        t, y = p.t0, p.y0
+        while t < t1:
+            t_prev, y_prev = t, y
+            t = s.integrate_one_step(t1)
+            y = s.y.copy()
+            assert t_prev < t <= t1
+
+        assert t == t1
+        npt.assert_allclose(s.y, p.exact(t1), rtol=1e-6, atol=1e-8)
+        # The interpolant matches the solution at the ends of the last step.
+        npt.assert_allclose(s.interpolate(t), s.y, rtol=1e-10, atol=1e-12)
+        npt.assert_allclose(s.interpolate(t_prev), y_prev, rtol=1e-10, atol=1e-12)
+
     def test_4__check_that_user_data_can_be_used(self, s):
         p = IVPProblemWithUserData()
         s.set_initial_value(list(p.y0), int(p.t0))
@@ -197,6 +232,283 @@ class TestIVP:
         npt.assert_allclose(final_value, true_value, 1e-5, 1e-6)
 
 
+@pytest.mark.parametrize("variant", ["dense", "csr", "jac_times"])
+def test_set_jac_fn__solution_is_correct(s, variant):
+    p = LinearOscillatorProblem()
+    jac_calls = []
+
+    def jac(t, y, J, user_data):
+        jac_calls.append(t)
+        J[:] = [[0.0, 1.0], [-(p.omega**2), 0.0]]
+
+    def jac_csr(t, y, data, user_data):
+        jac_calls.append(t)
+        data[:] = [1.0, -(p.omega**2)]
+
+    def jac_times(t, y, v, Jv, user_data):
+        jac_calls.append(t)
+        Jv[0] = v[1]
+        Jv[1] = -(p.omega**2) * v[0]
+
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+    if variant == "dense":
+        s.set_jac_fn(jac)
+    elif variant == "csr":
+        s.set_jac_csr_fn(jac_csr, indptr=[0, 1, 2], indices=[1, 0])
+    else:
+        s.set_jac_times_fn(jac_times)
+    s.set_tolerances(1e-8, 1e-10)
+
+    t1 = p.t0 + 1
+    s.integrate(t1)
+
+    npt.assert_allclose(s.y, p.exact(t1), rtol=1e-5, atol=1e-6)
+    if s._binding.impl == "sundials_cvode":
+        assert len(jac_calls) > 0
+
+
+@pytest.mark.parametrize(
+    "indptr, indices",
+    [
+        ([1, 1, 2], [0, 1]),
+        ([0, 2, 1], [0]),
+        ([0, 1, 2], [0, 2]),
+        ([0, 1, 2], [-1, 1]),
+    ],
+)
+def test_set_jac_csr_fn__sundials_cvode_invalid_pattern_is_error(indptr, indices):
+    s = IVP("sundials_cvode")
+    p = LinearOscillatorProblem()
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+
+    with pytest.raises(RuntimeError):
+        s.set_jac_csr_fn(lambda t, y, data, user_data: 0, indptr, indices)
+
+
+def test_set_preconditioner__solution_is_correct(s):
+    p = LinearOscillatorProblem()
+    J = np.array([[0.0, 1.0], [-(p.omega**2), 0.0]])
+    setup_calls = []
+    solve_calls = []
+
+    def prec_setup(t, y, jok, gamma, user_data):
+        setup_calls.append(t)
+
+    def prec_solve(t, y, r, z, gamma, delta, user_data):
+        solve_calls.append(t)
+        # The exact preconditioner for the linear problem.
+        z[:] = np.linalg.solve(np.eye(2) - gamma * J, r)
+
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+    s.set_preconditioner(prec_setup, prec_solve)
+    s.set_tolerances(1e-8, 1e-10)
+
+    t1 = p.t0 + 1
+    s.integrate(t1)
+
+    npt.assert_allclose(s.y, p.exact(t1), rtol=1e-5, atol=1e-6)
+    if s._binding.impl == "sundials_cvode":
+        assert len(setup_calls) > 0
+        assert len(solve_calls) > 0
+
+
+def test_set_events__terminal_event_stops_integration(s):
+    p = ScalarExpDecayProblem()
+
+    def event_fn(t, y, g, user_data):
+        g[0] = y[0] - 0.5
+
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+    s.set_tolerances(1e-8, 1e-12)
+    s.set_events(event_fn, [-1.0], [True])
+
+    s.integrate(2.0)
+
+    index, t_event = s.get_last_event()
+    assert index == 0
+    npt.assert_allclose(t_event, np.log(2), rtol=1e-6)
+    npt.assert_allclose(s.y, [0.5], rtol=1e-6)
+
+    # The integration continues after the event.
+    s.integrate(2.0)
+
+    assert s.get_last_event() is None
+    npt.assert_allclose(s.y, p.exact(2.0), rtol=1e-5)
+
+
+def test_set_events__nonterminal_event_is_reported(s):
+    p = LinearOscillatorProblem()
+
+    def event_fn(t, y, g, user_data):
+        g[0] = y[0]
+        # Increases through zero at t = 0.5, but only decreasing crossings count.
+        g[1] = t - 0.5
+
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+    s.set_tolerances(1e-8, 1e-10)
+    s.set_events(event_fn, [0.0, -1.0], [False, False])
+
+    t1 = p.t0 + 1
+    s.integrate(t1)
+
+    # The first zero of y_0(t) = cos(omega t) + 0.5 sin(omega t) / omega.
+    t_zero = (np.pi - np.arctan(2 * p.omega)) / p.omega
+    index, t_event = s.get_last_event()
+    assert index == 0
+    npt.assert_allclose(t_event, t_zero, rtol=1e-5)
+    npt.assert_allclose(s.y, p.exact(t1), rtol=1e-5, atol=1e-6)
+
+
+def test_get_stats__counters_are_reported_and_reset(s):
+    p = ScalarExpDecayProblem()
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+    s.integrate(p.t0 + 1)
+
+    stats = s.get_stats()
+    assert isinstance(stats["num_rhs_evals"], int)
+    assert stats["num_rhs_evals"] > 0
+    assert stats["rhs_time"] >= 0.0
+
+    s.set_initial_value(p.y0, p.t0)
+    assert s.get_stats()["num_rhs_evals"] == 0
+
+
+@pytest.mark.parametrize("integrator_name", ["dopri5", "dop853"])
+def test_set_integrator__dopri5(integrator_name):
+    s = IVP("scipy_ode_dopri5")
+    p = LinearOscillatorProblem()
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+    s.set_integrator(integrator_name)
+    s.set_tolerances(1e-10, 1e-12)
+
+    t1 = p.t0 + 1
+    s.integrate(t1)
+
+    npt.assert_allclose(s.y, p.exact(t1), rtol=1e-8)
+
+
+def test_set_integrator__unknown_name_is_error():
+    s = IVP("scipy_ode_dopri5")
+    p = ScalarExpDecayProblem()
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+
+    with pytest.raises(RuntimeError):
+        s.set_integrator("unknown_integrator")
+
+
+@pytest.mark.parametrize(
+    "integrator_name, options",
+    [
+        ("adams", {}),
+        ("adams", {"nonlinear_solver": "fixed_point", "anderson_depth": 3}),
+        ("bdf", {}),
+        ("bdf", {"nonlinear_solver": "newton", "linear_solver": "dense"}),
+        (
+            "bdf",
+            {"linear_solver": "band", "upper_bandwidth": 1, "lower_bandwidth": 1},
+        ),
+        ("bdf", {"linear_solver": "spgmr", "max_krylov_dim": 2}),
+        ("bdf", {"linear_solver": "spbcgs"}),
+        ("bdf", {"linear_solver": "dense", "num_threads": 1}),
+    ],
+)
+def test_set_option__sundials_cvode(integrator_name, options):
+    s = IVP("sundials_cvode")
+    p = LinearOscillatorProblem()
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+    s.set_tolerances(1e-8, 1e-10)
+    s.set_integrator(integrator_name)
+    for name, value in options.items():
+        s.set_option(name, value)
+
+    t1 = p.t0 + 1
+    s.integrate(t1)
+
+    npt.assert_allclose(s.y, p.exact(t1), rtol=1e-5, atol=1e-6)
+
+
+def test_set_option__sundials_cvode_two_threads_give_serial_solution():
+    s = IVP("sundials_cvode")
+    p = OrbitEquationsProblem()
+    t1 = p.t0 + 1
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+    s.set_tolerances(1e-8, 1e-10)
+    s.set_option("num_threads", 1)
+    s.integrate(t1)
+    y_serial = s.y.copy()
+
+    try:
+        s.set_option("num_threads", 2)
+    except RuntimeError:
+        pytest.skip("Sundials is built without threaded vectors")
+    try:
+        s.set_initial_value(p.y0, p.t0)
+        s.integrate(t1)
+        # Threaded reductions sum in another order, hence not exactly equal.
+        npt.assert_allclose(s.y, y_serial, rtol=0, atol=1e-8)
+    finally:
+        # Restore the default, as the implementation keeps its state across handles.
+        s.set_option("num_threads", 1)
+
+
+@pytest.mark.parametrize(
+    "name, value",
+    [
+        ("unknown_option", 1),
+        ("linear_solver", "unknown_solver"),
+        ("anderson_depth", -1),
+        ("num_threads", 0),
+    ],
+)
+def test_set_option__sundials_cvode_invalid_option_is_error(name, value):
+    s = IVP("sundials_cvode")
+    p = ScalarExpDecayProblem()
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+
+    with pytest.raises(RuntimeError):
+        s.set_option(name, value)
+
+
+@pytest.mark.parametrize("impl", ["sundials_cvode", "jl_diffeq"])
+def test_save_state__integration_resumes_from_saved_state(impl, tmp_path):
+    p = LinearOscillatorProblem()
+    filename = tmp_path / "state.bin"
+    if impl == "jl_diffeq":
+        # The Julia implementation needs Julia with OrdinaryDiffEq installed.
+        try:
+            s = IVP(impl)
+        except RuntimeError:
+            pytest.skip("Julia implementation jl_diffeq is unavailable")
+    else:
+        s = IVP(impl)
+    s.set_initial_value(p.y0, p.t0)
+    s.set_rhs_fn(p.rhs)
+    s.set_tolerances(1e-8, 1e-10)
+    s.integrate(p.t0 + 1)
+    s.save_state(filename)
+    s.integrate(p.t0 + 2)
+    y_expected = s.y.copy()
+
+    # Restart from the initial value and resume from the saved state instead.
+    s.set_initial_value(p.y0, p.t0)
+    s.load_state(filename)
+    s.integrate(p.t0 + 2)
+
+    npt.assert_allclose(s.y, y_expected, rtol=1e-5, atol=1e-6)
+    npt.assert_allclose(s.y, p.exact(p.t0 + 2), rtol=1e-5, atol=1e-6)
+
+
 @pytest.fixture(
     params=[
         "scipy_ode_dopri5",
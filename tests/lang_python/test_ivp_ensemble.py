@@ -0,0 +1,134 @@
+import ctypes
+
+import numpy as np
+import numpy.testing as npt
+import pytest
+from oif.core import OIFArrayF64
+from oif.interfaces.ivp_ensemble import IVPEnsemble
+
+
+class DecayRate:
+    """User data of a member of the ensemble: y' = -k y."""
+
+    def __init__(self, k):
+        self.k = k
+
+
+def rhs(_, y, ydot, user_data):
+    ydot[:] = -user_data.k * y
+
+
+@pytest.fixture
+def s():
+    return IVPEnsemble("sundials_cvode")
+
+
+@pytest.mark.parametrize("integrator_name", ["adams", "bdf"])
+def test_integrate__sundials_cvode_members_are_independent(s, integrator_name):
+    rates = [0.5, 1.0, 2.0, 4.0]
+    Y0 = np.array([[1.0, 2.0], [1.0, -1.0], [3.0, 0.5], [0.0, 1.0]])
+    s.set_integrator(integrator_name)
+    s.set_initial_values(Y0, 0.0)
+    s.set_rhs_fn(rhs)
+    s.set_user_data([DecayRate(k) for k in rates])
+    s.set_tolerances(1e-8, 1e-12)
+
+    for t in [0.5, 1.0, 2.0]:
+        num_failed = s.integrate(t)
+        assert num_failed == 0
+        expected = Y0 * np.exp(-np.array(rates) * t)[:, np.newaxis]
+        npt.assert_allclose(s.Y, expected, rtol=1e-5, atol=1e-10)
+
+
+@pytest.mark.parametrize("integrator_name", ["adams", "bdf"])
+def test_set_rhs_batch_fn__sundials_cvode_solution_is_correct(s, integrator_name):
+    rates = np.array([0.5, 1.0, 2.0, 4.0])
+    Y0 = np.array([[1.0, 2.0], [1.0, -1.0], [3.0, 0.5], [0.0, 1.0]])
+
+    def rhs_batch(t, Y, Ydot, rates):
+        Ydot[:] = -rates[:, np.newaxis] * Y
+
+    s.set_integrator(integrator_name)
+    s.set_initial_values(Y0, 0.0)
+    s.set_rhs_batch_fn(rhs_batch, rates)
+    s.set_tolerances(1e-8, 1e-12)
+
+    for t in [0.5, 1.0, 2.0]:
+        num_failed = s.integrate(t)
+        assert num_failed == 0
+        expected = Y0 * np.exp(-rates * t)[:, np.newaxis]
+        npt.assert_allclose(s.Y, expected, rtol=1e-5, atol=1e-10)
+
+
+def test_integrate__sundials_cvode_failing_member_does_not_stop_others(s):
+    rates = [1.0, np.nan, 2.0]
+    Y0 = np.ones((3, 1))
+    s.set_initial_values(Y0, 0.0)
+    s.set_rhs_fn(lambda t, y, ydot, ud: -1 if np.isnan(ud.k) else rhs(t, y, ydot, ud))
+    s.set_user_data([DecayRate(k) for k in rates])
+
+    num_failed = s.integrate(1.0)
+
+    assert num_failed == 1
+    assert s.status[0] == 0 and s.status[1] != 0 and s.status[2] == 0
+    npt.assert_allclose(s.Y[[0, 2], 0], np.exp([-1.0, -2.0]), rtol=1e-4)
+
+
+def test_set_num_threads__sundials_cvode_python_rhs_requires_one_thread(s):
+    s.set_initial_values(np.ones((2, 1)), 0.0)
+    s.set_rhs_fn(rhs)
+
+    with pytest.raises(ValueError):
+        s.set_num_threads(2)
+
+
+def test_set_rhs_fn__sundials_cvode_ctypes_thunk_runs_on_one_thread(s):
+    rates = [0.5, 1.0, 2.0, 4.0]
+    Y0 = np.ones((4, 1))
+
+    @ctypes.CFUNCTYPE(
+        ctypes.c_int,
+        ctypes.c_double,
+        ctypes.POINTER(OIFArrayF64),
+        ctypes.POINTER(OIFArrayF64),
+        ctypes.c_void_p,
+    )
+    def rhs_thunk(t, y, ydot, user_data):
+        k = ctypes.cast(user_data, ctypes.py_object).value.k
+        ydot.contents.data[0] = -k * y.contents.data[0]
+        return 0
+
+    s.set_initial_values(Y0, 0.0)
+    # Several threads would wait for the GIL held by the calling thread.
+    s.set_rhs_fn(rhs_thunk)
+    s.set_user_data([DecayRate(k) for k in rates])
+    s.set_tolerances(1e-8, 1e-12)
+
+    num_failed = s.integrate(1.0)
+
+    assert num_failed == 0
+    npt.assert_allclose(s.Y[:, 0], np.exp(-np.array(rates)), rtol=1e-5)
+    with pytest.raises(ValueError):
+        s.set_num_threads(2)
+
+
+def test_set_rhs_batch_fn__sundials_cvode_switch_after_integrate_requires_restart(s):
+    rates = np.array([0.5, 1.0])
+    Y0 = np.ones((2, 1))
+
+    def rhs_batch(t, Y, Ydot, rates):
+        Ydot[:] = -rates[:, np.newaxis] * Y
+
+    s.set_initial_values(Y0, 0.0)
+    s.set_rhs_fn(rhs)
+    s.set_user_data([DecayRate(k) for k in rates])
+    assert s.integrate(1.0) == 0
+
+    # The batch system would silently start again from the initial values.
+    with pytest.raises(RuntimeError):
+        s.set_rhs_batch_fn(rhs_batch, rates)
+
+    s.set_initial_values(Y0, 0.0)
+    s.set_rhs_batch_fn(rhs_batch, rates)
+    assert s.integrate(1.0) == 0
+    npt.assert_allclose(s.Y[:, 0], np.exp(-rates), rtol=1e-5)